@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+# Measures the frame capture throughput of a window through the API:
+#
+#   ./scripts/bench-capture.py out/Release/thrust_shell --count 200
+#   ./scripts/bench-capture.py out/Release/thrust_shell --headless \
+#       --format jpeg --size 640x360 --stream 10 --rate 30
+#
+# One-shot captures are issued back to back (captures per second, latency),
+# then frames are streamed for the requested duration (frames per second).
+
+import argparse
+import os
+import sys
+import time
+
+from thrust_client import Client
+
+
+def main():
+  args = parse_args()
+
+  options = {'format': args.format}
+  if args.size:
+    width, height = [int(v) for v in args.size.split('x')]
+    options['size'] = {'width': width, 'height': height}
+
+  client = Client(args.binary)
+  try:
+    window = client.create('window', {
+      'root_url': args.url,
+      'size': {'width': 1024, 'height': 768},
+      'headless': args.headless,
+    })
+    client.call(window, 'show')
+    time.sleep(args.warmup)
+
+    latencies = []
+    sizes = []
+    start = time.time()
+    for i in range(args.count):
+      frame = client.call(window, 'capture', options)
+      latencies.append(frame['time'])
+      sizes.append(frame['size'])
+      os.unlink(frame['path'])
+    elapsed = time.time() - start
+
+    print('capture: {0} frames in {1:.2f}s, {2:.1f} captures/s'.format(
+        args.count, elapsed, args.count / elapsed))
+    print('         latency mean {0:.1f}ms max {1:.1f}ms, '
+          'mean size {2} bytes'.format(sum(latencies) / len(latencies),
+                                       max(latencies),
+                                       sum(sizes) // len(sizes)))
+
+    if args.stream > 0:
+      stream_options = dict(options)
+      stream_options['rate'] = args.rate
+      client.call(window, 'capture_start', stream_options)
+      time.sleep(args.stream)
+      stats = client.call(window, 'capture_stop')
+      frames = [e for e in client.take_events('frame')
+                if 'error' not in e['_event']]
+      print('stream:  {0} frames in {1}s, {2:.1f} frames/s '
+            '(rate {3}, {4} ticks skipped)'.format(
+                len(frames), args.stream, len(frames) / float(args.stream),
+                stats['rate'], stats['skipped']))
+
+    client.call(window, 'close')
+  finally:
+    client.close()
+  return 0
+
+
+def parse_args():
+  parser = argparse.ArgumentParser(description='Benchmark window captures')
+  parser.add_argument('binary', help='The thrust_shell binary')
+  parser.add_argument('--url', default='about:blank',
+                      help='The url to load in the window')
+  parser.add_argument('--count', type=int, default=100,
+                      help='The number of one-shot captures')
+  parser.add_argument('--format', default='png', choices=['png', 'jpeg'])
+  parser.add_argument('--size', help='The frame size (WIDTHxHEIGHT)')
+  parser.add_argument('--headless', action='store_true',
+                      help='Use a headless window')
+  parser.add_argument('--warmup', type=float, default=2.0,
+                      help='Seconds to wait for the page to load')
+  parser.add_argument('--stream', type=int, default=5,
+                      help='Seconds of streaming (0 to skip)')
+  parser.add_argument('--rate', type=int, default=30,
+                      help='The streaming rate')
+  return parser.parse_args()
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+
+# Packs a directory into an archive served by thrust over the app:// scheme
+# (see src/net/app_archive.h for the format):
+#
+#   ./scripts/pack-app.py path/to/app app.pak
+#   thrust_shell --app-archive=app.pak
+#
+# MIME types and ETags are computed here once so that thrust only has to map
+# the archive and parse its index at startup.
+
+import argparse
+import hashlib
+import mimetypes
+import os
+import struct
+import sys
+
+
+MAGIC = b'THRUSTPK'
+VERSION = 1
+
+EXTRA_MIME_TYPES = {
+  '.js': 'application/javascript',
+  '.json': 'application/json',
+  '.svg': 'image/svg+xml',
+  '.woff': 'application/font-woff',
+  '.ttf': 'application/font-sfnt',
+}
+
+
+def main():
+  args = parse_args()
+
+  entries = []
+  for root, dirs, files in os.walk(args.source):
+    dirs.sort()
+    for name in sorted(files):
+      path = os.path.join(root, name)
+      rel = os.path.relpath(path, args.source).replace(os.sep, '/')
+      with open(path, 'rb') as f:
+        data = f.read()
+      entries.append((rel.encode('utf-8'),
+                      mime_type(name).encode('ascii'),
+                      etag(data).encode('ascii'),
+                      data))
+
+  index_size = len(MAGIC) + 8
+  for path, mime, tag, data in entries:
+    index_size += 16 + len(path) + len(mime) + len(tag)
+
+  index = [MAGIC, struct.pack('<II', VERSION, len(entries))]
+  offset = index_size
+  for path, mime, tag, data in entries:
+    index.append(struct.pack('<IIHHHH', offset, len(data),
+                             len(path), len(mime), len(tag), 0))
+    index.append(path + mime + tag)
+    offset += len(data)
+  if offset > 0xffffffff:
+    sys.stderr.write('Archive too large\n')
+    return 1
+
+  with open(args.output, 'wb') as f:
+    f.write(b''.join(index))
+    for path, mime, tag, data in entries:
+      f.write(data)
+
+  print('Packed {0} entries ({1} bytes) into {2}'.format(
+      len(entries), offset, args.output))
+  return 0
+
+
+def mime_type(name):
+  ext = os.path.splitext(name)[1].lower()
+  if ext in EXTRA_MIME_TYPES:
+    return EXTRA_MIME_TYPES[ext]
+  mime, _ = mimetypes.guess_type(name)
+  return mime or 'application/octet-stream'
+
+
+def etag(data):
+  return '"' + hashlib.sha1(data).hexdigest()[:16] + '"'
+
+
+def parse_args():
+  parser = argparse.ArgumentParser(description='Pack an app:// archive')
+  parser.add_argument('source', help='The directory to pack')
+  parser.add_argument('output', help='The archive to write')
+  return parser.parse_args()
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,185 @@
+#!/usr/bin/env python
+
+# Tests the session host cache TTLs against a stub DNS server:
+#
+#   ./scripts/test-dns.py out/Release/thrust_shell
+#
+# The script re-executes itself in new user, network and mount namespaces
+# (`unshare`, no privileges required) where `/etc/resolv.conf` points to a
+# stub DNS server listening on 127.0.0.1:53. Sessions use the built-in DNS
+# client (`dns.async`) and the number of queries received by the stub shows
+# how long each host stayed cached:
+# - a host is cached for the TTL of its records (re-queried once expired),
+# - `ttl_floor` extends the caching of hosts with shorter TTLs.
+
+import argparse
+import os
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from thrust_client import Client, Test
+
+
+NAMESPACE_ENV = 'THRUST_TEST_DNS_NAMESPACE'
+
+TYPE_A = 1
+TYPE_AAAA = 28
+
+
+class StubDNS(object):
+  # Answers A (127.0.0.1) and AAAA (::1) queries for the hosts in |ttls|
+  # with their configured TTL, and counts the queries received per host.
+  def __init__(self, ttls):
+    self.ttls = ttls
+    self.queries = {}
+    self.lock = threading.Lock()
+    self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    self.socket.bind(('127.0.0.1', 53))
+    self.thread = threading.Thread(target=self.serve)
+    self.thread.daemon = True
+    self.thread.start()
+
+  def count(self, host):
+    with self.lock:
+      return self.queries.get(host, 0)
+
+  def serve(self):
+    while True:
+      data, address = self.socket.recvfrom(512)
+      response = self.answer(bytearray(data))
+      if response:
+        self.socket.sendto(bytes(response), address)
+
+  def answer(self, query):
+    id, flags, qdcount = struct.unpack('!HHH', bytes(query[:6]))
+    if qdcount != 1:
+      return None
+    labels = []
+    offset = 12
+    while query[offset]:
+      length = query[offset]
+      labels.append(bytes(query[offset + 1:offset + 1 + length]).decode())
+      offset += 1 + length
+    offset += 1
+    qtype, qclass = struct.unpack('!HH', bytes(query[offset:offset + 4]))
+    question = query[12:offset + 4]
+    host = '.'.join(labels).lower()
+
+    if host not in self.ttls:
+      # NXDOMAIN.
+      return (struct.pack('!HHHHHH', id, 0x8183, 1, 0, 0, 0) +
+              bytes(question))
+    if qtype == TYPE_A:
+      # Only A queries are counted, AAAA ones being optional.
+      with self.lock:
+        self.queries[host] = self.queries.get(host, 0) + 1
+      rdata = bytearray([127, 0, 0, 1])
+    elif qtype == TYPE_AAAA:
+      rdata = bytearray([0] * 15 + [1])
+    else:
+      return (struct.pack('!HHHHHH', id, 0x8180, 1, 0, 0, 0) +
+              bytes(question))
+    answer = struct.pack('!HHHIH', 0xc00c, qtype, qclass,
+                         self.ttls[host], len(rdata)) + bytes(rdata)
+    return (struct.pack('!HHHHHH', id, 0x8180, 1, 1, 0, 0) +
+            bytes(question) + answer)
+
+
+class TTLTest(Test):
+  def __init__(self, client, stub):
+    Test.__init__(self)
+    self.client = client
+    self.stub = stub
+
+  def session(self, ttl_floor=0):
+    dns = {'async': True}
+    if ttl_floor:
+      dns['ttl_floor'] = ttl_floor
+    return self.client.create('session', {'off_the_record': True,
+                                          'dns': dns})
+
+  def resolve(self, session, host):
+    self.client.call(session, 'prefetch_dns', {'hosts': [host]})
+    # Lets the resolution complete and be cached.
+    time.sleep(0.5)
+    return self.stub.count(host)
+
+  def expect(self, name, host, session, at, queries, start):
+    time.sleep(max(0, start + at - time.time()))
+    count = self.resolve(session, host)
+    self.check('{0} after {1}s: {2} queries'.format(name, at, queries),
+               count == queries, '{0} received'.format(count))
+
+  def test_record_ttl(self):
+    # TTL 2s, no floor: cached for 2s, not for 60s.
+    session = self.session()
+    start = time.time()
+    self.expect('record ttl', 'short.test', session, 0, 1, start)
+    self.expect('record ttl', 'short.test', session, 1, 1, start)
+    self.expect('record ttl', 'short.test', session, 3, 2, start)
+
+  def test_ttl_floor(self):
+    # TTL 1s, floor 4s: cached for 4s.
+    session = self.session(ttl_floor=4)
+    start = time.time()
+    self.expect('ttl floor', 'floor.test', session, 0, 1, start)
+    self.expect('ttl floor', 'floor.test', session, 2, 1, start)
+    self.expect('ttl floor', 'floor.test', session, 5, 2, start)
+
+
+def run(args):
+  stub = StubDNS({'short.test': 2, 'floor.test': 1})
+  client = Client(args.binary)
+  try:
+    # The built-in DNS client is only used once the system DNS
+    # configuration is read, getaddrinfo being used until then.
+    time.sleep(args.warmup)
+    test = TTLTest(client, stub)
+    test.test_record_ttl()
+    test.test_ttl_floor()
+  finally:
+    client.close()
+
+  return test.result()
+
+
+def main():
+  args = parse_args()
+  if os.environ.get(NAMESPACE_ENV):
+    return run(args)
+
+  # Loopback is down in a new network namespace and resolv.conf is only
+  # replaced in the new mount namespace.
+  resolv = tempfile.NamedTemporaryFile(mode='w', prefix='thrust-resolv-',
+                                       delete=False)
+  resolv.write('nameserver 127.0.0.1\n')
+  resolv.close()
+  env = dict(os.environ)
+  env[NAMESPACE_ENV] = '1'
+  script = ('ip link set lo up && mount --bind "$0" /etc/resolv.conf && '
+            'exec "$@"')
+  try:
+    return subprocess.call(['unshare', '--user', '--map-root-user',
+                            '--net', '--mount', 'sh', '-c', script,
+                            resolv.name, sys.executable,
+                            os.path.abspath(__file__)] + sys.argv[1:],
+                           env=env)
+  finally:
+    os.unlink(resolv.name)
+
+
+def parse_args():
+  parser = argparse.ArgumentParser(description='Test the host cache TTLs')
+  parser.add_argument('binary', help='The thrust_shell binary')
+  parser.add_argument('--warmup', type=float, default=2.0,
+                      help='Seconds to wait for the DNS configuration')
+  return parser.parse_args()
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,281 @@
+#!/usr/bin/env python
+
+# Tests the session parallel downloads (`download_start`) against a local
+# HTTP server supporting ranges:
+#
+#   ./scripts/test-download.py out/Release/thrust_shell
+#
+# Covers a download split over several ranged connections, the resumption of
+# a cancelled download (only the missing ranges are requested again), the
+# restart of a download whose partial file was truncated, and the fallback to
+# a single non-ranged request for servers not supporting ranges, not
+# reporting the resource size (`bytes 0-0/*`) or sending no validator.
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import shutil
+import sys
+import tempfile
+import threading
+import time
+
+try:
+  from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+  from SocketServer import ThreadingMixIn
+except ImportError:
+  from http.server import BaseHTTPRequestHandler, HTTPServer
+  from socketserver import ThreadingMixIn
+
+from thrust_client import Client, Test
+
+
+MB = 1024 * 1024
+
+
+class Handler(BaseHTTPRequestHandler):
+  # `/ranged/<name>`  ranges with the total size and an ETag
+  # `/unknown/<name>` ranges answered with an unknown total size (`/*`)
+  # `/plain/<name>`   ranges ignored (200 with the whole resource)
+  # `/nocheck/<name>` ranges without ETag nor Last-Modified
+  # Responses are throttled while `server.slow` is set so that downloads can
+  # be interrupted.
+  protocol_version = 'HTTP/1.1'
+
+  def log_message(self, format, *args):
+    pass
+
+  def do_GET(self):
+    match = re.match(r'^/(ranged|unknown|plain|nocheck)/(\w+)$', self.path)
+    body = self.server.files.get(match.group(2)) if match else None
+    if body is None:
+      self.send_error(404)
+      return
+    mode = match.group(1)
+
+    range = self.headers.get('Range')
+    self.server.record(self.path, range)
+    start, end = 0, len(body) - 1
+    ranged = False
+    if range and mode != 'plain':
+      m = re.match(r'^bytes=(\d+)-(\d*)$', range)
+      start = int(m.group(1))
+      if m.group(2):
+        end = min(int(m.group(2)), len(body) - 1)
+      ranged = True
+
+    if ranged:
+      self.send_response(206)
+      total = '*' if mode == 'unknown' else str(len(body))
+      self.send_header('Content-Range',
+                       'bytes {0}-{1}/{2}'.format(start, end, total))
+    else:
+      self.send_response(200)
+    if mode == 'ranged':
+      self.send_header('Accept-Ranges', 'bytes')
+      self.send_header('ETag', '"' + hashlib.md5(body).hexdigest() + '"')
+    self.send_header('Content-Type', 'application/octet-stream')
+    self.send_header('Content-Length', str(end - start + 1))
+    self.end_headers()
+
+    offset = start
+    chunk = 16 * 1024 if self.server.slow else 256 * 1024
+    try:
+      while offset <= end:
+        data = body[offset:min(offset + chunk, end + 1)]
+        self.wfile.write(data)
+        self.server.served(self.path, len(data))
+        offset += len(data)
+        if self.server.slow:
+          time.sleep(0.05)
+    except IOError:
+      pass
+
+
+class Server(ThreadingMixIn, HTTPServer):
+  daemon_threads = True
+
+  def __init__(self, files):
+    HTTPServer.__init__(self, ('127.0.0.1', 0), Handler)
+    self.files = files
+    self.slow = False
+    self.lock = threading.Lock()
+    self.reset()
+
+  def reset(self):
+    with self.lock:
+      self.ranges = {}
+      self.bytes = {}
+
+  def record(self, path, range):
+    with self.lock:
+      self.ranges.setdefault(path, []).append(range)
+
+  def served(self, path, size):
+    with self.lock:
+      self.bytes[path] = self.bytes.get(path, 0) + size
+
+  def url(self, path):
+    return 'http://127.0.0.1:{0}{1}'.format(self.server_address[1], path)
+
+
+class DownloadTest(Test):
+  def __init__(self, client, server, session, dir, timeout):
+    Test.__init__(self)
+    self.client = client
+    self.server = server
+    self.session = session
+    self.dir = dir
+    self.timeout = timeout
+
+  def start(self, path, target, connections=4):
+    return self.client.call(self.session, 'download_start', {
+      'url': self.server.url(path),
+      'path': target,
+      'connections': connections,
+      'min_segment_size': MB,
+    })['id']
+
+  def wait_done(self):
+    return self.client.wait_event(
+        self.session,
+        ['download_complete', 'download_error', 'download_cancelled'],
+        self.timeout)
+
+  def wait_file(self, path):
+    # The state is written on a background sequence.
+    deadline = time.time() + 2
+    while not os.path.exists(path) and time.time() < deadline:
+      time.sleep(0.05)
+    return os.path.exists(path)
+
+  def content(self, target):
+    with open(target, 'rb') as f:
+      return f.read()
+
+  def test_parallel(self):
+    target = os.path.join(self.dir, 'parallel')
+    self.server.reset()
+    self.start('/ranged/big', target)
+    type, event = self.wait_done()
+    self.check('parallel: complete', type == 'download_complete',
+               json.dumps(event))
+    self.check('parallel: content',
+               self.content(target) == self.server.files['big'])
+    ranges = [r for r in self.server.ranges.get('/ranged/big', [])
+              if r and r != 'bytes=0-0']
+    self.check('parallel: ranged connections', len(ranges) >= 4,
+               ', '.join(ranges))
+    self.check('parallel: state removed',
+               not os.path.exists(target + '.tdownload'))
+
+  def interrupt(self, path, target):
+    self.server.reset()
+    self.server.slow = True
+    try:
+      id = self.start(path, target)
+      self.client.wait_event(self.session, ['download_progress'],
+                             self.timeout)
+      self.client.call(self.session, 'download_cancel', {'id': id})
+      return self.wait_done()
+    finally:
+      self.server.slow = False
+
+  def test_resume(self):
+    target = os.path.join(self.dir, 'resume')
+    size = len(self.server.files['slow'])
+    type, event = self.interrupt('/ranged/slow', target)
+    self.check('resume: cancelled', type == 'download_cancelled' and
+               event.get('resumable') is True, json.dumps(event))
+    self.check('resume: state saved', self.wait_file(target + '.tdownload'))
+
+    self.server.reset()
+    self.start('/ranged/slow', target)
+    type, event = self.wait_done()
+    self.check('resume: complete', type == 'download_complete',
+               json.dumps(event))
+    self.check('resume: content',
+               self.content(target) == self.server.files['slow'])
+    served = self.server.bytes.get('/ranged/slow', 0)
+    self.check('resume: missing ranges only', served < size,
+               '{0} of {1} bytes served'.format(served, size))
+
+  def test_truncated(self):
+    target = os.path.join(self.dir, 'truncated')
+    size = len(self.server.files['slow'])
+    self.interrupt('/ranged/slow', target)
+    with open(target, 'wb'):
+      pass
+
+    self.server.reset()
+    self.start('/ranged/slow', target)
+    type, event = self.wait_done()
+    self.check('truncated: complete', type == 'download_complete',
+               json.dumps(event))
+    self.check('truncated: content',
+               self.content(target) == self.server.files['slow'])
+    served = self.server.bytes.get('/ranged/slow', 0)
+    self.check('truncated: started over', served >= size,
+               '{0} of {1} bytes served'.format(served, size))
+
+  def test_fallback(self, mode):
+    name = '{0}: '.format(mode)
+    target = os.path.join(self.dir, mode)
+    path = '/{0}/small'.format(mode)
+    self.server.reset()
+    self.start(path, target)
+    type, event = self.wait_done()
+    self.check(name + 'complete', type == 'download_complete',
+               json.dumps(event))
+    self.check(name + 'content',
+               self.content(target) == self.server.files['small'])
+    ranges = self.server.ranges.get(path, [])
+    self.check(name + 'single non-ranged request',
+               ranges[1:] == [None], repr(ranges))
+
+
+def main():
+  args = parse_args()
+
+  files = {
+    'big': os.urandom(8 * MB),
+    'slow': os.urandom(4 * MB),
+    'small': os.urandom(MB + 123),
+  }
+  server = Server(files)
+  thread = threading.Thread(target=server.serve_forever)
+  thread.daemon = True
+  thread.start()
+
+  dir = tempfile.mkdtemp(prefix='thrust-download-')
+  client = Client(args.binary)
+  try:
+    # No window is created: downloads must not depend on one.
+    session = client.create('session', {'off_the_record': True})
+    test = DownloadTest(client, server, session, dir, args.timeout)
+    test.test_parallel()
+    test.test_resume()
+    test.test_truncated()
+    test.test_fallback('unknown')
+    test.test_fallback('plain')
+    test.test_fallback('nocheck')
+  finally:
+    client.close()
+    server.shutdown()
+    shutil.rmtree(dir)
+
+  return test.result()
+
+
+def parse_args():
+  parser = argparse.ArgumentParser(description='Test parallel downloads')
+  parser.add_argument('binary', help='The thrust_shell binary')
+  parser.add_argument('--timeout', type=float, default=60.0,
+                      help='Seconds to wait for each download event')
+  return parser.parse_args()
+
+
+if __name__ == '__main__':
+  sys.exit(main())
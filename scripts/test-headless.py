@@ -0,0 +1,155 @@
+#!/usr/bin/env python
+
+# Checks that headless windows produce capturable frames:
+#
+#   ./scripts/test-headless.py out/Release/thrust_shell
+#
+# Headless windows have no widget but their compositor still draws to an
+# unmapped X window on Linux. When no DISPLAY is set the script re-executes
+# itself under `xvfb-run`.
+#
+# A headless window loads a page filled with a known color, then one-shot
+# captures and a capture stream must return frames of the window size whose
+# pixels have that color, also after the window went through the background.
+
+import argparse
+import os
+import struct
+import subprocess
+import sys
+import time
+import zlib
+
+from thrust_client import Client, Test
+
+
+COLOR = (255, 64, 0)
+PAGE = ('data:text/html,<body style="margin:0;'
+        'background:rgb({0},{1},{2})"></body>').format(*COLOR)
+WIDTH = 320
+HEIGHT = 240
+
+
+def read_png(path):
+  # Decodes the 8-bit RGB(A) non-interlaced PNGs written by the capture.
+  with open(path, 'rb') as f:
+    data = f.read()
+  if data[:8] != b'\x89PNG\r\n\x1a\n':
+    raise ValueError('not a PNG file')
+  offset = 8
+  idat = b''
+  while offset < len(data):
+    length, type = struct.unpack('!I4s', data[offset:offset + 8])
+    chunk = data[offset + 8:offset + 8 + length]
+    if type == b'IHDR':
+      width, height, depth, color = struct.unpack('!IIBB', chunk[:10])
+    elif type == b'IDAT':
+      idat += chunk
+    offset += 12 + length
+  if depth != 8 or color not in (2, 6):
+    raise ValueError('unsupported PNG format')
+  bpp = 4 if color == 6 else 3
+  raw = bytearray(zlib.decompress(idat))
+  stride = width * bpp
+  rows = []
+  prev = bytearray(stride)
+  for y in range(height):
+    filter = raw[y * (stride + 1)]
+    row = raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)]
+    for x in range(stride):
+      a = row[x - bpp] if x >= bpp else 0
+      b = prev[x]
+      c = prev[x - bpp] if x >= bpp else 0
+      if filter == 1:
+        row[x] = (row[x] + a) & 0xff
+      elif filter == 2:
+        row[x] = (row[x] + b) & 0xff
+      elif filter == 3:
+        row[x] = (row[x] + (a + b) // 2) & 0xff
+      elif filter == 4:
+        p = a + b - c
+        pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+        pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+        row[x] = (row[x] + pred) & 0xff
+    rows.append(row)
+    prev = row
+  return width, height, bpp, rows
+
+
+class HeadlessTest(Test):
+  def __init__(self, client):
+    Test.__init__(self)
+    self.client = client
+
+  def check_frame(self, name, frame, owned=True):
+    try:
+      width, height, bpp, rows = read_png(frame['path'])
+    finally:
+      if owned:
+        os.unlink(frame['path'])
+    self.check(name + ': size', (width, height) == (WIDTH, HEIGHT),
+               '{0}x{1}'.format(width, height))
+    pixel = tuple(rows[height // 2][(width // 2) * bpp:
+                                    (width // 2) * bpp + 3])
+    self.check(name + ': content',
+               all(abs(p - c) <= 2 for p, c in zip(pixel, COLOR)),
+               'center pixel {0}'.format(pixel))
+
+  def run(self, warmup):
+    window = self.client.create('window', {
+      'root_url': PAGE,
+      'size': {'width': WIDTH, 'height': HEIGHT},
+      'headless': True,
+    })
+    time.sleep(warmup)
+
+    self.check_frame('capture', self.client.call(window, 'capture'))
+
+    self.client.call(window, 'set_background', {'background': True})
+    self.client.call(window, 'set_background', {'background': False})
+    time.sleep(0.5)
+    self.check_frame('capture after background',
+                     self.client.call(window, 'capture'))
+
+    self.client.call(window, 'capture_start', {'rate': 10})
+    time.sleep(2)
+    frames = [e['_event'] for e in self.client.take_events('frame')
+              if 'error' not in e['_event']]
+    self.check('stream: frames', len(frames) >= 5,
+               '{0} frames'.format(len(frames)))
+    if frames:
+      # Slot files belong to the stream and are deleted with it. A slot
+      # overwritten meanwhile is replaced atomically by a later frame.
+      self.check_frame('stream', frames[-1], owned=False)
+    self.client.call(window, 'capture_stop')
+
+    self.client.call(window, 'close')
+
+
+def main():
+  args = parse_args()
+  if sys.platform.startswith('linux') and not os.environ.get('DISPLAY'):
+    return subprocess.call(['xvfb-run', '-a', sys.executable,
+                            os.path.abspath(__file__)] + sys.argv[1:])
+
+  client = Client(args.binary)
+  try:
+    test = HeadlessTest(client)
+    test.run(args.warmup)
+  finally:
+    client.close()
+
+  return test.result()
+
+
+def parse_args():
+  parser = argparse.ArgumentParser(
+      description='Test that headless windows produce capturable frames')
+  parser.add_argument('binary', help='The thrust_shell binary')
+  parser.add_argument('--warmup', type=float, default=2.0,
+                      help='Seconds to wait for the page to load')
+  return parser.parse_args()
+
+
+if __name__ == '__main__':
+  sys.exit(main())
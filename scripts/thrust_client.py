@@ -0,0 +1,111 @@
+# Client for the thrust_shell stdin/stdout API shared by the test and bench
+# scripts:
+#
+#   from thrust_client import Client, Test
+#
+# `Client` runs the binary and exchanges JSON actions with it; replies are
+# matched to their requests and events are queued until taken. `Test` counts
+# the failed checks of a test script.
+
+import json
+import subprocess
+import threading
+import time
+
+
+BOUNDARY = '--(Foo)++__THRUST_SHELL_BOUNDARY__++(Bar)--'
+
+
+class Client(object):
+  def __init__(self, binary):
+    self.process = subprocess.Popen([binary],
+                                    stdin=subprocess.PIPE,
+                                    stdout=subprocess.PIPE,
+                                    universal_newlines=True)
+    self.next_id = 0
+    self.replies = {}
+    self.events = []
+    self.cond = threading.Condition()
+    self.reader = threading.Thread(target=self.read)
+    self.reader.daemon = True
+    self.reader.start()
+
+  def read(self):
+    buf = []
+    for line in iter(self.process.stdout.readline, ''):
+      if line.strip() != BOUNDARY:
+        buf.append(line)
+        continue
+      action = json.loads(''.join(buf))
+      buf = []
+      with self.cond:
+        if action['_action'] == 'reply':
+          self.replies[action['_id']] = action
+        elif action['_action'] == 'event':
+          self.events.append(action)
+        self.cond.notify_all()
+
+  def send(self, action):
+    self.next_id += 1
+    action['_id'] = self.next_id
+    self.process.stdin.write(json.dumps(action) + '\n' + BOUNDARY + '\n')
+    self.process.stdin.flush()
+    with self.cond:
+      while self.next_id not in self.replies:
+        self.cond.wait()
+      reply = self.replies.pop(self.next_id)
+    if reply.get('_error'):
+      raise RuntimeError(reply['_error'])
+    return reply['_result']
+
+  def create(self, type, args):
+    return self.send({'_action': 'create', '_type': type,
+                      '_args': args})['_target']
+
+  def call(self, target, method, args=None):
+    return self.send({'_action': 'call', '_target': target,
+                      '_method': method, '_args': args or {}})
+
+  def take_events(self, type):
+    # Returns and removes the queued events of |type|.
+    with self.cond:
+      taken = [e for e in self.events if e['_type'] == type]
+      self.events = [e for e in self.events if e['_type'] != type]
+    return taken
+
+  def wait_event(self, target, types, timeout):
+    # Returns and removes the first event of |target| of one of |types|,
+    # waiting at most |timeout| seconds for it.
+    deadline = time.time() + timeout
+    with self.cond:
+      while True:
+        for e in self.events:
+          if e['_target'] == target and e['_type'] in types:
+            self.events.remove(e)
+            return e['_type'], e['_event']
+        remaining = deadline - time.time()
+        if remaining <= 0:
+          raise RuntimeError('timeout waiting for ' + ', '.join(types))
+        self.cond.wait(remaining)
+
+  def close(self):
+    self.process.stdin.close()
+    self.process.terminate()
+
+
+class Test(object):
+  def __init__(self):
+    self.failures = 0
+
+  def check(self, name, condition, detail=''):
+    print('{0} {1}{2}'.format('ok  ' if condition else 'FAIL', name,
+                              (': ' + detail) if detail else ''))
+    if not condition:
+      self.failures += 1
+
+  def result(self):
+    # Returns the exit status of the script.
+    if self.failures:
+      print('{0} check(s) failed'.format(self.failures))
+      return 1
+    return 0
@@ -50,7 +50,8 @@ API::InstallBinding(
 int
 API::Create(
     const std::string type,
-    scoped_ptr<base::DictionaryValue> args)
+    scoped_ptr<base::DictionaryValue> args,
+    base::TimeTicks received)
 {
   int target = 0;
   if(type.length() > 0 && factories_[type]) {
@@ -58,7 +59,9 @@ API::Create(
     /* trigger the creation of a local object.                           */
     target = ++next_binding_id_;
     LOG(INFO) << "[API] CREATE: " << type << " " << target;
+    create_received_ = received;
     bindings_[target] = factories_[type]->Create(target, args.Pass());
+    create_received_ = base::TimeTicks();
   }
   return target;
 }
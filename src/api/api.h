@@ -9,6 +9,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/callback.h"
+#include "base/time/time.h"
 
 namespace base {
 class Thread;
@@ -49,8 +50,20 @@ public:
   // ### Create
   // 
   // Creates a new object and return its `_target` id
+  // ```
+  // @type     {string} the binding type
+  // @args     {DictionaryValue} the constructor arguments
+  // @received {TimeTicks} the time the create action was received
+  // ```
   int Create(const std::string type,
-             scoped_ptr<base::DictionaryValue> args);
+             scoped_ptr<base::DictionaryValue> args,
+             base::TimeTicks received);
+
+  // ### create_received
+  //
+  // The time the create action being performed was received, only valid
+  // while a binding factory is called (null otherwise)
+  base::TimeTicks create_received() const { return create_received_; }
 
   // ### Delete
   // 
@@ -90,6 +103,7 @@ private:
 
   static API*                                         self_;
   unsigned int                                        next_binding_id_;
+  base::TimeTicks                                     create_received_;
 
   std::map<std::string, APIBindingFactory*>           factories_;
   std::map<unsigned int, scoped_refptr<APIBinding> >  bindings_;
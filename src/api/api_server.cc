@@ -125,10 +125,11 @@ APIServer::Client::ProcessChunk(
     action.reset(
         static_cast<base::DictionaryValue*>(base::JSONReader::Read(raw)));
 
+    /* The reception time is the origin of the creation timelines. */
     BrowserThread::PostTask(
         BrowserThread::UI, FROM_HERE,
         base::Bind(&APIServer::Client::PerformAction, this, 
-          base::Passed(action.Pass())));
+          base::Passed(action.Pass()), base::TimeTicks::Now()));
   }
 }
 
@@ -147,7 +148,8 @@ APIServer::Client::ReplyToAction(
 
 void
 APIServer::Client::PerformAction(
-    scoped_ptr<base::DictionaryValue> _action)
+    scoped_ptr<base::DictionaryValue> _action,
+    base::TimeTicks received)
 {
   /* Runs on UI Thread. */
 
@@ -203,7 +205,7 @@ APIServer::Client::PerformAction(
   */
 
   if(action.compare("create") == 0 && type.length()) {
-    unsigned int target = api_->Create(type, args.Pass());
+    unsigned int target = api_->Create(type, args.Pass(), received);
     remotes_[target] = new Remote(this, target);
     api_->SetRemote(target, remotes_[target].get());
 
@@ -67,7 +67,8 @@ public:
     };
 
   private:
-    void PerformAction(scoped_ptr<base::DictionaryValue> action);
+    void PerformAction(scoped_ptr<base::DictionaryValue> action,
+                       base::TimeTicks received);
 
     void SendReply(const unsigned id,
                    const std::string& error,
@@ -3,11 +3,16 @@
 
 #include "src/api/thrust_session_binding.h"
 
+#include <algorithm>
+
+#include "base/base64.h"
+#include "base/bind.h"
 #include "base/time/time.h"
 #include "url/gurl.h"
 #include "net/cookies/cookie_util.h"
 #include "content/public/browser/browser_thread.h"
 
+#include "src/browser/browser_main_parts.h"
 #include "src/browser/session/thrust_session.h"
 #include "src/browser/session/thrust_session_proxy_config_service.h"
 
@@ -89,6 +94,40 @@ CanonicalCookieFromValue(
   return cc;
 }
 
+bool
+HeaderRuleSpecFromValue(
+    base::DictionaryValue* rule_v,
+    thrust_shell::ThrustShellHeaderRules::Spec* spec)
+{
+  typedef thrust_shell::ThrustShellHeaderRules Rules;
+
+  std::string phase = "request";
+  std::string action = "set";
+  rule_v->GetString("phase", &phase);
+  rule_v->GetString("action", &action);
+  rule_v->GetString("name", &spec->name);
+  rule_v->GetString("value", &spec->value);
+  rule_v->GetString("url", &spec->url);
+
+  if(phase.compare("request") == 0)
+    spec->phase = Rules::PHASE_REQUEST;
+  else if(phase.compare("response") == 0)
+    spec->phase = Rules::PHASE_RESPONSE;
+  else
+    return false;
+
+  if(action.compare("set") == 0)
+    spec->operation = Rules::OPERATION_SET;
+  else if(action.compare("append") == 0)
+    spec->operation = Rules::OPERATION_APPEND;
+  else if(action.compare("remove") == 0)
+    spec->operation = Rules::OPERATION_REMOVE;
+  else
+    return false;
+
+  return true;
+}
+
 }
 
 namespace thrust_shell {
@@ -112,7 +151,8 @@ APIBinding* ThrustSessionBindingFactory::Create(
 ThrustSessionBinding::ThrustSessionBinding(
     const unsigned int id, 
     scoped_ptr<base::DictionaryValue> args)
-  : APIBinding("session", id)
+  : APIBinding("session", id),
+    weak_ptr_factory_(this)
 {
   LOG(INFO) << "ThrustSessionBinding Constructor [" << this << "] " << id_;
 
@@ -129,7 +169,32 @@ ThrustSessionBinding::ThrustSessionBinding(
                                    off_the_record, 
                                    path, 
                                    !cookie_store));
+
+  base::DictionaryValue* dns = NULL;
+  if(args->GetDictionary("dns", &dns)) {
+    ThrustShellHostResolver::Options options;
+    int cache_size = 0;
+    int ttl_floor = 0;
+    dns->GetBoolean("async", &options.async_dns);
+    if(dns->GetInteger("cache_size", &cache_size) && cache_size > 0) {
+      options.cache_size = cache_size;
+    }
+    if(dns->GetInteger("ttl_floor", &ttl_floor) && ttl_floor > 0) {
+      options.ttl_floor = base::TimeDelta::FromSeconds(ttl_floor);
+    }
+    session_->SetHostResolverOptions(options);
+  }
   session_->Initialize();
+
+  base::DictionaryValue* prewarm = NULL;
+  if(args->GetDictionary("prewarm", &prewarm)) {
+    int windows = 0;
+    int guests = 0;
+    prewarm->GetInteger("windows", &windows);
+    prewarm->GetInteger("guests", &guests);
+    session_->GetWebContentsPool()->SetSize(std::max(windows, 0),
+                                            std::max(guests, 0));
+  }
 }
 
 ThrustSessionBinding::~ThrustSessionBinding()
@@ -154,17 +219,83 @@ ThrustSessionBinding::CallLocalMethod(
     args->GetString("url", &url);
     session_->GetVisitedLinkStore()->Add(url);
   }
+  else if(method.compare("visitedlink_add_batch") == 0 ||
+          method.compare("visitedlink_is_visited_batch") == 0) {
+    std::vector<std::string> urls;
+    base::ListValue* list = NULL;
+    if(args->GetList("urls", &list)) {
+      urls.reserve(list->GetSize());
+      for(size_t i = 0; i < list->GetSize(); i++) {
+        std::string url;
+        if(list->GetString(i, &url)) {
+          urls.push_back(url);
+        }
+      }
+    }
+    /* Both methods reply asynchronously once the URLs have been processed */
+    /* off the UI thread.                                                   */
+    delete res;
+    if(method.compare("visitedlink_add_batch") == 0) {
+      session_->GetVisitedLinkStore()->AddBatch(
+          urls,
+          base::Bind(&ThrustSessionBinding::VisitedLinkAddBatchCallback,
+                     this, callback, urls.size()));
+    }
+    else {
+      session_->GetVisitedLinkStore()->IsVisitedBatch(
+          urls,
+          base::Bind(&ThrustSessionBinding::VisitedLinkIsVisitedBatchCallback,
+                     this, callback));
+    }
+    return;
+  }
   else if(method.compare("visitedlink_clear") == 0) {
     session_->GetVisitedLinkStore()->Clear();
   }
   else if(method.compare("proxy_set") == 0) {
     std::string rules = "";
+    std::string pac_url = "";
+    std::string pac_script = "";
+    int cache_ttl = -1;
     args->GetString("rules", &rules);
-    ThrustSessionProxyConfigService* proxy_config_service = 
-      session_->GetProxyConfigService();
-    if(proxy_config_service != NULL) {
-      proxy_config_service->SetProxyRules(rules);
+    args->GetString("pac_url", &pac_url);
+    args->GetString("pac_script", &pac_script);
+    args->GetInteger("cache_ttl", &cache_ttl);
+    /* Inline scripts are served to the proxy script fetcher as data URLs. */
+    if(!pac_script.empty()) {
+      std::string encoded;
+      base::Base64Encode(pac_script, &encoded);
+      pac_url = "data:application/x-ns-proxy-autoconfig;base64," + encoded;
+    }
+    GURL pac_gurl(pac_url);
+    if(!pac_url.empty() && !pac_gurl.is_valid()) {
+      err = "exo_session_binding:invalid_pac_url";
     }
+    else {
+      if(cache_ttl >= 0) {
+        session_->SetProxyCacheTTL(base::TimeDelta::FromSeconds(cache_ttl));
+      }
+      ThrustSessionProxyConfigService* proxy_config_service = 
+        session_->GetProxyConfigService();
+      if(proxy_config_service != NULL) {
+        if(!pac_url.empty()) {
+          proxy_config_service->SetPacURL(pac_gurl);
+        }
+        else {
+          proxy_config_service->SetProxyRules(rules);
+        }
+      }
+    }
+  }
+  else if(method.compare("proxy_stats") == 0) {
+    bool reset = false;
+    args->GetBoolean("reset", &reset);
+    /* Statistics live on the IO thread. */
+    delete res;
+    session_->GetProxyStats(
+        reset,
+        base::Bind(&ThrustSessionBinding::NetStatsCallback, this, callback));
+    return;
   }
   else if(method.compare("proxy_clear") == 0) {
     ThrustSessionProxyConfigService* proxy_config_service = 
@@ -173,6 +304,192 @@ ThrustSessionBinding::CallLocalMethod(
       proxy_config_service->ClearProxyRules();
     }
   }
+  else if(method.compare("url_rules_set") == 0) {
+    std::vector<std::string> rules;
+    base::ListValue* list = NULL;
+    if(args->GetList("rules", &list)) {
+      rules.reserve(list->GetSize());
+      for(size_t i = 0; i < list->GetSize(); i++) {
+        std::string rule;
+        if(list->GetString(i, &rule)) {
+          rules.push_back(rule);
+        }
+      }
+    }
+    /* Replies once the rules are compiled and installed. */
+    delete res;
+    session_->SetURLRules(
+        rules,
+        base::Bind(&ThrustSessionBinding::URLRulesSetCallback,
+                   this, callback));
+    return;
+  }
+  else if(method.compare("url_rules_clear") == 0) {
+    session_->ClearURLRules();
+  }
+  else if(method.compare("header_rules_set") == 0) {
+    std::vector<ThrustShellHeaderRules::Spec> specs;
+    base::ListValue* list = NULL;
+    if(args->GetList("rules", &list)) {
+      for(size_t i = 0; i < list->GetSize() && err.empty(); i++) {
+        base::DictionaryValue* rule_v = NULL;
+        ThrustShellHeaderRules::Spec spec;
+        if(!list->GetDictionary(i, &rule_v) ||
+           !HeaderRuleSpecFromValue(rule_v, &spec)) {
+          err = "exo_session_binding:invalid_header_rule";
+        }
+        specs.push_back(spec);
+      }
+    }
+    if(err.empty()) {
+      session_->SetHeaderRules(specs);
+      res->SetInteger("count", specs.size());
+    }
+  }
+  else if(method.compare("header_rules_clear") == 0) {
+    session_->SetHeaderRules(std::vector<ThrustShellHeaderRules::Spec>());
+  }
+  else if(method.compare("header_rules_stats") == 0) {
+    /* Counters live on the IO thread. */
+    delete res;
+    session_->GetHeaderRulesCounters(
+        base::Bind(&ThrustSessionBinding::HeaderRulesStatsCallback,
+                   this, callback));
+    return;
+  }
+  else if(method.compare("net_stats") == 0) {
+    std::string host = "";
+    bool reset = false;
+    args->GetString("host", &host);
+    args->GetBoolean("reset", &reset);
+    /* Statistics live on the IO thread. */
+    delete res;
+    session_->GetNetStats(
+        host, reset,
+        base::Bind(&ThrustSessionBinding::NetStatsCallback, this, callback));
+    return;
+  }
+  else if(method.compare("net_stats_stream") == 0) {
+    int interval = 0;
+    args->GetInteger("interval", &interval);
+    net_stats_timer_.Stop();
+    if(interval > 0) {
+      net_stats_timer_.Start(FROM_HERE,
+                             base::TimeDelta::FromMilliseconds(interval),
+                             this,
+                             &ThrustSessionBinding::NetStatsTick);
+    }
+  }
+  else if(method.compare("dns_stats") == 0) {
+    bool reset = false;
+    args->GetBoolean("reset", &reset);
+    /* Statistics live on the IO thread. */
+    delete res;
+    session_->GetDNSStats(
+        reset,
+        base::Bind(&ThrustSessionBinding::NetStatsCallback, this, callback));
+    return;
+  }
+  else if(method.compare("netlog_dump") == 0) {
+    std::string path = "";
+    int seconds = 0;
+    args->GetString("path", &path);
+    args->GetInteger("seconds", &seconds);
+    if(path.empty()) {
+      err = "exo_session_binding:invalid_path";
+    }
+    else {
+      /* Replies once the file is written. */
+      delete res;
+      ThrustShellMainParts::Get()->net_log()->Dump(
+          base::FilePath::FromUTF8Unsafe(path),
+          base::TimeDelta::FromSeconds(seconds),
+          base::Bind(&ThrustSessionBinding::NetLogDumpCallback,
+                     this, callback));
+      return;
+    }
+  }
+  else if(method.compare("preconnect") == 0) {
+    std::string url = "";
+    int count = 1;
+    args->GetString("url", &url);
+    args->GetInteger("count", &count);
+    GURL gurl(url);
+    if(!gurl.is_valid() || !gurl.SchemeIsHTTPOrHTTPS()) {
+      err = "exo_session_binding:invalid_url";
+    }
+    else {
+      session_->Preconnect(gurl, count);
+    }
+  }
+  else if(method.compare("prefetch_dns") == 0) {
+    std::vector<std::string> hosts;
+    base::ListValue* list = NULL;
+    if(args->GetList("hosts", &list)) {
+      hosts.reserve(list->GetSize());
+      for(size_t i = 0; i < list->GetSize(); i++) {
+        std::string host;
+        if(list->GetString(i, &host)) {
+          hosts.push_back(host);
+        }
+      }
+    }
+    /* Replies once the resolutions are started on the IO thread. */
+    delete res;
+    session_->PrefetchDNS(
+        hosts,
+        base::Bind(&ThrustSessionBinding::PrefetchDNSCallback,
+                   this, callback));
+    return;
+  }
+  else if(method.compare("download_start") == 0) {
+    std::string url = "";
+    std::string path = "";
+    ThrustShellParallelDownloader::Options options;
+    double min_segment_size = 0;
+    args->GetString("url", &url);
+    args->GetString("path", &path);
+    args->GetInteger("connections", &options.connections);
+    if(args->GetDouble("min_segment_size", &min_segment_size) &&
+       min_segment_size > 0) {
+      options.min_segment_size = min_segment_size;
+    }
+    GURL gurl(url);
+    if(!gurl.is_valid() || !gurl.SchemeIsHTTPOrHTTPS()) {
+      err = "exo_session_binding:invalid_url";
+    }
+    else if(path.empty()) {
+      err = "exo_session_binding:invalid_path";
+    }
+    else {
+      int id = session_->StartDownload(
+          gurl, base::FilePath::FromUTF8Unsafe(path), options,
+          base::Bind(&ThrustSessionBinding::DownloadEventEmit,
+                     weak_ptr_factory_.GetWeakPtr()));
+      res->SetInteger("id", id);
+    }
+  }
+  else if(method.compare("download_cancel") == 0) {
+    int id = 0;
+    args->GetInteger("id", &id);
+    session_->CancelDownload(id);
+  }
+  else if(method.compare("prewarm_set") == 0) {
+    int windows = 0;
+    int guests = 0;
+    args->GetInteger("windows", &windows);
+    args->GetInteger("guests", &guests);
+    session_->GetWebContentsPool()->SetSize(std::max(windows, 0),
+                                            std::max(guests, 0));
+  }
+  else if(method.compare("prewarm_stats") == 0) {
+    res->MergeDictionary(session_->GetWebContentsPool()->GetStats().get());
+  }
+  else if(method.compare("timing_stats") == 0) {
+    bool reset = false;
+    args->GetBoolean("reset", &reset);
+    res->MergeDictionary(session_->GetCreateTimings(reset).get());
+  }
   else if(method.compare("is_off_the_record") == 0) {
     res->SetBoolean("off_the_record", session_->IsOffTheRecord());
   }
@@ -183,6 +500,133 @@ ThrustSessionBinding::CallLocalMethod(
   callback.Run(err, scoped_ptr<base::DictionaryValue>(res).Pass());
 }
 
+void
+ThrustSessionBinding::VisitedLinkAddBatchCallback(
+    const API::MethodCallback& callback,
+    size_t count)
+{
+  /* Runs on UI thread. */
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->SetInteger("count", count);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::VisitedLinkIsVisitedBatchCallback(
+    const API::MethodCallback& callback,
+    const std::vector<bool>& visited)
+{
+  /* Runs on UI thread. */
+  base::ListValue* visited_v = new base::ListValue;
+  for(size_t i = 0; i < visited.size(); i++) {
+    visited_v->AppendBoolean(visited[i]);
+  }
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->Set("visited", visited_v);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::URLRulesSetCallback(
+    const API::MethodCallback& callback,
+    size_t count,
+    size_t ignored)
+{
+  /* Runs on UI thread. */
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->SetInteger("count", count);
+  res->SetInteger("ignored", ignored);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::HeaderRulesStatsCallback(
+    const API::MethodCallback& callback,
+    const std::vector<ThrustShellHeaderRules::Counters>& counters)
+{
+  /* Runs on UI thread. */
+  base::ListValue* rules_v = new base::ListValue;
+  double matched = 0;
+  double applied = 0;
+  for(size_t i = 0; i < counters.size(); i++) {
+    base::DictionaryValue* rule_v = new base::DictionaryValue;
+    rule_v->SetDouble("matched", counters[i].matched);
+    rule_v->SetDouble("applied", counters[i].applied);
+    rules_v->Append(rule_v);
+    matched += counters[i].matched;
+    applied += counters[i].applied;
+  }
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->Set("rules", rules_v);
+  res->SetDouble("matched", matched);
+  res->SetDouble("applied", applied);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::NetStatsCallback(
+    const API::MethodCallback& callback,
+    scoped_ptr<base::DictionaryValue> stats)
+{
+  /* Runs on UI thread. */
+  callback.Run(std::string(""), stats.Pass());
+}
+
+void
+ThrustSessionBinding::NetStatsTick()
+{
+  /* Runs on UI thread. */
+  session_->GetNetStats(
+      std::string(), false,
+      base::Bind(&ThrustSessionBinding::NetStatsEmit, this));
+}
+
+void
+ThrustSessionBinding::NetStatsEmit(
+    scoped_ptr<base::DictionaryValue> stats)
+{
+  /* Runs on UI thread. */
+  this->EmitEvent("net_stats", stats.Pass());
+}
+
+void
+ThrustSessionBinding::NetLogDumpCallback(
+    const API::MethodCallback& callback,
+    bool ok,
+    size_t count)
+{
+  /* Runs on UI thread. */
+  if(!ok) {
+    callback.Run(std::string("exo_session_binding:netlog_dump_failed"),
+                 scoped_ptr<base::DictionaryValue>(
+                     new base::DictionaryValue).Pass());
+    return;
+  }
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->SetInteger("count", count);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::PrefetchDNSCallback(
+    const API::MethodCallback& callback,
+    size_t count)
+{
+  /* Runs on UI thread. */
+  base::DictionaryValue* res = new base::DictionaryValue;
+  res->SetInteger("count", count);
+  callback.Run(std::string(""), scoped_ptr<base::DictionaryValue>(res).Pass());
+}
+
+void
+ThrustSessionBinding::DownloadEventEmit(
+    const std::string& type,
+    scoped_ptr<base::DictionaryValue> event)
+{
+  /* Runs on UI thread. */
+  this->EmitEvent(type, event.Pass());
+}
+
 void
 ThrustSessionBinding::CookiesLoadCallback(
     const LoadedCallback& loaded_callback,
@@ -4,9 +4,14 @@
 #ifndef THRUST_SHELL_API_THRUST_SESSION_BINDING_H_
 #define THRUST_SHELL_API_THRUST_SESSION_BINDING_H_
 
+#include <vector>
+
 #include "base/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "base/timer/timer.h"
 
 #include "src/api/api_binding.h"
+#include "src/net/header_rules.h"
 #include "net/cookies/cookie_monster.h"
 
 namespace thrust_shell {
@@ -57,7 +62,33 @@ public:
   ThrustSession* GetSession();
 
 private:
-  scoped_ptr<ThrustSession> session_;
+  void VisitedLinkAddBatchCallback(const API::MethodCallback& callback,
+                                   size_t count);
+  void VisitedLinkIsVisitedBatchCallback(const API::MethodCallback& callback,
+                                         const std::vector<bool>& visited);
+  void URLRulesSetCallback(const API::MethodCallback& callback,
+                           size_t count,
+                           size_t ignored);
+  void HeaderRulesStatsCallback(
+      const API::MethodCallback& callback,
+      const std::vector<ThrustShellHeaderRules::Counters>& counters);
+  void NetStatsCallback(const API::MethodCallback& callback,
+                        scoped_ptr<base::DictionaryValue> stats);
+  void NetStatsTick();
+  void NetStatsEmit(scoped_ptr<base::DictionaryValue> stats);
+  void NetLogDumpCallback(const API::MethodCallback& callback,
+                          bool ok,
+                          size_t count);
+  void PrefetchDNSCallback(const API::MethodCallback& callback,
+                           size_t count);
+  void DownloadEventEmit(const std::string& type,
+                         scoped_ptr<base::DictionaryValue> event);
+
+  scoped_ptr<ThrustSession>                        session_;
+  base::RepeatingTimer<ThrustSessionBinding>       net_stats_timer_;
+  /* Bound to the download event callbacks, which are held on the IO thread */
+  /* and must not keep this binding (and its session) alive.               */
+  base::WeakPtrFactory<ThrustSessionBinding>       weak_ptr_factory_;
 };
 
 
@@ -3,9 +3,12 @@
 
 #include "src/api/thrust_window_binding.h"
 
+#include "base/bind.h"
+
 #include "src/api/thrust_session_binding.h"
 #include "src/browser/thrust_window.h"
 #include "src/browser/browser_client.h"
+#include "src/browser/util/frame_capture.h"
 #include "src/api/api.h"
 
 namespace thrust_shell {
@@ -51,6 +54,9 @@ ThrustWindowBinding::ThrustWindowBinding(
   bool has_frame = true;
   args->GetBoolean("has_frame", &has_frame);
 
+  bool headless = false;
+  args->GetBoolean("headless", &headless);
+
   ThrustSession* session = NULL;
 
   int session_id = -1;
@@ -72,12 +78,16 @@ ThrustWindowBinding::ThrustWindowBinding(
         gfx::Size(width, height), 
         title, 
         icon_path, 
-        has_frame));
+        has_frame,
+        headless));
+  /* The creation timeline starts when the `create` action was received. */
+  window_->GetCreateTimeline()->SetReceived(API::Get()->create_received());
 }
 
 ThrustWindowBinding::~ThrustWindowBinding()
 {
   LOG(INFO) << "ThrustWindowBinding Destructor [" << this << "] " << id_;
+  capture_stream_.reset();
   window_.reset();
 }
 
@@ -114,6 +124,11 @@ ThrustWindowBinding::CallLocalMethod(
   else if(method.compare("restore") == 0) {
     window_->Restore();
   }
+  else if(method.compare("set_background") == 0) {
+    bool background = false;
+    args->GetBoolean("background", &background);
+    window_->SetBackground(background);
+  }
   else if(method.compare("set_title") == 0) {
     std::string title = "";
     args->GetString("title", &title);
@@ -152,6 +167,43 @@ ThrustWindowBinding::CallLocalMethod(
   else if(method.compare("close") == 0) {
     window_->Close();
   }
+  else if(method.compare("capture") == 0) {
+    ThrustFrameCapture::Options options;
+    if(ThrustFrameCapture::ParseOptions(*args, &options, &err)) {
+      /* Replies once the frame is encoded and written. */
+      delete res;
+      ThrustFrameCapture::Capture(
+          window_->GetWebContents(),
+          options,
+          base::Bind(&ThrustWindowBinding::CaptureCallback, this, callback));
+      return;
+    }
+  }
+  else if(method.compare("capture_start") == 0) {
+    ThrustFrameCapture::Options options;
+    int rate = 0;
+    args->GetInteger("rate", &rate);
+    if(ThrustFrameCapture::ParseOptions(*args, &options, &err)) {
+      /* Frames are written to the stream's own files. The stream is owned */
+      /* by the binding and never calls back once destroyed.               */
+      options.path = base::FilePath();
+      capture_stream_.reset(new ThrustFrameStream(
+            window_->GetWebContents(),
+            options,
+            rate,
+            base::Bind(&ThrustWindowBinding::CaptureFrameEmit,
+                       base::Unretained(this))));
+      scoped_ptr<base::DictionaryValue> stats(capture_stream_->ToValue());
+      res->MergeDictionary(stats.get());
+    }
+  }
+  else if(method.compare("capture_stop") == 0) {
+    if(capture_stream_) {
+      scoped_ptr<base::DictionaryValue> stats(capture_stream_->ToValue());
+      res->MergeDictionary(stats.get());
+      capture_stream_.reset();
+    }
+  }
   else if(method.compare("remote") == 0) {
     const base::DictionaryValue* message = NULL;
     args->GetDictionary("message", &message);
@@ -175,6 +227,9 @@ ThrustWindowBinding::CallLocalMethod(
   else if(method.compare("is_minimized") == 0) {
     res->SetBoolean("minimized", window_->IsMinimized());
   }
+  else if(method.compare("is_background") == 0) {
+    res->SetBoolean("background", window_->IsBackground());
+  }
   else if(method.compare("is_fullscreen") == 0) {
     res->SetBoolean("fullscreen", window_->IsFullscreen());
   }
@@ -184,6 +239,15 @@ ThrustWindowBinding::CallLocalMethod(
   else if(method.compare("is_devtools_opened") == 0) {
     res->SetBoolean("opened", window_->IsDevToolsOpened());
   }
+  else if(method.compare("network_usage") == 0) {
+    scoped_ptr<base::DictionaryValue> usage(
+        window_->GetNetworkUsage().ToValue());
+    res->MergeDictionary(usage.get());
+  }
+  else if(method.compare("draggable_stats") == 0) {
+    scoped_ptr<base::DictionaryValue> stats(window_->GetDraggableStats());
+    res->MergeDictionary(stats.get());
+  }
   /* Default */
   else {
     err = "thrust_window_binding:method_not_found";
@@ -192,6 +256,30 @@ ThrustWindowBinding::CallLocalMethod(
   callback.Run(err, scoped_ptr<base::DictionaryValue>(res).Pass());
 }
 
+void
+ThrustWindowBinding::CaptureCallback(
+    const API::MethodCallback& callback,
+    const std::string& error,
+    scoped_ptr<base::DictionaryValue> frame)
+{
+  if(!frame) {
+    frame.reset(new base::DictionaryValue);
+  }
+  callback.Run(error, frame.Pass());
+}
+
+void
+ThrustWindowBinding::CaptureFrameEmit(
+    const std::string& error,
+    scoped_ptr<base::DictionaryValue> frame)
+{
+  if(!frame) {
+    frame.reset(new base::DictionaryValue);
+    frame->SetString("error", error);
+  }
+  this->EmitEvent("frame", frame.Pass());
+}
+
 ThrustWindow*
 ThrustWindowBinding::GetWindow() {
   return window_.get();
@@ -239,6 +327,14 @@ ThrustWindowBinding::EmitWorkerCrashed()
   this->EmitEvent("worker_crashed", scoped_ptr<base::DictionaryValue>(evt).Pass());
 }
 
+void 
+ThrustWindowBinding::EmitTiming(
+    const base::DictionaryValue& timing)
+{
+  this->EmitEvent("timing", 
+                  scoped_ptr<base::DictionaryValue>(timing.DeepCopy()).Pass());
+}
+
 void 
 ThrustWindowBinding::RemoteSend(
     const base::DictionaryValue& message)
@@ -10,6 +10,7 @@
 
 namespace thrust_shell {
 
+class ThrustFrameStream;
 class ThrustWindow;
 
 class ThrustWindowBinding : public APIBinding {
@@ -40,11 +41,19 @@ public:
   void EmitUnresponsive();
   void EmitResponsive();
   void EmitWorkerCrashed();
+  void EmitTiming(const base::DictionaryValue& timing);
 
   void RemoteSend(const base::DictionaryValue& message);
 
 private:
-  scoped_ptr<ThrustWindow> window_;
+  void CaptureCallback(const API::MethodCallback& callback,
+                       const std::string& error,
+                       scoped_ptr<base::DictionaryValue> frame);
+  void CaptureFrameEmit(const std::string& error,
+                        scoped_ptr<base::DictionaryValue> frame);
+
+  scoped_ptr<ThrustWindow>         window_;
+  scoped_ptr<ThrustFrameStream>    capture_stream_;
 };
 
 
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "src/common/chrome_version.h"
+#include "src/net/app_protocol_handler.h"
 
 namespace thrust_shell {
 
@@ -30,6 +31,7 @@ ContentClient::AddAdditionalSchemes(
     std::vector<std::string>* savable_schemes) 
 {
   standard_schemes->push_back("chrome-extension");
+  standard_schemes->push_back(kAppScheme);
 }
 
 }  // namespace thrust_shell
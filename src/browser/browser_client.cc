@@ -25,8 +25,10 @@
 
 #include "src/browser/browser_main_parts.h"
 #include "src/browser/resource_dispatcher_host_delegate.h"
+#include "src/net/app_protocol_handler.h"
 #include "src/common/switches.h"
 #include "src/browser/session/thrust_session.h"
+#include "src/browser/thrust_registry.h"
 #include "src/browser/thrust_window.h"
 #include "src/geolocation/access_token_store.h"
 #include "src/common/chrome_version.h"
@@ -244,6 +246,7 @@ ThrustShellBrowserClient::IsHandledURL(
       kChromeDevToolsScheme,
       url::kDataScheme,
       url::kFileScheme,
+      kAppScheme,
   };
   for (size_t i = 0; i < arraysize(kProtocolList); ++i) {
     if (url.scheme() == kProtocolList[i])
@@ -260,35 +263,23 @@ ThrustShellBrowserClient::RegisterThrustSession(
     ThrustSession* session)
 {
   LOG(INFO) << "Register Session";
-  sessions_.push_back(session);
+  ThrustRegistry::GetInstance()->AddSession(session);
 }
 
 void 
 ThrustShellBrowserClient::UnRegisterThrustSession(
     ThrustSession* session)
 {
-  std::vector<ThrustSession*>::iterator it;
-  for(it = sessions_.begin(); it != sessions_.end(); it++) {
-    if(*it == session)
-      break;
-  }
-  if(it != sessions_.end()) {
-    LOG(INFO) << "UnRegister Session";
-    sessions_.erase(it);
-  }
+  LOG(INFO) << "UnRegister Session";
+  ThrustRegistry::GetInstance()->RemoveSession(session);
 }
 
 ThrustSession*
 ThrustShellBrowserClient::ThrustSessionForBrowserContext(
     BrowserContext* browser_context) 
 {
-  std::vector<ThrustSession*>::iterator it;
-  for(it = sessions_.begin(); it != sessions_.end(); it++) {
-    if(*it == browser_context) {
-      return *it;
-    }
-  }
-  return NULL;
+  return ThrustRegistry::GetInstance()->SessionForBrowserContext(
+      browser_context);
 }
 
 ThrustSession* 
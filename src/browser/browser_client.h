@@ -135,8 +135,6 @@ class ThrustShellBrowserClient : public brightray::BrowserClient {
   scoped_ptr<ThrustShellResourceDispatcherHostDelegate>
                                         resource_dispatcher_host_delegate_;
 
-  std::vector<ThrustSession*>           sessions_;
-
   static ThrustShellBrowserClient*      self_;
   static std::string                    app_name_override_;
   static std::string                    app_version_override_;
@@ -5,9 +5,11 @@
 #include "src/browser/browser_main_parts.h"
 
 #include "base/bind.h"
+#include "base/command_line.h"
 #include "base/files/file_path.h"
 #include "base/file_util.h"
 #include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_restrictions.h"
 #include "cc/base/switches.h"
@@ -70,9 +72,36 @@ ThrustShellMainParts::CreateBrowserContext() {
 void 
 ThrustShellMainParts::PreMainMessageLoopRun() 
 {
+  /* The archive must be available before any request context is created. */
+  /* It is mapped and indexed once, entries are paged in on demand.       */
+  const CommandLine* command_line = CommandLine::ForCurrentProcess();
+  if(command_line->HasSwitch(switches::kAppArchive)) {
+    base::ThreadRestrictions::ScopedAllowIO allow_io;
+    app_archive_ = ThrustShellAppArchive::Open(
+        command_line->GetSwitchValuePath(switches::kAppArchive));
+  }
+
   brightray::BrowserMainParts::PreMainMessageLoopRun();
   net_log_.reset(new ThrustShellNetLog());
 
+  /* Sessions created through the API configure their own pool. */
+  size_t prewarm_windows = 0;
+  size_t prewarm_guests = 0;
+  if(command_line->HasSwitch(switches::kPrewarmWindows)) {
+    base::StringToSizeT(
+        command_line->GetSwitchValueASCII(switches::kPrewarmWindows),
+        &prewarm_windows);
+  }
+  if(command_line->HasSwitch(switches::kPrewarmGuests)) {
+    base::StringToSizeT(
+        command_line->GetSwitchValueASCII(switches::kPrewarmGuests),
+        &prewarm_guests);
+  }
+  if(system_session_ && (prewarm_windows > 0 || prewarm_guests > 0)) {
+    system_session_->GetWebContentsPool()->SetSize(prewarm_windows,
+                                                   prewarm_guests);
+  }
+
   api_->InstallBinding("window", new ThrustWindowBindingFactory());
   api_->InstallBinding("session", new ThrustSessionBindingFactory());
   api_->InstallBinding("menu", new ThrustMenuBindingFactory());
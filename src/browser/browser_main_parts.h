@@ -12,9 +12,8 @@
 #include "base/memory/scoped_ptr.h"
 #include "content/public/browser/browser_main_parts.h"
 
-namespace net {
-class NetLog;
-}
+#include "src/net/app_archive.h"
+#include "src/net/net_log.h"
 
 namespace content {
 struct MainFunctionParams;
@@ -47,12 +46,18 @@ class ThrustShellMainParts : public brightray::BrowserMainParts {
   virtual void PostDestroyThreads() OVERRIDE;
 #endif
 
-  net::NetLog* net_log() { 
+  ThrustShellNetLog* net_log() { 
     return net_log_.get(); 
   }
 
+  // The archive served over `app://` (NULL if none was specified).
+  ThrustShellAppArchive* app_archive() {
+    return app_archive_.get();
+  }
+
  private:
-  scoped_ptr<net::NetLog> net_log_;
+  scoped_ptr<ThrustShellNetLog> net_log_;
+  scoped_refptr<ThrustShellAppArchive>  app_archive_;
 
   static ThrustShellMainParts*          self_;
   ThrustSession*                        system_session_;
@@ -5,10 +5,15 @@
 #include "src/browser/resource_dispatcher_host_delegate.h"
 
 #include "base/command_line.h"
+#include "content/public/browser/resource_throttle.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_context.h"
 /* TODO(spolu): introduce ShellLogin Dialog (see content) */
 //#include "content/shell/shell_login_dialog.h"
 
 #include "src/common/switches.h"
+#include "src/net/network_delegate.h"
+#include "src/net/request_scheduler.h"
 
 using namespace content;
 
@@ -24,6 +29,31 @@ ThrustShellResourceDispatcherHostDelegate::
 {
 }
 
+void
+ThrustShellResourceDispatcherHostDelegate::RequestBeginning(
+    net::URLRequest* request,
+    ResourceContext* resource_context,
+    appcache::AppCacheService* appcache_service,
+    ResourceType::Type resource_type,
+    int child_id,
+    int route_id,
+    ScopedVector<ResourceThrottle>* throttles)
+{
+  /* All request contexts are created by ThrustShellURLRequestContextGetter */
+  /* and use a ThrustShellNetworkDelegate.                                  */
+  ThrustShellNetworkDelegate* network_delegate =
+    static_cast<ThrustShellNetworkDelegate*>(
+        request->context()->network_delegate());
+  if(!network_delegate || !network_delegate->request_scheduler())
+    return;
+
+  ResourceThrottle* throttle = 
+    network_delegate->request_scheduler()->MaybeCreateThrottle(
+        request, resource_type, child_id, route_id);
+  if(throttle)
+    throttles->push_back(throttle);
+}
+
 ResourceDispatcherHostLoginDelegate*
 ThrustShellResourceDispatcherHostDelegate::CreateLoginDelegate(
     net::AuthChallengeInfo* auth_info, 
@@ -17,6 +17,14 @@ class ThrustShellResourceDispatcherHostDelegate
   virtual ~ThrustShellResourceDispatcherHostDelegate();
 
   // ResourceDispatcherHostDelegate implementation.
+  virtual void RequestBeginning(
+      net::URLRequest* request,
+      content::ResourceContext* resource_context,
+      appcache::AppCacheService* appcache_service,
+      content::ResourceType::Type resource_type,
+      int child_id,
+      int route_id,
+      ScopedVector<content::ResourceThrottle>* throttles) OVERRIDE;
   virtual content::ResourceDispatcherHostLoginDelegate* CreateLoginDelegate(
       net::AuthChallengeInfo* auth_info, 
       net::URLRequest* request) OVERRIDE;
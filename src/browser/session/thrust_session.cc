@@ -3,24 +3,33 @@
 
 #include "src/browser/session/thrust_session.h"
 
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/file_util.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
+#include "base/task_runner_util.h"
 #include "base/threading/thread.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
+#include "base/values.h"
 #include "net/base/escape.h"
 #include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_frame_host.h"
+#include "content/public/browser/render_process_host.h"
 #include "content/public/browser/resource_context.h"
 #include "content/public/browser/storage_partition.h"
 #include "content/public/common/content_switches.h"
 
 #include "src/common/switches.h"
+#include "src/net/net_stats.h"
+#include "src/net/proxy_resolver.h"
 #include "src/net/url_request_context_getter.h"
 #include "src/browser/dialog/download_manager_delegate.h"
 #include "src/browser/browser_main_parts.h"
 #include "src/browser/browser_client.h"
+#include "src/browser/thrust_registry.h"
 #include "src/browser/web_view/web_view_guest.h"
 #include "src/browser/session/thrust_session_proxy_config_service.h"
 
@@ -28,6 +37,17 @@ using namespace content;
 
 namespace thrust_shell {
 
+namespace {
+
+/* PAC results are memoized per host for this long by default. */
+const int kDefaultProxyCacheTTL = 300;
+
+/* Unused guest instance IDs an embedder can have reserved at once. A */
+/* well-behaved renderer only asks for a new range when running low.  */
+const size_t kMaxReservedInstanceIDs = 64;
+
+}
+
 /******************************************************************************/
 /* RESOURCE CONTEXT */
 /******************************************************************************/
@@ -80,7 +100,11 @@ ThrustSession::ThrustSession(
   resource_context_(new ExoResourceContext),
   cookie_store_(new ThrustSessionCookieStore(this, dummy_cookie_store)),
   visitedlink_store_(new ThrustSessionVisitedLinkStore(this)),
-  current_instance_id_(0)
+  web_contents_pool_(new ThrustSessionWebContentsPool(this)),
+  proxy_cache_ttl_(base::TimeDelta::FromSeconds(kDefaultProxyCacheTTL)),
+  next_download_id_(1),
+  current_instance_id_(0),
+  weak_ptr_factory_(this)
 {
   CommandLine* cmd_line = CommandLine::ForCurrentProcess();
   if (cmd_line->HasSwitch(switches::kIgnoreCertificateErrors)) {
@@ -108,6 +132,9 @@ ThrustSession::~ThrustSession()
 {
   LOG(INFO) << "ThrustSession Destructor " << this;
 
+  /* Idle WebContents must not outlive their BrowserContext. */
+  web_contents_pool_.reset();
+
   /* NOTE: We don't delete the proxy_config_service_ as it is owned by the */
   /* UrlRequestContextGetter as soon as it is initialized                  */
 
@@ -175,6 +202,9 @@ ThrustSession::CreateRequestContext(
       protocol_handlers,
       request_interceptors.Pass(),
       ThrustShellMainParts::Get()->net_log());
+  /* The getter is not used on the IO thread yet. */
+  url_request_getter_->url_rules_ = url_rules_;
+  url_request_getter_->header_rule_specs_ = header_rule_specs_;
   resource_context_->set_url_request_context_getter(url_request_getter_.get());
   return url_request_getter_.get();
 }
@@ -211,6 +241,298 @@ ThrustSession::GetProxyConfigService()
   return proxy_config_service_;
 }
 
+ThrustSessionWebContentsPool*
+ThrustSession::GetWebContentsPool()
+{
+  return web_contents_pool_.get();
+}
+
+void
+ThrustSession::RecordCreateTimeline(
+    bool guest,
+    const ThrustCreateTimeline& timeline)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(guest)
+    guest_timings_.Add(timeline);
+  else
+    window_timings_.Add(timeline);
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustSession::GetCreateTimings(
+    bool reset)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  scoped_ptr<base::DictionaryValue> timings(new base::DictionaryValue);
+  timings->Set("windows", window_timings_.ToValue().release());
+  timings->Set("guests", guest_timings_.ToValue().release());
+  if(reset) {
+    window_timings_.Reset();
+    guest_timings_.Reset();
+  }
+  return timings.Pass();
+}
+
+void
+ThrustSession::SetHostResolverOptions(
+    const ThrustShellHostResolver::Options& options)
+{
+  DCHECK(!url_request_getter_.get());
+  host_resolver_options_ = options;
+}
+
+void
+ThrustSession::SetProxyCacheTTL(
+    base::TimeDelta cache_ttl)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  proxy_cache_ttl_ = cache_ttl;
+  if(!url_request_getter_.get())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::SetProxyCacheTTL,
+                 url_request_getter_, cache_ttl));
+}
+
+void
+ThrustSession::SetURLRules(
+    const std::vector<std::string>& rules,
+    const URLRulesCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetBlockingPool(), FROM_HERE,
+      base::Bind(&ThrustShellURLRuleSet::Compile, rules),
+      base::Bind(&ThrustSession::OnURLRulesCompiled,
+                 weak_ptr_factory_.GetWeakPtr(), callback));
+}
+
+void
+ThrustSession::ClearURLRules()
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  InstallURLRules(NULL);
+}
+
+void
+ThrustSession::SetHeaderRules(
+    const std::vector<ThrustShellHeaderRules::Spec>& specs)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  header_rule_specs_ = specs;
+  if(url_request_getter_.get()) {
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&ThrustShellURLRequestContextGetter::SetHeaderRules,
+                   url_request_getter_, header_rule_specs_));
+  }
+}
+
+void
+ThrustSession::SetRequestPriorityClass(
+    int render_process_id,
+    int render_view_id,
+    ThrustShellRequestScheduler::PriorityClass priority_class)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  /* No request can be issued before the getter is created. */
+  if(!url_request_getter_.get())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::SetRequestPriorityClass,
+                 url_request_getter_, render_process_id, render_view_id,
+                 priority_class));
+}
+
+void
+ThrustSession::RemoveRequestPriorityClass(
+    int render_process_id,
+    int render_view_id)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(
+          &ThrustShellURLRequestContextGetter::RemoveRequestPriorityClass,
+          url_request_getter_, render_process_id, render_view_id));
+}
+
+void
+ThrustSession::Preconnect(
+    const GURL& url,
+    int count)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  /* Typically called before any window exists. */
+  if(!GetURLRequestGetter())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::Preconnect,
+                 url_request_getter_, url, count));
+}
+
+void
+ThrustSession::PrefetchDNS(
+    const std::vector<std::string>& hosts,
+    const PrefetchDNSCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!GetURLRequestGetter()) {
+    callback.Run(0);
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::IO).get(),
+      FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::PrefetchDNS,
+                 url_request_getter_, hosts),
+      callback);
+}
+
+void
+ThrustSession::GetDNSStats(
+    bool reset,
+    const NetStatsCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get()) {
+    callback.Run(ThrustShellHostResolver::Stats().ToValue());
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::IO).get(),
+      FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::GetDNSStats,
+                 url_request_getter_, reset),
+      callback);
+}
+
+void
+ThrustSession::GetProxyStats(
+    bool reset,
+    const NetStatsCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get()) {
+    callback.Run(ThrustShellProxyResolver::Stats().ToValue());
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::IO).get(),
+      FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::GetProxyStats,
+                 url_request_getter_, reset),
+      callback);
+}
+
+int
+ThrustSession::StartDownload(
+    const GURL& url,
+    const base::FilePath& path,
+    const ThrustShellParallelDownloader::Options& options,
+    const ThrustShellParallelDownloader::EventCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  int id = next_download_id_++;
+  /* Downloads may be started before any window exists. */
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::StartDownload,
+                 make_scoped_refptr(GetURLRequestGetter()),
+                 id, url, path, options, callback));
+  return id;
+}
+
+void
+ThrustSession::CancelDownload(
+    int id)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::CancelDownload,
+                 url_request_getter_, id));
+}
+
+void
+ThrustSession::GetHeaderRulesCounters(
+    const HeaderRulesCountersCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get()) {
+    callback.Run(std::vector<ThrustShellHeaderRules::Counters>(
+          header_rule_specs_.size()));
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::IO).get(),
+      FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::GetHeaderRulesCounters,
+                 url_request_getter_),
+      callback);
+}
+
+void
+ThrustSession::GetNetStats(
+    const std::string& host,
+    bool reset,
+    const NetStatsCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!url_request_getter_.get()) {
+    callback.Run(ThrustShellNetStats().Summary(host));
+    return;
+  }
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetMessageLoopProxyForThread(BrowserThread::IO).get(),
+      FROM_HERE,
+      base::Bind(&ThrustShellURLRequestContextGetter::GetNetStats,
+                 url_request_getter_, host, reset),
+      callback);
+}
+
+void
+ThrustSession::OnURLRulesCompiled(
+    const URLRulesCallback& callback,
+    const scoped_refptr<ThrustShellURLRuleSet>& rules)
+{
+  /* Runs on UI thread. */
+  InstallURLRules(rules);
+  callback.Run(rules->rule_count(), rules->ignored_count());
+}
+
+void
+ThrustSession::InstallURLRules(
+    const scoped_refptr<ThrustShellURLRuleSet>& rules)
+{
+  url_rules_ = rules;
+  if(url_request_getter_.get()) {
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&ThrustShellURLRequestContextGetter::SetURLRules,
+                   url_request_getter_, url_rules_));
+  }
+}
+
+ThrustShellURLRequestContextGetter*
+ThrustSession::GetURLRequestGetter()
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  /* Creating the default storage partition has content call back into */
+  /* CreateRequestContext.                                             */
+  if(!url_request_getter_.get())
+    BrowserContext::GetDefaultStoragePartition(this);
+  return url_request_getter_.get();
+}
+
 /******************************************************************************/
 /* BROWSER_PLUGIN_GUEST_MANAGER */
 /******************************************************************************/
@@ -222,6 +544,19 @@ ThrustSession::MaybeGetGuestByInstanceIDOrKill(
 {
   content::WebContents* guest_web_contents =
       GetGuestByInstanceID(guest_instance_id, embedder_render_process_id);
+  if(!guest_web_contents) {
+    /* Guests are created asynchronously with IDs allocated by the embedder */
+    /* renderer: the attachment waits for the creation if the ID is still   */
+    /* reserved for that embedder.                                          */
+    std::map<int, ReservedInstanceID>::const_iterator it =
+      reserved_instance_ids_.find(guest_instance_id);
+    if(it != reserved_instance_ids_.end() &&
+       it->second.frame->GetProcess()->GetID() == 
+         embedder_render_process_id) {
+      pending_attaches_[guest_instance_id].push_back(callback);
+      return;
+    }
+  }
   callback.Run(guest_web_contents);
 }
 
@@ -243,15 +578,19 @@ ThrustSession::ForEachGuest(
     WebContents* embedder_web_contents,
     const GuestCallback& callback) 
 {
-  for (std::map<int, content::WebContents*>::iterator it =
-           guest_web_contents_.begin();
-       it != guest_web_contents_.end(); ++it) {
-    WebContents* guest = it->second;
-    WebViewGuest* guest_view = WebViewGuest::FromWebContents(guest);
-    if(embedder_web_contents != guest_view->embedder_web_contents()) {
+  std::vector<WebViewGuest*> guests;
+  ThrustRegistry::GetInstance()->GuestsForEmbedder(embedder_web_contents,
+                                                   &guests);
+  std::vector<WebContents*> contents;
+  for(size_t i = 0; i < guests.size(); ++i) {
+    contents.push_back(guests[i]->guest_web_contents());
+  }
+  for(size_t i = 0; i < contents.size(); ++i) {
+    /* Guests may be destroyed by |callback|. */
+    if(!ThrustRegistry::GetInstance()->GuestForWebContents(contents[i])) {
       continue;
     }
-    if(callback.Run(guest)) {
+    if(callback.Run(contents[i])) {
       return true;
     }
   }
@@ -268,6 +607,14 @@ ThrustSession::AddGuest(
 {
   CHECK(!ContainsKey(guest_web_contents_, guest_instance_id));
   guest_web_contents_[guest_instance_id] = guest_web_contents;
+
+  if(ContainsKey(pending_attaches_, guest_instance_id)) {
+    /* Attachments run once the guest is fully initialized. */
+    base::MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(&ThrustSession::RunPendingAttaches,
+                   weak_ptr_factory_.GetWeakPtr(), guest_instance_id));
+  }
 }
 
 void 
@@ -281,10 +628,106 @@ ThrustSession::RemoveGuest(
 }
 
 int 
-ThrustSession::GetNextInstanceID() 
+ThrustSession::ReserveInstanceIDs(
+    WebContents* embedder,
+    RenderFrameHost* frame,
+    int count)
 {
+  size_t unused = 0;
+  std::map<int, ReservedInstanceID>::const_iterator it;
+  for(it = reserved_instance_ids_.begin(); 
+      it != reserved_instance_ids_.end(); ++it) {
+    if(it->second.embedder == embedder)
+      unused++;
+  }
+  if(count <= 0 || unused + count > kMaxReservedInstanceIDs) {
+    return 0;
+  }
+
+  ReservedInstanceID reserved;
+  reserved.embedder = embedder;
+  reserved.frame = frame;
   /* We avoid 0 as instance_id so that it's true in javascript */
-  return ++current_instance_id_;
+  int first = current_instance_id_ + 1;
+  for(int i = 0; i < count; ++i) {
+    reserved_instance_ids_[++current_instance_id_] = reserved;
+  }
+  return first;
+}
+
+bool
+ThrustSession::ClaimInstanceID(
+    WebContents* embedder,
+    int guest_instance_id)
+{
+  std::map<int, ReservedInstanceID>::iterator it =
+    reserved_instance_ids_.find(guest_instance_id);
+  if(it == reserved_instance_ids_.end() || it->second.embedder != embedder) {
+    return false;
+  }
+  reserved_instance_ids_.erase(it);
+  return true;
+}
+
+void
+ThrustSession::ReleaseInstanceIDs(
+    WebContents* embedder)
+{
+  ReleaseInstanceIDs(embedder, NULL);
+}
+
+void
+ThrustSession::ReleaseInstanceIDs(
+    RenderFrameHost* frame)
+{
+  ReleaseInstanceIDs(NULL, frame);
+}
+
+void
+ThrustSession::ReleaseInstanceIDs(
+    WebContents* embedder,
+    RenderFrameHost* frame)
+{
+  std::vector<int> released;
+  std::map<int, ReservedInstanceID>::iterator it = 
+    reserved_instance_ids_.begin();
+  while(it != reserved_instance_ids_.end()) {
+    if((embedder && it->second.embedder == embedder) ||
+       (frame && it->second.frame == frame)) {
+      released.push_back(it->first);
+      reserved_instance_ids_.erase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+  for(size_t i = 0; i < released.size(); ++i) {
+    RunPendingAttaches(released[i]);
+  }
+}
+
+void
+ThrustSession::RunPendingAttaches(
+    int guest_instance_id)
+{
+  std::map<int, std::vector<GuestByInstanceIDCallback> >::iterator it =
+    pending_attaches_.find(guest_instance_id);
+  if(it == pending_attaches_.end()) {
+    return;
+  }
+  std::vector<GuestByInstanceIDCallback> callbacks;
+  callbacks.swap(it->second);
+  pending_attaches_.erase(it);
+
+  /* The guest is NULL (the attachment fails) if it was never created or */
+  /* got destroyed in the meantime.                                      */
+  std::map<int, WebContents*>::const_iterator guest =
+    guest_web_contents_.find(guest_instance_id);
+  WebContents* guest_web_contents = 
+    guest == guest_web_contents_.end() ? NULL : guest->second;
+  for(size_t i = 0; i < callbacks.size(); ++i) {
+    callbacks[i].Run(guest_web_contents);
+  }
 }
 
 }  // namespace thrust_shell
@@ -7,6 +7,7 @@
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
 #include "net/url_request/url_request_job_factory.h"
 #include "content/public/browser/browser_context.h"
 #include "content/public/browser/content_browser_client.h"
@@ -14,9 +15,17 @@
 #include "content/public/browser/site_instance.h"
 #include "content/public/browser/web_contents.h"
 #include "brightray/browser/browser_context.h"
+#include "url/gurl.h"
 
 #include "src/browser/session/thrust_session_cookie_store.h"
 #include "src/browser/session/thrust_session_visitedlink_store.h"
+#include "src/browser/session/thrust_session_web_contents_pool.h"
+#include "src/browser/util/create_timeline.h"
+#include "src/net/header_rules.h"
+#include "src/net/host_resolver.h"
+#include "src/net/parallel_download.h"
+#include "src/net/request_scheduler.h"
+#include "src/net/url_rule_set.h"
 
 namespace thrust_shell {
 
@@ -50,6 +59,15 @@ class ThrustSessionProxyConfigService;
 class ThrustSession : public brightray::BrowserContext,
                       public content::BrowserPluginGuestManager {
 public:
+  typedef base::Callback<void(size_t count, size_t ignored)> 
+    URLRulesCallback;
+  typedef base::Callback<
+    void(const std::vector<ThrustShellHeaderRules::Counters>& counters)> 
+    HeaderRulesCountersCallback;
+  typedef base::Callback<void(scoped_ptr<base::DictionaryValue> stats)> 
+    NetStatsCallback;
+  typedef base::Callback<void(size_t count)> PrefetchDNSCallback;
+
   /****************************************************************************/
   /* PUBLIC INTERFACE */
   /****************************************************************************/
@@ -64,6 +82,145 @@ public:
   ThrustSessionCookieStore* GetCookieStore();
   ThrustSessionVisitedLinkStore* GetVisitedLinkStore();
   ThrustSessionProxyConfigService* GetProxyConfigService();
+  ThrustSessionWebContentsPool* GetWebContentsPool();
+
+  // ### SetHostResolverOptions
+  // Must be called before the request context is created (at creation).
+  void SetHostResolverOptions(
+      const ThrustShellHostResolver::Options& options);
+  const ThrustShellHostResolver::Options& host_resolver_options() const {
+    return host_resolver_options_;
+  }
+
+  // ### SetProxyCacheTTL
+  // Sets the time PAC results are cached per host (null to disable).
+  void SetProxyCacheTTL(base::TimeDelta cache_ttl);
+  base::TimeDelta proxy_cache_ttl() const { return proxy_cache_ttl_; }
+
+  // ### SetURLRules
+  // Compiles the rules on the blocking pool and installs them on the network
+  // delegate of this session, replacing any previous rule set.
+  // ```
+  // @rules    {vector<string>} the rules (see ThrustShellURLRuleSet)
+  // @callback {URLRulesCallback} called on the UI thread once installed
+  // ```
+  void SetURLRules(const std::vector<std::string>& rules,
+                   const URLRulesCallback& callback);
+  // ### ClearURLRules
+  // Removes the rules installed on this session.
+  void ClearURLRules();
+
+  // ### SetHeaderRules
+  // Installs the header rewrite rules of this session (replacing any previous
+  // ones and resetting their counters). They are compiled on the IO thread.
+  // ```
+  // @specs {vector<Spec>} the header rules (empty to clear)
+  // ```
+  void SetHeaderRules(const std::vector<ThrustShellHeaderRules::Spec>& specs);
+  // ### GetHeaderRulesCounters
+  // Retrieves the match and apply counters of the header rules from the IO
+  // thread.
+  // ```
+  // @callback {HeaderRulesCountersCallback} called on the UI thread
+  // ```
+  void GetHeaderRulesCounters(const HeaderRulesCountersCallback& callback);
+
+  // ### GetNetStats
+  // Retrieves the load timing summary of this session (overall and per host)
+  // from the IO thread.
+  // ```
+  // @host     {string} optional host filter
+  // @reset    {bool} whether to reset the statistics
+  // @callback {NetStatsCallback} called on the UI thread
+  // ```
+  void GetNetStats(const std::string& host,
+                   bool reset,
+                   const NetStatsCallback& callback);
+
+  // ### SetRequestPriorityClass
+  // Sets the scheduling class of the requests issued by a render view of this
+  // session (see ThrustShellRequestScheduler).
+  // ```
+  // @render_process_id {int} the render process id
+  // @render_view_id    {int} the render view routing id
+  // @priority_class    {PriorityClass} the new class
+  // ```
+  void SetRequestPriorityClass(
+      int render_process_id,
+      int render_view_id,
+      ThrustShellRequestScheduler::PriorityClass priority_class);
+  // ### RemoveRequestPriorityClass
+  // Forgets the scheduling class of a render view that is gone.
+  void RemoveRequestPriorityClass(int render_process_id, 
+                                  int render_view_id);
+
+  // ### Preconnect
+  // Opens sockets to the origin of `url` ahead of a navigation.
+  // ```
+  // @url   {GURL} the http(s) URL to preconnect to
+  // @count {int} the number of sockets to open
+  // ```
+  void Preconnect(const GURL& url, int count);
+  // ### PrefetchDNS
+  // Speculatively resolves `hosts` in the session host resolver.
+  // ```
+  // @hosts    {vector<string>} the hosts to resolve
+  // @callback {PrefetchDNSCallback} called on the UI thread
+  // ```
+  void PrefetchDNS(const std::vector<std::string>& hosts,
+                   const PrefetchDNSCallback& callback);
+
+  // ### GetDNSStats
+  // Retrieves the host resolver statistics from the IO thread.
+  // ```
+  // @reset    {bool} whether to reset the statistics once returned
+  // @callback {NetStatsCallback} called on the UI thread
+  // ```
+  void GetDNSStats(bool reset,
+                   const NetStatsCallback& callback);
+  // ### GetProxyStats
+  // Retrieves the PAC evaluation statistics from the IO thread.
+  // ```
+  // @reset    {bool} whether to reset the statistics once returned
+  // @callback {NetStatsCallback} called on the UI thread
+  // ```
+  void GetProxyStats(bool reset,
+                     const NetStatsCallback& callback);
+
+  // ### StartDownload
+  // Starts (or resumes, see ThrustShellParallelDownloader) a parallel ranged
+  // download and returns its id.
+  // ```
+  // @url      {GURL} the http(s) URL to download
+  // @path     {FilePath} the target file
+  // @options  {Options} the download options
+  // @callback {EventCallback} called on the UI thread with the events
+  // ```
+  int StartDownload(
+      const GURL& url,
+      const base::FilePath& path,
+      const ThrustShellParallelDownloader::Options& options,
+      const ThrustShellParallelDownloader::EventCallback& callback);
+  // ### CancelDownload
+  // Interrupts a download, keeping it resumable.
+  void CancelDownload(int id);
+
+  // ### RecordCreateTimeline
+  // Aggregates the timeline of a window or guest created in this session,
+  // once complete (first paint).
+  // ```
+  // @guest    {bool} whether it is the timeline of a <webview> guest
+  // @timeline {ThrustCreateTimeline} the timeline
+  // ```
+  void RecordCreateTimeline(bool guest,
+                            const ThrustCreateTimeline& timeline);
+  // ### GetCreateTimings
+  // Returns the aggregated `windows` and `guests` timelines (see
+  // ThrustCreateTimings).
+  // ```
+  // @reset {bool} whether to reset them once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetCreateTimings(bool reset);
 
   /****************************************************************************/
   /* REQUEST CONTEXT GETTER HELPERS */
@@ -113,12 +270,59 @@ public:
       const std::string& embedder_extension_id,
       int embedder_render_process_id,
       const content::WebContents::CreateParams& create_params);
-  int GetNextInstanceID();
+
+  // ### ReserveInstanceIDs
+  // ```
+  // @embedder {WebContents} the embedder the IDs are reserved for
+  // @frame    {RenderFrameHost} the embedder main frame allocating them
+  // @count    {int} the number of IDs to reserve
+  // ```
+  // Reserves a range of guest instance IDs that the embedder renderer
+  // allocates on its own so that guest creation does not have to wait for
+  // the browser. Returns the first ID of the range, or 0 if the embedder
+  // would have more than kMaxReservedInstanceIDs unused IDs reserved.
+  int ReserveInstanceIDs(content::WebContents* embedder,
+                         content::RenderFrameHost* frame,
+                         int count);
+
+  // ### ClaimInstanceID
+  // Returns whether |guest_instance_id| is reserved for |embedder| and not
+  // used yet. The ID is not reserved anymore once claimed.
+  bool ClaimInstanceID(content::WebContents* embedder, int guest_instance_id);
+
+  // ### ReleaseInstanceIDs
+  // Releases the unused IDs reserved for |embedder| (pending attachments to
+  // them are cancelled).
+  void ReleaseInstanceIDs(content::WebContents* embedder);
+  // Releases the unused IDs reserved for |frame| only (swapped out or
+  // deleted main frame).
+  void ReleaseInstanceIDs(content::RenderFrameHost* frame);
 
 
 private:
   class ExoResourceContext;
 
+  struct ReservedInstanceID {
+    content::WebContents*        embedder;
+    content::RenderFrameHost*    frame;
+  };
+
+  // Releases the unused IDs matching |embedder| or |frame|.
+  void ReleaseInstanceIDs(content::WebContents* embedder,
+                          content::RenderFrameHost* frame);
+
+  // Returns the request context getter, creating the default storage
+  // partition (and with it the request context) if no window created it yet.
+  ThrustShellURLRequestContextGetter* GetURLRequestGetter();
+
+  // Runs the attachments that were requested before the creation of the
+  // guest |guest_instance_id|.
+  void RunPendingAttaches(int guest_instance_id);
+
+  void OnURLRulesCompiled(const URLRulesCallback& callback,
+                          const scoped_refptr<ThrustShellURLRuleSet>& rules);
+  void InstallURLRules(const scoped_refptr<ThrustShellURLRuleSet>& rules);
+
   /****************************************************************************/
   /* MEMBERS                                                                   */
   /****************************************************************************/
@@ -134,9 +338,22 @@ private:
   scoped_refptr<ThrustSessionCookieStore>             cookie_store_;
   scoped_refptr<ThrustSessionVisitedLinkStore>        visitedlink_store_;
   ThrustSessionProxyConfigService*                    proxy_config_service_;
+  scoped_ptr<ThrustSessionWebContentsPool>            web_contents_pool_;
+  ThrustCreateTimings                                 window_timings_;
+  ThrustCreateTimings                                 guest_timings_;
+  scoped_refptr<ThrustShellURLRuleSet>                url_rules_;
+  std::vector<ThrustShellHeaderRules::Spec>           header_rule_specs_;
+  ThrustShellHostResolver::Options                    host_resolver_options_;
+  base::TimeDelta                                     proxy_cache_ttl_;
+  int                                                 next_download_id_;
 
   std::map<int, content::WebContents*>                guest_web_contents_;
   int                                                 current_instance_id_;
+  std::map<int, ReservedInstanceID>                   reserved_instance_ids_;
+  std::map<int, std::vector<GuestByInstanceIDCallback> >
+                                                      pending_attaches_;
+
+  base::WeakPtrFactory<ThrustSession>                 weak_ptr_factory_;
 
   friend class ThrustSessionCookieStore;
   friend class WebViewGuest;
@@ -6,6 +6,7 @@
 #include "net/proxy/proxy_service.h"
 #include "net/proxy/proxy_config_service_fixed.h"
 #include "content/public/browser/browser_thread.h"
+#include "url/gurl.h"
 
 #include "src/browser/session/thrust_session.h"
 
@@ -45,9 +46,30 @@ ThrustSessionProxyConfigService::SetProxyRules(
 {
   net::ProxyConfig proxy_config;
   proxy_config.proxy_rules().ParseFromString(proxy_string);  
-  fixed_service_.reset(new net::ProxyConfigServiceFixed(proxy_config));
 
   LOG(INFO) << "ThrustSesionProxyConfigService SetProxyRules: " << proxy_string;
+  SetFixedConfig(proxy_config);
+}
+
+void 
+ThrustSessionProxyConfigService::SetPacURL(
+    const GURL& pac_url)
+{
+  net::ProxyConfig proxy_config;
+  proxy_config.set_pac_url(pac_url);
+  /* Requests go direct if the script can't be fetched or evaluated. */
+  proxy_config.set_pac_mandatory(false);
+
+  LOG(INFO) << "ThrustSesionProxyConfigService SetPacURL: " 
+            << pac_url.possibly_invalid_spec().substr(0, 128);
+  SetFixedConfig(proxy_config);
+}
+
+void 
+ThrustSessionProxyConfigService::SetFixedConfig(
+    const net::ProxyConfig& proxy_config)
+{
+  fixed_service_.reset(new net::ProxyConfigServiceFixed(proxy_config));
 
   if(observers_.might_have_observers()) {
     ObserverList<Observer>::Iterator it(observers_);
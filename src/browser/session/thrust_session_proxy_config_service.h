@@ -8,6 +8,8 @@
 #include "base/observer_list.h"
 #include "net/proxy/proxy_config_service.h"
 
+class GURL;
+
 namespace thrust_shell {
 
 class ThrustSession;
@@ -19,8 +21,8 @@ class ThrustSession;
 // This proxy service is passed as argument to the 
 // ThrustShellURLRequestContextGetter to manage all proxy information.
 //
-// The ProxyConfigService expose two simple methods SetProxyString and 
-// ClearProxyString to set or clear (return to system settings) the proxy rules 
+// The ProxyConfigService expose simple methods SetProxyRules / SetPacURL and 
+// ClearProxyRules to set or clear (return to system settings) the proxy rules 
 // for all requests made for this session
 class ThrustSessionProxyConfigService : public net::ProxyConfigService {
 public:
@@ -32,6 +34,7 @@ public:
   /* PUBLIC API */
   /****************************************************************************/
   void SetProxyRules(std::string& rules);
+  void SetPacURL(const GURL& pac_url);
   void ClearProxyRules();
 
   /****************************************************************************/
@@ -45,6 +48,8 @@ public:
   virtual void OnLazyPoll() OVERRIDE;
 
 private:
+  void SetFixedConfig(const net::ProxyConfig& proxy_config);
+
   ThrustSession*                        parent_;
 
   ObserverList<Observer>                observers_;
@@ -3,6 +3,10 @@
 //
 #include "src/browser/session/thrust_session_visitedlink_store.h"
 
+#include <algorithm>
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
 #include "url/gurl.h"
 #include "content/public/browser/browser_thread.h"
 
@@ -11,8 +15,72 @@
 
 using namespace content;
 
+namespace {
+
+/* Number of URLs canonicalized and fingerprinted by each blocking pool task. */
+const size_t kFingerprintChunkSize = 4096;
+
+void
+ReplyOnUIThread(
+    const base::Closure& reply)
+{
+  BrowserThread::PostTask(BrowserThread::UI, FROM_HERE, reply);
+}
+
+}  // namespace
+
 namespace thrust_shell {
 
+/******************************************************************************/
+/* FINGERPRINT JOB */
+/******************************************************************************/
+
+// Holds a batch of URLs while they are fingerprinted on the blocking pool.
+// Each chunk task only writes its own slice of |fingerprints_| so no locking
+// is required, and the result is only read once all chunks are done.
+class ThrustSessionVisitedLinkStore::FingerprintJob 
+  : public base::RefCountedThreadSafe<FingerprintJob> {
+public:
+  FingerprintJob(const std::vector<std::string>& urls,
+                 const uint8 salt[LINK_SALT_LENGTH])
+  : urls_(urls),
+    fingerprints_(urls.size(), 
+                  visitedlink::VisitedLinkCommon::null_fingerprint_)
+  {
+    memcpy(salt_, salt, LINK_SALT_LENGTH * sizeof(uint8));
+  }
+
+  void
+  ComputeChunk(
+      size_t begin,
+      size_t end,
+      const base::Closure& done)
+  {
+    visitedlink::VisitedLinkMaster::ComputeURLFingerprints(
+        &urls_[begin], end - begin, salt_, &fingerprints_[begin]);
+    done.Run();
+  }
+
+  size_t size() const { return urls_.size(); }
+  const visitedlink::VisitedLinkCommon::Fingerprints& fingerprints() const {
+    return fingerprints_;
+  }
+
+private:
+  friend class base::RefCountedThreadSafe<FingerprintJob>;
+  ~FingerprintJob() {}
+
+  std::vector<std::string>                         urls_;
+  visitedlink::VisitedLinkCommon::Fingerprints     fingerprints_;
+  uint8                                            salt_[LINK_SALT_LENGTH];
+
+  DISALLOW_COPY_AND_ASSIGN(FingerprintJob);
+};
+
+/******************************************************************************/
+/* THRUST SESSION VISITEDLINK STORE */
+/******************************************************************************/
+
 ThrustSessionVisitedLinkStore::ThrustSessionVisitedLinkStore(
     ThrustSession* parent)
 : parent_(parent),
@@ -40,6 +108,46 @@ ThrustSessionVisitedLinkStore::Add(
   }
 }
 
+void
+ThrustSessionVisitedLinkStore::AddBatch(
+    const std::vector<std::string>& urls,
+    const base::Closure& callback)
+{
+  if(parent_->IsOffTheRecord() || urls.empty()) {
+    callback.Run();
+    return;
+  }
+
+  uint8 salt[LINK_SALT_LENGTH];
+  visitedlink_master_->GetSalt(salt);
+  scoped_refptr<FingerprintJob> job(new FingerprintJob(urls, salt));
+
+  StartFingerprintJob(
+      job, 
+      base::Bind(&ThrustSessionVisitedLinkStore::OnAddBatchFingerprinted,
+                 this, job, callback));
+}
+
+void
+ThrustSessionVisitedLinkStore::IsVisitedBatch(
+    const std::vector<std::string>& urls,
+    const IsVisitedCallback& callback)
+{
+  if(urls.empty()) {
+    callback.Run(std::vector<bool>());
+    return;
+  }
+
+  uint8 salt[LINK_SALT_LENGTH];
+  visitedlink_master_->GetSalt(salt);
+  scoped_refptr<FingerprintJob> job(new FingerprintJob(urls, salt));
+
+  StartFingerprintJob(
+      job, 
+      base::Bind(&ThrustSessionVisitedLinkStore::OnIsVisitedBatchFingerprinted,
+                 this, job, callback));
+}
+
 void
 ThrustSessionVisitedLinkStore::Clear()
 {
@@ -47,6 +155,53 @@ ThrustSessionVisitedLinkStore::Clear()
 }
 
 
+void
+ThrustSessionVisitedLinkStore::StartFingerprintJob(
+    const scoped_refptr<FingerprintJob>& job,
+    const base::Closure& reply)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+
+  size_t chunks = (job->size() + kFingerprintChunkSize - 1) / 
+    kFingerprintChunkSize;
+  /* The last chunk to complete posts the reply back to the UI thread. */
+  base::Closure done = base::BarrierClosure(
+      chunks, base::Bind(&ReplyOnUIThread, reply));
+
+  for(size_t begin = 0; begin < job->size(); begin += kFingerprintChunkSize) {
+    size_t end = std::min(begin + kFingerprintChunkSize, job->size());
+    BrowserThread::PostBlockingPoolTask(
+        FROM_HERE,
+        base::Bind(&FingerprintJob::ComputeChunk, job, begin, end, done));
+  }
+}
+
+void
+ThrustSessionVisitedLinkStore::OnAddBatchFingerprinted(
+    const scoped_refptr<FingerprintJob>& job,
+    const base::Closure& callback)
+{
+  /* Runs on UI thread. */
+  visitedlink_master_->AddFingerprints(job->fingerprints());
+  callback.Run();
+}
+
+void
+ThrustSessionVisitedLinkStore::OnIsVisitedBatchFingerprinted(
+    const scoped_refptr<FingerprintJob>& job,
+    const IsVisitedCallback& callback)
+{
+  /* Runs on UI thread. The table is only read here as the master may resize */
+  /* it on this thread at any time.                                          */
+  const visitedlink::VisitedLinkCommon::Fingerprints& fingerprints = 
+    job->fingerprints();
+  std::vector<bool> visited(fingerprints.size(), false);
+  for(size_t i = 0; i < fingerprints.size(); ++i) {
+    visited[i] = visitedlink_master_->IsVisited(fingerprints[i]);
+  }
+  callback.Run(visited);
+}
+
 void 
 ThrustSessionVisitedLinkStore::RebuildTable(
     const scoped_refptr<URLEnumerator>& enumerator)
@@ -5,7 +5,9 @@
 #define THRUST_SHELL_BROWSER_SESSION_THRUST_SESSION_VISITEDLINK_STORE_H_
 
 #include <string>
+#include <vector>
 
+#include "base/callback.h"
 #include "base/memory/scoped_ptr.h"
 #include "src/browser/visitedlink/visitedlink_delegate.h"
 
@@ -29,6 +31,9 @@ class ThrustSessionVisitedLinkStore
   : public visitedlink::VisitedLinkDelegate,
     public base::RefCountedThreadSafe<ThrustSessionVisitedLinkStore> {
 public:
+  typedef base::Callback<void(const std::vector<bool>& visited)> 
+    IsVisitedCallback;
+
   // ### ThrustSessionVisitedLinkStore
   // We keep a pointer to the parent ThrustSession to call into the JS API
   ThrustSessionVisitedLinkStore(ThrustSession* parent);
@@ -45,6 +50,28 @@ public:
   // ```
   void Add(const std::string& url);
 
+  // ### AddBatch
+  // Adds a set of URLs to the VisitedLink Store. URLs are canonicalized and
+  // fingerprinted in parallel on the blocking pool and inserted in one pass
+  // on the UI thread, resulting in a single update sent to the renderers.
+  // ```
+  // @urls     {vector<string>} the URLs to add
+  // @callback {Closure} called on the UI thread once the URLs are added
+  // ```
+  void AddBatch(const std::vector<std::string>& urls,
+                const base::Closure& callback);
+
+  // ### IsVisitedBatch
+  // Checks whether each of the URLs is in the VisitedLink Store. URLs are
+  // canonicalized and fingerprinted on the blocking pool.
+  // ```
+  // @urls     {vector<string>} the URLs to check
+  // @callback {IsVisitedCallback} called on the UI thread with one entry per
+  //           URL, in order
+  // ```
+  void IsVisitedBatch(const std::vector<std::string>& urls,
+                      const IsVisitedCallback& callback);
+
   // ### Clear
   // Clears all VisitedLinks and destroys the file system storage as well
   void Clear();
@@ -56,8 +83,20 @@ public:
       const scoped_refptr<URLEnumerator>& enumerator) OVERRIDE;
 
 private:
+  class FingerprintJob;
+
   virtual ~ThrustSessionVisitedLinkStore();
 
+  // Splits the job in chunks processed in parallel on the blocking pool and
+  // runs |reply| on the UI thread once all of them are done.
+  void StartFingerprintJob(const scoped_refptr<FingerprintJob>& job,
+                           const base::Closure& reply);
+
+  void OnAddBatchFingerprinted(const scoped_refptr<FingerprintJob>& job,
+                               const base::Closure& callback);
+  void OnIsVisitedBatchFingerprinted(const scoped_refptr<FingerprintJob>& job,
+                                     const IsVisitedCallback& callback);
+
   ThrustSession*                                parent_;
   scoped_ptr<visitedlink::VisitedLinkMaster> visitedlink_master_;
 
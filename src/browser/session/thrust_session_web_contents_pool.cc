@@ -0,0 +1,270 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/session/thrust_session_web_contents_pool.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_process_host.h"
+#include "content/public/browser/site_instance.h"
+#include "content/public/browser/web_contents.h"
+#include "content/public/common/url_constants.h"
+
+#include "src/browser/session/thrust_session.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+namespace {
+
+/* Pools never keep more than this many processes ready per kind. */
+const size_t kMaxPoolSize = 8;
+/* Entries are created one per task, this long after a claim so that a */
+/* burst of creations is not slowed down by the refill.                */
+const int kRefillDelayMs = 100;
+
+void
+PaintsToValue(
+    int count,
+    base::TimeDelta total,
+    base::DictionaryValue* paints)
+{
+  paints->SetInteger("count", count);
+  paints->SetDouble("mean_ms",
+                    count > 0 ? total.InMillisecondsF() / count : 0.0);
+}
+
+}
+
+ThrustSessionWebContentsPool::ThrustSessionWebContentsPool(
+    ThrustSession* session)
+: session_(session),
+  guest_site_(base::StringPrintf("%s://webview", kGuestScheme)),
+  refill_pending_(false),
+  weak_factory_(this)
+{
+}
+
+ThrustSessionWebContentsPool::~ThrustSessionWebContentsPool()
+{
+  pools_[KIND_WINDOW].size = 0;
+  pools_[KIND_GUEST].size = 0;
+  Trim(KIND_WINDOW);
+  Trim(KIND_GUEST);
+}
+
+void
+ThrustSessionWebContentsPool::SetSize(
+    size_t windows,
+    size_t guests)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  pools_[KIND_WINDOW].size = std::min(windows, kMaxPoolSize);
+  pools_[KIND_GUEST].size = std::min(guests, kMaxPoolSize);
+  Trim(KIND_WINDOW);
+  Trim(KIND_GUEST);
+  ScheduleRefill();
+}
+
+WebContents*
+ThrustSessionWebContentsPool::CreateWindowContents(
+    bool* warm)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  Pool& pool = pools_[KIND_WINDOW];
+  *warm = false;
+
+  WebContents* web_contents = NULL;
+  while(!pool.contents.empty() && !web_contents) {
+    web_contents = pool.contents.front();
+    pool.contents.pop_front();
+    if(!web_contents->GetRenderProcessHost()->HasConnection()) {
+      /* The process died while idle. */
+      delete web_contents;
+      web_contents = NULL;
+      pool.discarded++;
+    }
+  }
+
+  if(web_contents) {
+    *warm = true;
+    pool.hits++;
+  }
+  else {
+    web_contents = WebContents::Create(WebContents::CreateParams(session_));
+    if(pool.size > 0)
+      pool.misses++;
+  }
+
+  ScheduleRefill();
+  return web_contents;
+}
+
+scoped_refptr<SiteInstance>
+ThrustSessionWebContentsPool::CreateGuestSiteInstance(
+    bool* warm)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  Pool& pool = pools_[KIND_GUEST];
+  *warm = false;
+
+  scoped_refptr<SiteInstance> site_instance;
+  while(!pool.sites.empty() && !site_instance.get()) {
+    site_instance = pool.sites.front();
+    pool.sites.pop_front();
+    if(!IsAlive(site_instance.get())) {
+      Release(site_instance.get());
+      site_instance = NULL;
+      pool.discarded++;
+    }
+  }
+
+  if(site_instance.get()) {
+    *warm = true;
+    pool.hits++;
+  }
+  else {
+    site_instance = SiteInstance::CreateForURL(session_, guest_site_);
+    if(pool.size > 0)
+      pool.misses++;
+  }
+
+  ScheduleRefill();
+  return site_instance;
+}
+
+void
+ThrustSessionWebContentsPool::RecordFirstPaint(
+    Kind kind,
+    bool warm,
+    base::TimeDelta delay)
+{
+  Paints& paints = warm ? pools_[kind].warm : pools_[kind].cold;
+  paints.count++;
+  paints.total += delay;
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustSessionWebContentsPool::GetStats() const
+{
+  scoped_ptr<base::DictionaryValue> stats(new base::DictionaryValue);
+  for(int kind = 0; kind < KIND_COUNT; ++kind) {
+    const Pool& pool = pools_[kind];
+    base::DictionaryValue* pool_v = new base::DictionaryValue;
+    pool_v->SetInteger("size", pool.size);
+    pool_v->SetInteger("idle", IdleCount(static_cast<Kind>(kind)));
+    pool_v->SetInteger("hits", pool.hits);
+    pool_v->SetInteger("misses", pool.misses);
+    pool_v->SetInteger("discarded", pool.discarded);
+
+    base::DictionaryValue* warm_v = new base::DictionaryValue;
+    PaintsToValue(pool.warm.count, pool.warm.total, warm_v);
+    pool_v->Set("warm", warm_v);
+    base::DictionaryValue* cold_v = new base::DictionaryValue;
+    PaintsToValue(pool.cold.count, pool.cold.total, cold_v);
+    pool_v->Set("cold", cold_v);
+
+    stats->Set(kind == KIND_WINDOW ? "windows" : "guests", pool_v);
+  }
+  return stats.Pass();
+}
+
+size_t
+ThrustSessionWebContentsPool::IdleCount(
+    Kind kind) const
+{
+  return kind == KIND_WINDOW ? pools_[kind].contents.size() :
+                               pools_[kind].sites.size();
+}
+
+void
+ThrustSessionWebContentsPool::Trim(
+    Kind kind)
+{
+  Pool& pool = pools_[kind];
+  while(pool.contents.size() > pool.size) {
+    delete pool.contents.back();
+    pool.contents.pop_back();
+  }
+  while(pool.sites.size() > pool.size) {
+    Release(pool.sites.back().get());
+    pool.sites.pop_back();
+  }
+}
+
+void
+ThrustSessionWebContentsPool::ScheduleRefill()
+{
+  if(refill_pending_)
+    return;
+  if(IdleCount(KIND_WINDOW) >= pools_[KIND_WINDOW].size &&
+     IdleCount(KIND_GUEST) >= pools_[KIND_GUEST].size)
+    return;
+  refill_pending_ = true;
+  base::MessageLoop::current()->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&ThrustSessionWebContentsPool::Refill,
+                 weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kRefillDelayMs));
+}
+
+void
+ThrustSessionWebContentsPool::Refill()
+{
+  refill_pending_ = false;
+
+  /* A single entry is created per task to keep the UI thread responsive. */
+  Pool& windows = pools_[KIND_WINDOW];
+  Pool& guests = pools_[KIND_GUEST];
+  if(windows.contents.size() < windows.size) {
+    /* The site of the SiteInstance is set by the first navigation. */
+    scoped_refptr<SiteInstance> site_instance = SpawnSiteInstance(GURL());
+    windows.contents.push_back(WebContents::Create(
+        WebContents::CreateParams(session_, site_instance.get())));
+  }
+  else if(guests.sites.size() < guests.size) {
+    guests.sites.push_back(SpawnSiteInstance(guest_site_));
+  }
+
+  ScheduleRefill();
+}
+
+scoped_refptr<SiteInstance>
+ThrustSessionWebContentsPool::SpawnSiteInstance(
+    const GURL& site)
+{
+  scoped_refptr<SiteInstance> site_instance = site.is_empty() ?
+    SiteInstance::Create(session_) :
+    SiteInstance::CreateForURL(session_, site);
+  /* Launches the renderer process asynchronously (process launcher). */
+  site_instance->GetProcess()->Init();
+  return site_instance;
+}
+
+// static
+bool
+ThrustSessionWebContentsPool::IsAlive(
+    SiteInstance* site_instance)
+{
+  return site_instance->HasProcess() &&
+         site_instance->GetProcess()->HasConnection();
+}
+
+// static
+void
+ThrustSessionWebContentsPool::Release(
+    SiteInstance* site_instance)
+{
+  /* Spare processes have no view to remove, which would otherwise clean */
+  /* them up. Cleanup is a no-op if the process got other listeners.     */
+  if(site_instance->HasProcess())
+    site_instance->GetProcess()->Cleanup();
+}
+
+} // namespace thrust_shell
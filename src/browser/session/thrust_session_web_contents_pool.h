@@ -0,0 +1,147 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_SESSION_THRUST_SESSION_WEB_CONTENTS_POOL_H_
+#define THRUST_SHELL_BROWSER_SESSION_THRUST_SESSION_WEB_CONTENTS_POOL_H_
+
+#include <deque>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "url/gurl.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace content {
+class SiteInstance;
+class WebContents;
+}
+
+namespace thrust_shell {
+
+class ThrustSession;
+
+// ### ThrustSessionWebContentsPool
+//
+// Keeps renderer processes spawned ahead of time for a ThrustSession so that
+// window and <webview> guest creation does not pay for the process launch
+// and renderer initialization on its critical path:
+// - windows claim a WebContents created on a SiteInstance whose process is
+//   already launched. The SiteInstance has no site yet, so that the first
+//   navigation (whatever its URL) is committed in that process.
+// - guests claim a guest SiteInstance whose process is already launched (the
+//   guest WebContents itself depends on its WebViewGuest delegate and can't
+//   be created ahead of time).
+//
+// The pool is refilled in the background after each claim. Entries whose
+// process died while idle are discarded when claimed. Empty pools (the
+// default) fall back to a regular (cold) creation.
+//
+// The pool also aggregates the create-to-first-paint latency of warm and cold
+// creations to measure its effect.
+//
+// The pool is owned by its session and lives on the UI thread.
+class ThrustSessionWebContentsPool {
+public:
+  enum Kind {
+    KIND_WINDOW = 0,
+    KIND_GUEST,
+    KIND_COUNT
+  };
+
+  explicit ThrustSessionWebContentsPool(ThrustSession* session);
+  ~ThrustSessionWebContentsPool();
+
+  // ### SetSize
+  // ```
+  // @windows {size_t} the number of WebContents kept ready for windows
+  // @guests  {size_t} the number of processes kept ready for guests
+  // ```
+  // Extra idle entries are released immediately, missing ones are created in
+  // the background.
+  void SetSize(size_t windows, size_t guests);
+
+  // ### CreateWindowContents
+  // ```
+  // @warm {bool} set to whether the WebContents came from the pool
+  // ```
+  // Returns a new WebContents for a window, owned by the caller.
+  content::WebContents* CreateWindowContents(bool* warm);
+
+  // ### CreateGuestSiteInstance
+  // ```
+  // @warm {bool} set to whether the SiteInstance came from the pool
+  // ```
+  // Returns a SiteInstance for a new guest WebContents.
+  scoped_refptr<content::SiteInstance> CreateGuestSiteInstance(bool* warm);
+
+  // ### RecordFirstPaint
+  // ```
+  // @kind  {Kind} window or guest
+  // @warm  {bool} whether the creation was served by the pool
+  // @delay {TimeDelta} the create-to-first-paint latency
+  // ```
+  void RecordFirstPaint(Kind kind, bool warm, base::TimeDelta delay);
+
+  // ### GetStats
+  // Returns, for `windows` and `guests`, the pool `size`, the `idle` entries,
+  // the `hits`, `misses` and `discarded` counts and the `warm` and `cold`
+  // first paint `count` and `mean_ms`.
+  scoped_ptr<base::DictionaryValue> GetStats() const;
+
+private:
+  struct Paints {
+    Paints()
+    : count(0) {}
+
+    int                count;
+    base::TimeDelta    total;
+  };
+
+  struct Pool {
+    Pool()
+    : size(0),
+      hits(0),
+      misses(0),
+      discarded(0) {}
+
+    size_t                                            size;
+    std::deque<content::WebContents*>                 contents;
+    std::deque<scoped_refptr<content::SiteInstance> > sites;
+    int                                               hits;
+    int                                               misses;
+    int                                               discarded;
+    Paints                                            warm;
+    Paints                                            cold;
+  };
+
+  size_t IdleCount(Kind kind) const;
+  void Trim(Kind kind);
+  void ScheduleRefill();
+  void Refill();
+
+  scoped_refptr<content::SiteInstance> SpawnSiteInstance(const GURL& site);
+  static bool IsAlive(content::SiteInstance* site_instance);
+  static void Release(content::SiteInstance* site_instance);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  ThrustSession*                                    session_;
+  Pool                                              pools_[KIND_COUNT];
+  GURL                                              guest_site_;
+  bool                                              refill_pending_;
+
+  base::WeakPtrFactory<ThrustSessionWebContentsPool> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustSessionWebContentsPool);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_SESSION_THRUST_SESSION_WEB_CONTENTS_POOL_H_
@@ -0,0 +1,187 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/thrust_registry.h"
+
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_view_host.h"
+#include "content/public/browser/web_contents.h"
+
+#include "src/browser/session/thrust_session.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+// static
+ThrustRegistry*
+ThrustRegistry::GetInstance()
+{
+  return Singleton<ThrustRegistry>::get();
+}
+
+ThrustRegistry::ThrustRegistry()
+{
+}
+
+ThrustRegistry::~ThrustRegistry()
+{
+}
+
+/******************************************************************************/
+/* WINDOWS */
+/******************************************************************************/
+void
+ThrustRegistry::AddWindow(
+    ThrustWindow* window,
+    WebContents* web_contents)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  RemoveWindow(window);
+  windows_[web_contents] = window;
+  window_contents_[window] = web_contents;
+}
+
+void
+ThrustRegistry::RemoveWindow(
+    ThrustWindow* window)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  base::hash_map<ThrustWindow*, WebContents*>::iterator it =
+    window_contents_.find(window);
+  if(it == window_contents_.end())
+    return;
+  windows_.erase(it->second);
+  window_contents_.erase(it);
+}
+
+ThrustWindow*
+ThrustRegistry::WindowForWebContents(
+    WebContents* web_contents)
+{
+  base::hash_map<WebContents*, ThrustWindow*>::iterator it =
+    windows_.find(web_contents);
+  return it == windows_.end() ? NULL : it->second;
+}
+
+ThrustWindow*
+ThrustRegistry::WindowForRenderView(
+    int process_id,
+    int routing_id)
+{
+  /* RenderViewHost::FromID is itself an indexed lookup. Going through the */
+  /* RenderViewHost keeps the index valid across render view swaps.        */
+  RenderViewHost* rvh = RenderViewHost::FromID(process_id, routing_id);
+  if(!rvh)
+    return NULL;
+  WebContents* web_contents = WebContents::FromRenderViewHost(rvh);
+  if(!web_contents || web_contents->GetRenderViewHost() != rvh)
+    return NULL;
+  return WindowForWebContents(web_contents);
+}
+
+/******************************************************************************/
+/* SESSIONS */
+/******************************************************************************/
+void
+ThrustRegistry::AddSession(
+    ThrustSession* session)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  sessions_[session] = session;
+}
+
+void
+ThrustRegistry::RemoveSession(
+    ThrustSession* session)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  sessions_.erase(session);
+}
+
+ThrustSession*
+ThrustRegistry::SessionForBrowserContext(
+    BrowserContext* browser_context)
+{
+  base::hash_map<BrowserContext*, ThrustSession*>::iterator it =
+    sessions_.find(browser_context);
+  return it == sessions_.end() ? NULL : it->second;
+}
+
+/******************************************************************************/
+/* GUESTS */
+/******************************************************************************/
+void
+ThrustRegistry::AddGuest(
+    WebViewGuest* guest,
+    WebContents* web_contents)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  RemoveGuest(guest);
+  guests_[web_contents] = guest;
+  guest_contents_[guest] = web_contents;
+}
+
+void
+ThrustRegistry::SetGuestEmbedder(
+    WebViewGuest* guest,
+    WebContents* embedder)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(guest_contents_.find(guest) == guest_contents_.end())
+    return;
+
+  base::hash_map<WebViewGuest*, WebContents*>::iterator it =
+    guest_embedders_.find(guest);
+  if(it != guest_embedders_.end()) {
+    std::set<WebViewGuest*>& guests = embedder_guests_[it->second];
+    guests.erase(guest);
+    if(guests.empty())
+      embedder_guests_.erase(it->second);
+    guest_embedders_.erase(it);
+  }
+
+  if(embedder) {
+    guest_embedders_[guest] = embedder;
+    embedder_guests_[embedder].insert(guest);
+  }
+}
+
+void
+ThrustRegistry::RemoveGuest(
+    WebViewGuest* guest)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  SetGuestEmbedder(guest, NULL);
+
+  base::hash_map<WebViewGuest*, WebContents*>::iterator it =
+    guest_contents_.find(guest);
+  if(it == guest_contents_.end())
+    return;
+  guests_.erase(it->second);
+  guest_contents_.erase(it);
+}
+
+WebViewGuest*
+ThrustRegistry::GuestForWebContents(
+    WebContents* web_contents)
+{
+  base::hash_map<WebContents*, WebViewGuest*>::iterator it =
+    guests_.find(web_contents);
+  return it == guests_.end() ? NULL : it->second;
+}
+
+void
+ThrustRegistry::GuestsForEmbedder(
+    WebContents* embedder,
+    std::vector<WebViewGuest*>* guests)
+{
+  guests->clear();
+  base::hash_map<WebContents*, std::set<WebViewGuest*> >::iterator it =
+    embedder_guests_.find(embedder);
+  if(it == embedder_guests_.end())
+    return;
+  guests->assign(it->second.begin(), it->second.end());
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,134 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_THRUST_REGISTRY_H_
+#define THRUST_SHELL_BROWSER_THRUST_REGISTRY_H_
+
+#include <set>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/memory/singleton.h"
+
+namespace content {
+class BrowserContext;
+class WebContents;
+}
+
+namespace thrust_shell {
+
+class ThrustSession;
+class ThrustWindow;
+class WebViewGuest;
+
+// ### ThrustRegistry
+//
+// Central index of the live ThrustWindow, ThrustSession and WebViewGuest
+// objects, used on every IPC received for a window or a guest:
+// - windows are indexed by their WebContents (and through it by the
+//   `(process_id, routing_id)` of their render view).
+// - sessions are indexed by their BrowserContext.
+// - guests are indexed by their WebContents and grouped by embedder.
+//
+// Objects register themselves on construction and unregister on destruction.
+// Lives on the UI thread.
+class ThrustRegistry {
+public:
+  static ThrustRegistry* GetInstance();
+
+  /****************************************************************************/
+  /* WINDOWS */
+  /****************************************************************************/
+  // ### AddWindow
+  // ```
+  // @window       {ThrustWindow} the window to register
+  // @web_contents {WebContents} the window main WebContents
+  // ```
+  void AddWindow(ThrustWindow* window,
+                 content::WebContents* web_contents);
+  // ### RemoveWindow
+  // Unregisters |window|, it is safe to call it more than once.
+  void RemoveWindow(ThrustWindow* window);
+
+  // ### WindowForWebContents
+  // Returns the window whose main WebContents is |web_contents| or NULL.
+  ThrustWindow* WindowForWebContents(content::WebContents* web_contents);
+  // ### WindowForRenderView
+  // ```
+  // @process_id {int} the render process id
+  // @routing_id {int} the render view routing id
+  // ```
+  // Returns the window hosting the render view or NULL.
+  ThrustWindow* WindowForRenderView(int process_id, int routing_id);
+
+  /****************************************************************************/
+  /* SESSIONS */
+  /****************************************************************************/
+  void AddSession(ThrustSession* session);
+  void RemoveSession(ThrustSession* session);
+
+  // ### SessionForBrowserContext
+  // Returns the ThrustSession wrapping |browser_context| or NULL.
+  ThrustSession* SessionForBrowserContext(
+      content::BrowserContext* browser_context);
+
+  /****************************************************************************/
+  /* GUESTS */
+  /****************************************************************************/
+  // ### AddGuest
+  // ```
+  // @guest        {WebViewGuest} the guest to register
+  // @web_contents {WebContents} the guest WebContents
+  // ```
+  void AddGuest(WebViewGuest* guest,
+                content::WebContents* web_contents);
+  // ### SetGuestEmbedder
+  // ```
+  // @guest    {WebViewGuest} a registered guest
+  // @embedder {WebContents} its new embedder (NULL when detached)
+  // ```
+  void SetGuestEmbedder(WebViewGuest* guest,
+                        content::WebContents* embedder);
+  // ### RemoveGuest
+  // Unregisters |guest|, it is safe to call it more than once.
+  void RemoveGuest(WebViewGuest* guest);
+
+  // ### GuestForWebContents
+  // Returns the guest whose WebContents is |web_contents| or NULL.
+  WebViewGuest* GuestForWebContents(content::WebContents* web_contents);
+  // ### GuestsForEmbedder
+  // ```
+  // @embedder {WebContents} the embedder WebContents
+  // @guests   {vector<WebViewGuest*>} filled with the guests of |embedder|
+  // ```
+  // The guests are copied so that they can be destroyed while iterated.
+  void GuestsForEmbedder(content::WebContents* embedder,
+                         std::vector<WebViewGuest*>* guests);
+
+private:
+  friend struct DefaultSingletonTraits<ThrustRegistry>;
+
+  ThrustRegistry();
+  ~ThrustRegistry();
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  base::hash_map<content::WebContents*, ThrustWindow*>        windows_;
+  base::hash_map<ThrustWindow*, content::WebContents*>        window_contents_;
+
+  base::hash_map<content::BrowserContext*, ThrustSession*>    sessions_;
+
+  base::hash_map<content::WebContents*, WebViewGuest*>        guests_;
+  base::hash_map<WebViewGuest*, content::WebContents*>        guest_contents_;
+  base::hash_map<WebViewGuest*, content::WebContents*>        guest_embedders_;
+  base::hash_map<content::WebContents*, std::set<WebViewGuest*> >
+                                                              embedder_guests_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustRegistry);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_THRUST_REGISTRY_H_
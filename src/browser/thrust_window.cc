@@ -3,7 +3,10 @@
 
 #include "src/browser/thrust_window.h"
 
+#include <algorithm>
+
 #include "base/auto_reset.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
@@ -11,10 +14,6 @@
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
-#include "base/threading/thread_restrictions.h"
-#include "base/file_util.h"
-#include "ui/gfx/codec/png_codec.h"
-#include "ui/gfx/codec/jpeg_codec.h"
 #include "content/public/common/url_constants.h"
 #include "content/public/common/content_switches.h"
 #include "content/public/common/renderer_preferences.h"
@@ -30,6 +29,7 @@
 #include "content/public/browser/navigation_controller.h"
 #include "content/public/browser/favicon_status.h"
 #include "third_party/WebKit/public/web/WebFindOptions.h"
+#include "third_party/skia/include/core/SkRegion.h"
 
 #include "src/common/switches.h"
 #include "src/browser/browser_main_parts.h"
@@ -38,11 +38,13 @@
 #include "src/browser/dialog/web_dialog_helper.h"
 #include "src/browser/web_view/web_view_guest.h"
 #include "src/browser/session/thrust_session.h"
+#include "src/browser/thrust_registry.h"
 #include "src/common/messages.h"
 #include "src/browser/ui/views/menu_bar.h"
 #include "src/browser/ui/views/menu_layout.h"
 #include "src/api/thrust_window_binding.h"
 #include "src/browser/dialog/browser_dialogs.h"
+#include "src/browser/util/icon_cache.h"
 
 #if defined(USE_X11)
 #include "src/browser/ui/views/global_menu_bar_x11.h"
@@ -53,6 +55,24 @@ using namespace content;
 
 namespace thrust_shell {
 
+namespace {
+
+/* Guest instance IDs are reserved for the embedder renderer by ranges of */
+/* this size.                                                             */
+const int kWebViewInstanceIDsRange = 16;
+
+/* <webview> events are flushed to the embedder once per frame, or as soon */
+/* as a batch is full.                                                     */
+const int kWebViewEventsFlushDelayMs = 16;
+const size_t kWebViewEventsMaxBatch = 128;
+
+/* Events reflecting a state, superseded by the next event of their type. */
+const char* kCoalescedWebViewEvents[] = {
+  "size-changed", "zoom-changed", "title-set", "network-usage"
+};
+
+}
+
 std::vector<ThrustWindow*> ThrustWindow::s_instances;
 
 /******************************************************************************/
@@ -64,14 +84,21 @@ ThrustWindow::ThrustWindow(
     const gfx::Size& size,
     const std::string& title,
     const std::string& icon_path,
-    const bool has_frame)
+    const bool has_frame,
+    const bool headless)
   : WebContentsObserver(web_contents),
     binding_(binding),
     is_closed_(false),
     title_(title),
-    has_frame_(has_frame),
+    has_frame_(has_frame && !headless),
+    headless_(headless),
+    prewarmed_(false),
+    background_(false),
+    backgrounded_(false),
+    web_view_flush_pending_(false),
     inspectable_web_contents_(
-        brightray::InspectableWebContents::Create(web_contents))
+        brightray::InspectableWebContents::Create(web_contents)),
+    weak_factory_(this)
 {
   web_contents->SetDelegate(this);
   inspectable_web_contents()->SetDelegate(this);
@@ -81,29 +108,6 @@ ThrustWindow::ThrustWindow(
   registrar_.Add(this, NOTIFICATION_WEB_CONTENTS_TITLE_UPDATED,
                  Source<WebContents>(web_contents));
 
-  /* Set the icon for the window before it gets displayed. We exceptionally */
-  /* allow IO on this thread (UI) to load the PNG image.                    */
-  base::ThreadRestrictions::SetIOAllowed(true);
-  gfx::Image icon;
-  base::FilePath p = base::FilePath::FromUTF8Unsafe(icon_path);
-  // Read the file from disk.
-  std::string file_contents;
-  if(!p.empty() && base::ReadFileToString(p, &file_contents)) {
-    // Decode the bitmap using WebKit's image decoder.
-    const unsigned char* data =
-      reinterpret_cast<const unsigned char*>(file_contents.data());
-    size_t size = file_contents.size();
-    scoped_ptr<SkBitmap> decoded(new SkBitmap());
-
-    if(!gfx::PNGCodec::Decode(data, size, decoded.get())) {
-      decoded.reset(gfx::JPEGCodec::Decode(data, size));                             
-    }
-    if(decoded) {                                                                   
-      icon_.AddRepresentation(gfx::ImageSkiaRep(
-            *decoded.release(), 1.0f));     
-    }                                  
-  }
-  base::ThreadRestrictions::SetIOAllowed(false);
 
   /*
   renderer_preferences_util::UpdateFromSystemSettings(
@@ -112,8 +116,23 @@ ThrustWindow::ThrustWindow(
    */
   PlatformCreateWindow(size);
 
+  /* Headless windows are never shown but their renderer is kept visible so */
+  /* that it keeps painting frames, only accessible through capture.        */
+  if(headless_) {
+    web_contents->WasShown();
+    timeline_.Mark(ThrustCreateTimeline::PHASE_SHOWN);
+  }
+
+  /* The window is displayed without icon, which is set once decoded off */
+  /* the UI thread (or immediately retrieved from the shared cache).     */
+  ThrustIconCache::GetInstance()->Load(
+      base::FilePath::FromUTF8Unsafe(icon_path),
+      base::Bind(&ThrustWindow::OnIconLoaded, weak_factory_.GetWeakPtr()));
+
   LOG(INFO) << "ThrustWindow Constructor [" << web_contents << "]";
   s_instances.push_back(this);
+  ThrustRegistry::GetInstance()->AddWindow(this, web_contents);
+  timeline_.Mark(ThrustCreateTimeline::PHASE_CONSTRUCTED);
 }
 
 ThrustWindow::~ThrustWindow() 
@@ -122,6 +141,7 @@ ThrustWindow::~ThrustWindow()
 
   CloseImmediately();
   PlatformCleanUp();
+  ThrustRegistry::GetInstance()->RemoveWindow(this);
 
   for(size_t i = 0; i < s_instances.size(); ++i) {
     if (s_instances[i] == this) {
@@ -142,11 +162,12 @@ ThrustWindow::CreateNew(
     const gfx::Size& size,
     const std::string& title,
     const std::string& icon_path,
-    const bool has_frame)
+    const bool has_frame,
+    const bool headless)
 {
   ThrustWindow *browser = new ThrustWindow(binding, web_contents, size, 
                                            title, icon_path, 
-                                           has_frame);
+                                           has_frame, headless);
   return browser;
 }
 
@@ -159,14 +180,19 @@ ThrustWindow::CreateNew(
     const gfx::Size& size,
     const std::string& title,
     const std::string& icon_path,
-    const bool has_frame)
+    const bool has_frame,
+    const bool headless)
 {
   LOG(INFO) << "ThrustWindow CreateNew";
   if(session == NULL) {
     session = ThrustShellBrowserClient::Get()->system_session();
   }
-  WebContents::CreateParams create_params((BrowserContext*)session);
-  WebContents* web_contents = WebContents::Create(create_params);
+  base::TimeTicks create_time = base::TimeTicks::Now();
+  /* The WebContents renderer process is already launched if it comes from */
+  /* the session pool.                                                     */
+  bool prewarmed = false;
+  WebContents* web_contents = 
+    session->GetWebContentsPool()->CreateWindowContents(&prewarmed);
   
   NavigationController::LoadURLParams params(root_url);
   params.transition_type = PageTransitionFromInt(
@@ -176,8 +202,11 @@ ThrustWindow::CreateNew(
   LOG(INFO) << "ThrustWindow Constructor (web_contents created) [" 
             << web_contents << "]";
 
-  return CreateNew(binding, web_contents, size, title, icon_path, 
-                   has_frame);
+  ThrustWindow* window = CreateNew(binding, web_contents, size, title, 
+                                   icon_path, has_frame, headless);
+  window->timeline_.SetReceived(create_time);
+  window->prewarmed_ = prewarmed;
+  return window;
 }
 
 // static
@@ -186,19 +215,8 @@ ThrustWindow::FromRenderView(
     int process_id, 
     int routing_id) 
 {
-  std::vector<ThrustWindow*> windows = ThrustWindow::instances();
-  
-  for(std::vector<ThrustWindow*>::iterator it = windows.begin(); 
-      it != windows.end(); ++it) {
-    ThrustWindow* w = *it;
-    content::WebContents* web_contents = w->GetWebContents();
-    int window_process_id = web_contents->GetRenderProcessHost()->GetID();
-    int window_routing_id = web_contents->GetRoutingID();
-    if(window_routing_id == routing_id && window_process_id == process_id) {
-      return w;
-    }
-  }
-  return NULL;
+  return ThrustRegistry::GetInstance()->WindowForRenderView(process_id,
+                                                            routing_id);
 }
 
 
@@ -212,6 +230,36 @@ ThrustWindow::CloseAll()
   }
 }
 
+// static
+void
+ThrustWindow::AccountNetworkUsage(
+    const ThrustShellNetworkUsageMap& usage)
+{
+  for(ThrustShellNetworkUsageMap::const_iterator it = usage.begin();
+      it != usage.end(); ++it) {
+    /* The frame may be gone since the usage was recorded. */
+    RenderFrameHost* rfh = 
+      RenderFrameHost::FromID(it->first.first, it->first.second);
+    if(!rfh)
+      continue;
+    WebContents* web_contents = WebContents::FromRenderFrameHost(rfh);
+    if(!web_contents)
+      continue;
+
+    WebViewGuest* guest = WebViewGuest::FromWebContents(web_contents);
+    if(guest) {
+      /* Also accounted to its embedding window. */
+      guest->AddNetworkUsage(it->second);
+      continue;
+    }
+    ThrustWindow* window =
+      ThrustRegistry::GetInstance()->WindowForWebContents(web_contents);
+    if(window) {
+      window->AddNetworkUsage(it->second);
+    }
+  }
+}
+
 /******************************************************************************/
 /* PUBLIC INTERFACE */
 /******************************************************************************/
@@ -293,6 +341,40 @@ ThrustWindow::GetWebContents() const {
   return inspectable_web_contents()->GetWebContents();
 }
 
+void
+ThrustWindow::SetBackground(
+    bool background)
+{
+  background_ = background;
+  UpdateBackgroundState();
+}
+
+void
+ThrustWindow::UpdateBackgroundState()
+{
+  if(is_closed_ || !GetWebContents())
+    return;
+
+  /* Headless windows are never minimized but only rendered for capture, */
+  /* they are throttled only on request.                                 */
+  bool backgrounded = background_ || (!headless_ && PlatformIsMinimized());
+  bool changed = (backgrounded != backgrounded_);
+  backgrounded_ = backgrounded;
+  if(changed) {
+    LOG(INFO) << "ThrustWindow Background [" << this << "] " << backgrounded_;
+  }
+
+  if(backgrounded_) {
+    /* Re-applied on every platform visibility change: showing the native */
+    /* window shows the renderer again (WasHidden is a no-op otherwise).  */
+    GetWebContents()->WasHidden();
+  }
+  else if(changed && (headless_ || PlatformIsVisible())) {
+    /* A window not shown yet gets its renderer shown along with it. */
+    GetWebContents()->WasShown();
+  }
+}
+
 /******************************************************************************/
 /* WEBCONTENTSDELEGATE IMPLEMENTATION */
 /******************************************************************************/
@@ -459,7 +541,7 @@ ThrustWindow::OnMessageReceived(
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(ThrustWindow, message)
     IPC_MESSAGE_HANDLER(ThrustViewHostMsg_UpdateDraggableRegions,
-                        PlatformUpdateDraggableRegions)
+                        UpdateDraggableRegions)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -473,6 +555,8 @@ ThrustWindow::OnMessageReceived(
 {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(ThrustWindow, message)
+    IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewReserveInstanceIDs,
+                        WebViewReserveInstanceIDs)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_CreateWebViewGuest,
                         CreateWebViewGuest)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_DestroyWebViewGuest,
@@ -489,10 +573,16 @@ ThrustWindow::OnMessageReceived(
                         WebViewGuestStop)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestSetZoom,
                         WebViewGuestSetZoom)
+    IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestSetPriority,
+                        WebViewGuestSetPriority)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestFind,
                         WebViewGuestFind)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestStopFinding,
                         WebViewGuestStopFinding)
+    IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestCapture,
+                        WebViewGuestCapture)
+    IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestReleaseCapture,
+                        WebViewGuestReleaseCapture)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestInsertCSS,
                         WebViewGuestInsertCSS)
     IPC_MESSAGE_HANDLER(ThrustFrameHostMsg_WebViewGuestExecuteScript,
@@ -514,33 +604,130 @@ ThrustWindow::OnMessageReceived(
   return handled;
 }
 
+void
+ThrustWindow::DidCommitProvisionalLoadForFrame(
+    RenderFrameHost* render_frame_host,
+    const GURL& url,
+    PageTransition transition_type)
+{
+  if(!render_frame_host->GetParent())
+    timeline_.Mark(ThrustCreateTimeline::PHASE_COMMITTED);
+}
+
+void
+ThrustWindow::DidFirstVisuallyNonEmptyPaint()
+{
+  if(timeline_.HasMark(ThrustCreateTimeline::PHASE_FIRST_PAINT))
+    return;
+  timeline_.Mark(ThrustCreateTimeline::PHASE_FIRST_PAINT);
+
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        GetWebContents()->GetBrowserContext());
+  if(session) {
+    session->GetWebContentsPool()->RecordFirstPaint(
+        ThrustSessionWebContentsPool::KIND_WINDOW, prewarmed_,
+        timeline_.Elapsed(ThrustCreateTimeline::PHASE_FIRST_PAINT));
+    session->RecordCreateTimeline(false, timeline_);
+  }
+
+  scoped_ptr<base::DictionaryValue> timing = timeline_.ToValue();
+  timing->SetBoolean("prewarmed", prewarmed_);
+  binding_->EmitTiming(*timing);
+}
+
+void
+ThrustWindow::RenderFrameCreated(
+    RenderFrameHost* render_frame_host)
+{
+  /* Main frames get their guest instance IDs before running any script */
+  /* (including the main frames created by cross-process navigations).  */
+  if(!render_frame_host->GetParent()) {
+    SendWebViewInstanceIDs(render_frame_host);
+  }
+}
+
+void
+ThrustWindow::RenderFrameHostChanged(
+    RenderFrameHost* old_host,
+    RenderFrameHost* new_host)
+{
+  /* The IDs left to a swapped out main frame can't be used anymore. */
+  if(old_host && !old_host->GetParent()) {
+    ThrustSession* session = 
+      ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+          web_contents()->GetBrowserContext());
+    if(session) {
+      session->ReleaseInstanceIDs(old_host);
+    }
+  }
+}
+
+void
+ThrustWindow::RenderFrameDeleted(
+    RenderFrameHost* render_frame_host)
+{
+  if(!render_frame_host->GetParent()) {
+    ThrustSession* session = 
+      ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+          web_contents()->GetBrowserContext());
+    if(session) {
+      session->ReleaseInstanceIDs(render_frame_host);
+    }
+  }
+}
+
+void
+ThrustWindow::WebContentsDestroyed()
+{
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        web_contents()->GetBrowserContext());
+  if(session) {
+    session->ReleaseInstanceIDs(web_contents());
+  }
+}
+
 /******************************************************************************/
 /* WEBVIEWGUEST MESSAGE HANDLING */
 /******************************************************************************/
+void
+ThrustWindow::WebViewReserveInstanceIDs()
+{
+  /* We send to the MainFrame as this is the only one that is authorized to */
+  /* have <webview> tags.                                                   */
+  SendWebViewInstanceIDs(GetWebContents()->GetMainFrame());
+}
+
 void 
 ThrustWindow::CreateWebViewGuest(
-    const base::DictionaryValue& params,
-    int* guest_instance_id)
+    int guest_instance_id,
+    const base::DictionaryValue& params)
 {
-
-  *guest_instance_id = 
+  ThrustSession* session = 
     ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-        GetWebContents()->GetBrowserContext())->
-      GetNextInstanceID();
+        GetWebContents()->GetBrowserContext());
+  /* The ID is allocated by the renderer from the ranges reserved for it. */
+  if(!session->ClaimInstanceID(GetWebContents(), guest_instance_id)) {
+    LOG(ERROR) << "ThrustWindow CreateWebViewGuest invalid instance ID "
+               << guest_instance_id;
+    return;
+  }
 
-  LOG(INFO) << "ThrustWindow CreateWebViewGuest " << *guest_instance_id;
+  LOG(INFO) << "ThrustWindow CreateWebViewGuest " << guest_instance_id;
 
-  WebViewGuest* guest = WebViewGuest::Create(*guest_instance_id);
+  WebViewGuest* guest = WebViewGuest::Create(guest_instance_id);
 
-  GURL guest_site(base::StringPrintf("%s://webview",
-                                     content::kGuestScheme));
-  content::SiteInstance* guest_site_instance =
-    content::SiteInstance::CreateForURL(
-        GetWebContents()->GetBrowserContext(), guest_site);
+  /* The guest SiteInstance process is already launched if it comes from */
+  /* the session pool.                                                   */
+  bool prewarmed = false;
+  scoped_refptr<content::SiteInstance> guest_site_instance =
+    session->GetWebContentsPool()->CreateGuestSiteInstance(&prewarmed);
+  guest->SetPrewarmed(prewarmed);
 
   WebContents::CreateParams create_params(
       GetWebContents()->GetBrowserContext(),
-      guest_site_instance);
+      guest_site_instance.get());
   create_params.guest_delegate = guest;
   WebContents* guest_web_contents =
       WebContents::Create(create_params);
@@ -554,12 +741,10 @@ ThrustWindow::DestroyWebViewGuest(
 {
   LOG(INFO) << "ThrustWindow DestroyWebViewGuest " << guest_instance_id;
 
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->Destroy();
 }
@@ -571,12 +756,17 @@ ThrustWindow::WebViewEmit(
     const std::string type,
     const base::DictionaryValue& params)
 {
-  /* We emit to the MainFrame as this is the only one that is authorized to */
-  /* have <webview> tags.                                                   */
-  GetWebContents()->GetMainFrame()->Send(
-      new ThrustFrameMsg_WebViewEmit(
-        GetWebContents()->GetMainFrame()->GetRoutingID(),
-        guest_instance_id, type, params));
+  QueueWebViewEvent(
+      WebViewEvent(guest_instance_id, type, WebViewEvent::KIND_GENERIC),
+      &params);
+}
+
+void 
+ThrustWindow::WebViewEmit(
+    const WebViewEvent& event)
+{
+  DCHECK(event.kind != WebViewEvent::KIND_GENERIC);
+  QueueWebViewEvent(event, NULL);
 }
 
 void 
@@ -584,12 +774,10 @@ ThrustWindow::WebViewGuestSetAutoSize(
     int guest_instance_id,
     const base::DictionaryValue& params)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   int min_width = 0;
   int min_height = 0;
@@ -618,12 +806,10 @@ ThrustWindow::WebViewGuestLoadUrl(
     int guest_instance_id,
     const std::string& url)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->LoadUrl(GURL(url));
 }
@@ -633,12 +819,10 @@ ThrustWindow::WebViewGuestGo(
     int guest_instance_id,
     int relative_index)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->Go(relative_index);
 }
@@ -648,12 +832,10 @@ ThrustWindow::WebViewGuestReload(
     int guest_instance_id,
     bool ignore_cache)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->Reload(ignore_cache);
 }
@@ -662,12 +844,10 @@ void
 ThrustWindow::WebViewGuestStop(
     int guest_instance_id)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->Stop();
 }
@@ -677,16 +857,27 @@ ThrustWindow::WebViewGuestSetZoom(
     int guest_instance_id,
     double zoom_factor)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->SetZoom(zoom_factor);
 }
 
+void 
+ThrustWindow::WebViewGuestSetPriority(
+    int guest_instance_id,
+    const std::string& priority_class)
+{
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
+
+  guest->SetPriorityClass(priority_class);
+}
+
 void 
 ThrustWindow::WebViewGuestFind(
     int guest_instance_id,
@@ -694,12 +885,10 @@ ThrustWindow::WebViewGuestFind(
     const std::string& search_text,
     const base::DictionaryValue& options)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   blink::WebFindOptions find_options;
   options.GetBoolean("forward", &find_options.forward);
@@ -717,12 +906,10 @@ ThrustWindow::WebViewGuestStopFinding(
     int guest_instance_id,
     const std::string& action)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   content::StopFindAction action_value = 
     content::STOP_FIND_ACTION_CLEAR_SELECTION;
@@ -738,17 +925,42 @@ ThrustWindow::WebViewGuestStopFinding(
   guest->StopFinding(action_value);
 }
 
+void 
+ThrustWindow::WebViewGuestCapture(
+    int guest_instance_id,
+    int request_id,
+    const base::DictionaryValue& options)
+{
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
+
+  guest->Capture(request_id, options);
+}
+
+void 
+ThrustWindow::WebViewGuestReleaseCapture(
+    int guest_instance_id,
+    const std::string& path)
+{
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
+
+  guest->ReleaseCapture(path);
+}
+
 void 
 ThrustWindow::WebViewGuestInsertCSS(
     int guest_instance_id,
     const std::string& css)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->InsertCSS(css);
 }
@@ -758,12 +970,10 @@ ThrustWindow::WebViewGuestExecuteScript(
     int guest_instance_id,
     const std::string& script)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->ExecuteScript(script);
 }
@@ -772,12 +982,10 @@ void
 ThrustWindow::WebViewGuestOpenDevTools(
     int guest_instance_id)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->OpenDevTools();
 }
@@ -786,12 +994,10 @@ void
 ThrustWindow::WebViewGuestCloseDevTools(
     int guest_instance_id)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->CloseDevTools();
 }
@@ -801,12 +1007,11 @@ ThrustWindow::WebViewGuestIsDevToolsOpened(
     int guest_instance_id,
     bool* open)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  *open = false;
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   *open = guest->IsDevToolsOpened();
 }
@@ -817,16 +1022,26 @@ ThrustWindow::WebViewGuestJavaScriptDialogClosed(
     bool success, 
     const std::string& response)
 {
-  WebViewGuest* guest = 
-    WebViewGuest::FromWebContents(
-        ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
-          GetWebContents()->GetBrowserContext())->
-        GetGuestByInstanceID(guest_instance_id, 
-          GetWebContents()->GetRenderProcessHost()->GetID()));
+  WebViewGuest* guest = WebViewGuestForInstanceID(guest_instance_id);
+  if(!guest) {
+    return;
+  }
 
   guest->JavaScriptDialogClosed(success, response);
 }
 
+WebViewGuest*
+ThrustWindow::WebViewGuestForInstanceID(
+    int guest_instance_id)
+{
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        GetWebContents()->GetBrowserContext());
+  return ThrustRegistry::GetInstance()->GuestForWebContents(
+      session->GetGuestByInstanceID(
+        guest_instance_id, GetWebContents()->GetRenderProcessHost()->GetID()));
+}
+
 /******************************************************************************/
 /* PROTECTED INTERFACE */
 /******************************************************************************/
@@ -846,9 +1061,221 @@ ThrustWindow::CloseImmediately()
 /******************************************************************************/
 
 void ThrustWindow::DestroyWebContents() {
+  ThrustRegistry::GetInstance()->RemoveWindow(this);
   if(inspectable_web_contents_) {
     inspectable_web_contents_.reset();
   }
 }
 
+void
+ThrustWindow::SendWebViewInstanceIDs(
+    RenderFrameHost* render_frame_host)
+{
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        GetWebContents()->GetBrowserContext());
+  int first = session->ReserveInstanceIDs(GetWebContents(),
+                                          render_frame_host,
+                                          kWebViewInstanceIDsRange);
+  /* Requests beyond the cap of unused IDs are refused with an empty */
+  /* range so that the renderer fails its pending guest creations.   */
+  int count = kWebViewInstanceIDsRange;
+  if(first == 0) {
+    LOG(WARNING) << "ThrustWindow too many unused guest instance IDs "
+                 << "reserved, request refused";
+    count = 0;
+  }
+  render_frame_host->Send(
+      new ThrustFrameMsg_WebViewInstanceIDsReserved(
+        render_frame_host->GetRoutingID(),
+        first, count));
+}
+
+void
+ThrustWindow::QueueWebViewEvent(
+    const WebViewEvent& event,
+    const base::DictionaryValue* params)
+{
+  if(CoalesceWebViewEvent(event, params)) {
+    return;
+  }
+
+  web_view_events_.push_back(event);
+  if(event.kind == WebViewEvent::KIND_GENERIC) {
+    web_view_events_.back().params_index = web_view_event_params_.GetSize();
+    web_view_event_params_.Append(params->DeepCopy());
+  }
+
+  if(web_view_events_.size() >= kWebViewEventsMaxBatch) {
+    FlushWebViewEvents();
+  }
+  else if(!web_view_flush_pending_) {
+    web_view_flush_pending_ = true;
+    base::MessageLoop::current()->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&ThrustWindow::FlushWebViewEvents,
+                   weak_factory_.GetWeakPtr()),
+        base::TimeDelta::FromMilliseconds(kWebViewEventsFlushDelayMs));
+  }
+}
+
+bool
+ThrustWindow::CoalesceWebViewEvent(
+    const WebViewEvent& event,
+    const base::DictionaryValue* params)
+{
+  bool coalesced = false;
+  for(size_t i = 0; i < arraysize(kCoalescedWebViewEvents); ++i) {
+    if(event.type == kCoalescedWebViewEvents[i])
+      coalesced = true;
+  }
+  if(!coalesced) {
+    return false;
+  }
+
+  /* Only the last queued event of the guest is superseded so that events */
+  /* are never reordered.                                                 */
+  for(size_t i = web_view_events_.size(); i > 0; --i) {
+    WebViewEvent& last = web_view_events_[i - 1];
+    if(last.guest_instance_id != event.guest_instance_id) {
+      continue;
+    }
+    if(last.type != event.type || last.kind != event.kind) {
+      return false;
+    }
+
+    if(last.kind == WebViewEvent::KIND_SIZE_CHANGED) {
+      /* The merged event goes from the first old size to the last size. */
+      last.new_size = event.new_size;
+    }
+    else if(last.kind == WebViewEvent::KIND_GENERIC) {
+      base::DictionaryValue* merged = params->DeepCopy();
+      base::DictionaryValue* previous = NULL;
+      double old_zoom_factor = 0.0;
+      if(web_view_event_params_.GetDictionary(last.params_index, &previous) &&
+         previous->GetDouble("old_zoom_factor", &old_zoom_factor)) {
+        merged->SetDouble("old_zoom_factor", old_zoom_factor);
+      }
+      web_view_event_params_.Set(last.params_index, merged);
+    }
+    return true;
+  }
+  return false;
+}
+
+void
+ThrustWindow::FlushWebViewEvents()
+{
+  web_view_flush_pending_ = false;
+  if(web_view_events_.empty()) {
+    return;
+  }
+
+  /* We emit to the MainFrame as this is the only one that is authorized to */
+  /* have <webview> tags.                                                   */
+  if(GetWebContents()) {
+    GetWebContents()->GetMainFrame()->Send(
+        new ThrustFrameMsg_WebViewEmitBatch(
+          GetWebContents()->GetMainFrame()->GetRoutingID(),
+          web_view_events_, web_view_event_params_));
+  }
+  web_view_events_.clear();
+  web_view_event_params_.Clear();
+}
+
+void
+ThrustWindow::OnIconLoaded(
+    const gfx::ImageSkia& icon)
+{
+  if(icon.isNull() || is_closed_)
+    return;
+  icon_ = icon;
+  PlatformUpdateIcon();
+}
+
+void
+ThrustWindow::UpdateDraggableRegions(
+    const std::vector<DraggableRegion>& regions)
+{
+  if(has_frame_) {
+    return;
+  }
+
+  draggable_stats_.Tick(base::TimeTicks::Now());
+  if(draggable_region_ && regions == draggable_regions_) {
+    draggable_stats_.skipped++;
+    return;
+  }
+
+  /* Non-draggable regions carve into the draggable regions preceding them, */
+  /* so only regions appended after the current ones can be applied on top  */
+  /* of the current region.                                                 */
+  size_t from = 0;
+  if(draggable_region_ && regions.size() > draggable_regions_.size() &&
+     std::equal(draggable_regions_.begin(), draggable_regions_.end(),
+                regions.begin())) {
+    from = draggable_regions_.size();
+    draggable_stats_.incremental++;
+  }
+  else {
+    // By default, the whole window is non-draggable. We need to explicitly
+    // include those draggable regions.
+    draggable_region_.reset(new SkRegion);
+    draggable_stats_.rebuilt++;
+  }
+
+  for(size_t i = from; i < regions.size(); ++i) {
+    const DraggableRegion& region = regions[i];
+    draggable_region_->op(
+        region.bounds.x(),
+        region.bounds.y(),
+        region.bounds.right(),
+        region.bounds.bottom(),
+        region.draggable ? SkRegion::kUnion_Op : SkRegion::kDifference_Op);
+  }
+  draggable_regions_ = regions;
+
+  PlatformUpdateDraggableRegions(regions);
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustWindow::GetDraggableStats() const
+{
+  scoped_ptr<base::DictionaryValue> stats(new base::DictionaryValue);
+  stats->SetInteger("updates", draggable_stats_.updates);
+  stats->SetInteger("skipped", draggable_stats_.skipped);
+  stats->SetInteger("incremental", draggable_stats_.incremental);
+  stats->SetInteger("rebuilt", draggable_stats_.rebuilt);
+  stats->SetInteger("updates_per_second",
+                    draggable_stats_.PerSecond(base::TimeTicks::Now()));
+  return stats.Pass();
+}
+
+void
+ThrustWindow::DraggableStats::Tick(
+    base::TimeTicks now)
+{
+  if(now - second_start >= base::TimeDelta::FromSeconds(1)) {
+    last_second_updates = PerSecond(now);
+    second_start = now;
+    second_updates = 0;
+  }
+  second_updates++;
+  updates++;
+}
+
+int
+ThrustWindow::DraggableStats::PerSecond(
+    base::TimeTicks now) const
+{
+  base::TimeDelta elapsed = now - second_start;
+  if(elapsed < base::TimeDelta::FromSeconds(1))
+    return last_second_updates;
+  /* The current second is complete, it is the last one if no update was */
+  /* received since.                                                     */
+  if(elapsed < base::TimeDelta::FromSeconds(2))
+    return second_updates;
+  return 0;
+}
+
 } // namespace thrust_shell
@@ -9,7 +9,10 @@
 #include "base/basictypes.h"
 #include "base/callback_forward.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
 #include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "base/values.h"
 #include "ui/gfx/native_widget_types.h"
 #include "ui/gfx/size.h"
 #include "ui/gfx/point.h"
@@ -22,6 +25,11 @@
 #include "vendor/brightray/browser/inspectable_web_contents_delegate.h"
 #include "vendor/brightray/browser/inspectable_web_contents_impl.h"
 
+#include "src/browser/util/create_timeline.h"
+#include "src/common/draggable_region.h"
+#include "src/common/web_view_event.h"
+#include "src/net/network_usage.h"
+
 #if defined(USE_AURA)
 #include "ui/views/widget/widget.h"
 #include "ui/views/widget/widget_delegate.h"
@@ -55,9 +63,10 @@ class ThrustSession;
 class ThrustWindowBinding;
 class ThrustShellJavaScriptDialogManager;
 class ThrustShellWebDialogHelper;
-struct DraggableRegion;
+class WebViewGuest;
 
 class GlobalMenuBarX11;
+class ThrustHeadlessHost;
 
 // ### ThrustWindow
 //
@@ -90,6 +99,7 @@ public:
   // @title        {string} the title to use
   // @icon_path    {string} icon_path (no effect on OSX)
   // @has_frame    {boolean} has a frame
+  // @headless     {boolean} renders offscreen, never displayed
   // ```
   static ThrustWindow* CreateNew(
       ThrustWindowBinding* binding,
@@ -98,7 +108,8 @@ public:
       const gfx::Size& size,
       const std::string& title,
       const std::string& icon_path,
-      const bool has_frame);
+      const bool has_frame,
+      const bool headless);
 
   // ### CreateNew
   //
@@ -110,6 +121,7 @@ public:
   // @title        {string} the title to use
   // @icon_path    {string} icon_path (no effect on OSX)
   // @has_frame    {boolean} has a frame
+  // @headless     {boolean} renders offscreen, never displayed
   // ```
   static ThrustWindow* CreateNew(
       ThrustWindowBinding* binding,
@@ -117,7 +129,8 @@ public:
       const gfx::Size& size,
       const std::string& title,
       const std::string& icon_path,
-      const bool has_frame);
+      const bool has_frame,
+      const bool headless);
 
   // ### instances
   //
@@ -134,6 +147,15 @@ public:
   // Closes all open ThrustWindows
   static void CloseAll();
 
+  // ### AccountNetworkUsage
+  //
+  // Attributes the network usage accumulated by the network delegates to the
+  // WebViewGuests and ThrustWindows owning the frames that made the requests.
+  // ```
+  // @usage {ThrustShellNetworkUsageMap} usage per render process and frame
+  // ```
+  static void AccountNetworkUsage(const ThrustShellNetworkUsageMap& usage);
+
   /****************************************************************************/
   /* PUBLIC INTERFACE */
   /****************************************************************************/
@@ -143,32 +165,57 @@ public:
   // ### Show
   //
   // Initially show the window
-  void Show() { PlatformShow(); }
+  void Show() {
+    if(!headless_) {
+      PlatformShow();
+      timeline_.Mark(ThrustCreateTimeline::PHASE_SHOWN);
+      UpdateBackgroundState();
+    }
+  }
 
   // ### Focus
   //
   // Focuses the window
-  void Focus(bool focus) { PlatformFocus(focus); }
+  void Focus(bool focus) {
+    if(!headless_)
+      PlatformFocus(focus);
+  }
 
   // ### Maximize
   //
   // Maximize the window
-  void Maximize() { PlatformMaximize(); }
+  void Maximize() {
+    if(!headless_)
+      PlatformMaximize();
+  }
 
   // ### UnMaximize
   //
   // UnMaximize the window
-  void UnMaximize() { PlatformUnMaximize(); }
+  void UnMaximize() {
+    if(!headless_)
+      PlatformUnMaximize();
+  }
 
   // ### Minimize
   //
   // Minimize the window
-  void Minimize() { PlatformMinimize(); }
+  void Minimize() {
+    if(!headless_) {
+      PlatformMinimize();
+      UpdateBackgroundState();
+    }
+  }
 
   // ### Restore
   //
   // Restore the window
-  void Restore() { PlatformRestore(); }
+  void Restore() {
+    if(!headless_) {
+      PlatformRestore();
+      UpdateBackgroundState();
+    }
+  }
 
   // ### SetTitle
   //
@@ -178,7 +225,10 @@ public:
   // ### SetFullscreen
   //
   // Sets the window in kiosk mode
-  void SetFullscreen(bool fullscreen) { PlatformSetFullscreen(fullscreen); }
+  void SetFullscreen(bool fullscreen) {
+    if(!headless_)
+      PlatformSetFullscreen(fullscreen);
+  }
 
   // ### IsFullscreen
   //
@@ -188,7 +238,10 @@ public:
   // ### SetKiosk
   //
   // Sets the window in kiosk mode
-  void SetKiosk(bool kiosk) { PlatformSetKiosk(kiosk); }
+  void SetKiosk(bool kiosk) {
+    if(!headless_)
+      PlatformSetKiosk(kiosk);
+  }
 
   // ### IsKiosk
   //
@@ -245,6 +298,13 @@ public:
   // Returns wether the window has frame or not
   bool HasFrame() { return has_frame_; }
 
+  // ### IsHeadless
+  //
+  // Returns wether the window renders offscreen (never displayed). On Aura
+  // headless windows have no widget, their content is hosted by a
+  // ThrustHeadlessHost (which still needs an X server on X11).
+  bool IsHeadless() { return headless_; }
+
   // ### GetSize
   //
   // Retrieves the native Window size
@@ -265,6 +325,30 @@ public:
   // Retrieves whether the window is minimized
   bool IsMinimized() { return PlatformIsMinimized(); }
 
+  // ### SetBackground
+  //
+  // Explicitly puts the window in background (or lets the background policy
+  // decide if false, see UpdateBackgroundState)
+  void SetBackground(bool background);
+
+  // ### IsBackground
+  //
+  // Returns whether the window renderer is currently throttled
+  bool IsBackground() const { return backgrounded_; }
+
+  // ### UpdateBackgroundState
+  //
+  // Evaluates the background policy. A window is in background when set
+  // explicitly or when minimized (headless windows only when set
+  // explicitly). Background windows are hidden from their renderer: frame
+  // production stops, timers are throttled, guests are hidden along with 
+  // their embedder and the renderer process priority is lowered once none of
+  // its views is visible. Called by platform implementations on visibility,
+  // activation and minimization changes, after which the hidden state of a
+  // background window is re-applied. Renderers are only shown again if the
+  // native window is visible (or headless).
+  void UpdateBackgroundState();
+
   // ### GetNativeWindow
   //
   // Returns the NativeWindow for this Shell
@@ -275,11 +359,31 @@ public:
   // Returns the underlying web_contents
   content::WebContents* GetWebContents() const;
 
+  // ### AddNetworkUsage
+  //
+  // Adds to the network usage of this window (own frames and guests)
+  void AddNetworkUsage(const ThrustShellNetworkUsage& usage) {
+    network_usage_.Add(usage);
+  }
+
+  // ### GetNetworkUsage
+  //
+  // Returns the network usage of this window since its creation
+  const ThrustShellNetworkUsage& GetNetworkUsage() const {
+    return network_usage_;
+  }
+
   // ### GetBinding
   //
   // Returns the binding for that window
   ThrustWindowBinding* GetBinding() const { return binding_; }
 
+  // ### GetCreateTimeline
+  //
+  // Returns the creation timeline of that window, emitted as a `timing` event
+  // on first paint
+  ThrustCreateTimeline* GetCreateTimeline() { return &timeline_; }
+
   // ### GetDraggableRegion
   //
   // Returns the draggable region
@@ -287,6 +391,13 @@ public:
     return draggable_region_.get(); 
   }
 
+  // ### GetDraggableStats
+  //
+  // Returns the draggable region update counters: `updates` received from
+  // the renderer, `skipped` (unchanged), `incremental` and `rebuilt` updates
+  // and the `updates_per_second` over the last complete second.
+  scoped_ptr<base::DictionaryValue> GetDraggableStats() const;
+
   /****************************************************************************/
   /* WEBCONTENTSDELEGATE IMPLEMENTATION */
   /****************************************************************************/
@@ -335,17 +446,41 @@ public:
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE; 
   virtual bool OnMessageReceived(const IPC::Message& message,
                                  content::RenderFrameHost* render_frame_host) OVERRIDE; 
+  virtual void DidCommitProvisionalLoadForFrame(
+      content::RenderFrameHost* render_frame_host,
+      const GURL& url,
+      content::PageTransition transition_type) OVERRIDE;
+  virtual void DidFirstVisuallyNonEmptyPaint() OVERRIDE;
+  virtual void RenderFrameCreated(
+      content::RenderFrameHost* render_frame_host) OVERRIDE;
+  virtual void RenderFrameHostChanged(
+      content::RenderFrameHost* old_host,
+      content::RenderFrameHost* new_host) OVERRIDE;
+  virtual void RenderFrameDeleted(
+      content::RenderFrameHost* render_frame_host) OVERRIDE;
+  virtual void WebContentsDestroyed() OVERRIDE;
 
   /****************************************************************************/
   /* WEBVIEWGUEST MESSAGE HANDLING */
   /****************************************************************************/
-  void CreateWebViewGuest(const base::DictionaryValue& params,
-                          int* guest_instance_id); 
+  // Sends a new range of guest instance IDs to the main frame on request.
+  void WebViewReserveInstanceIDs();
+  void CreateWebViewGuest(int guest_instance_id,
+                          const base::DictionaryValue& params); 
   void DestroyWebViewGuest(int guest_instance_id); 
+  // Retrieves the guest of this window's session or NULL.
+  WebViewGuest* WebViewGuestForInstanceID(int guest_instance_id);
 
+  // ### WebViewEmit
+  //
+  // Queues an event for the <webview> element of the guest. Queued events
+  // are sent to the main frame by batch once per frame. An event superseding
+  // the last queued event of the same guest replaces it (see
+  // CoalesceWebViewEvent).
   void WebViewEmit(int guest_instance_id,
                    const std::string type,
                    const base::DictionaryValue& params);
+  void WebViewEmit(const WebViewEvent& event);
 
   void WebViewGuestSetAutoSize(int guest_instance_id,
                                const base::DictionaryValue& params);
@@ -358,12 +493,19 @@ public:
   void WebViewGuestStop(int guest_instance_id);
   void WebViewGuestSetZoom(int guest_instance_id,
                            double zoom_factor);
+  void WebViewGuestSetPriority(int guest_instance_id,
+                               const std::string& priority_class);
   void WebViewGuestFind(int guest_instance_id,
                         int request_id,
                         const std::string& search_text,
                         const base::DictionaryValue& options);
   void WebViewGuestStopFinding(int guest_instance_id,
                                const std::string& action);
+  void WebViewGuestCapture(int guest_instance_id,
+                           int request_id,
+                           const base::DictionaryValue& options);
+  void WebViewGuestReleaseCapture(int guest_instance_id,
+                                  const std::string& path);
   void WebViewGuestInsertCSS(int guest_instance_id,
                              const std::string& css);
   void WebViewGuestExecuteScript(int guest_instance_id,
@@ -414,16 +556,70 @@ private:
       const gfx::Size& size,
       const std::string& title,
       const std::string& icon_path,
-      const bool has_frame);
+      const bool has_frame,
+      const bool headless);
 
   void DestroyWebContents();
 
+  // ### OnIconLoaded
+  // Called once the window icon has been loaded by the ThrustIconCache.
+  void OnIconLoaded(const gfx::ImageSkia& icon);
+
+  // ### SendWebViewInstanceIDs
+  // Reserves a range of guest instance IDs for this window and sends it to
+  // |render_frame_host|, which allocates them to the guests it creates.
+  // An empty range is sent if the window already has too many unused IDs.
+  void SendWebViewInstanceIDs(content::RenderFrameHost* render_frame_host);
+
+  // ### QueueWebViewEvent
+  // Queues |event| (with |params| for generic events) and schedules a flush.
+  void QueueWebViewEvent(const WebViewEvent& event,
+                         const base::DictionaryValue* params);
+  // ### CoalesceWebViewEvent
+  // Merges |event| into the last queued event of the same guest if it is of
+  // the same type and only reflects a state (`size-changed`, `zoom-changed`,
+  // `title-set`, `network-usage`). Returns whether it was merged.
+  bool CoalesceWebViewEvent(const WebViewEvent& event,
+                            const base::DictionaryValue* params);
+  void FlushWebViewEvents();
+
+  // ### UpdateDraggableRegions
+  // Called when the renderer sends its draggable regions. Regions are applied
+  // in order, so regions appended to the previous ones are applied on top of
+  // the current region, while any other change rebuilds it.
+  void UpdateDraggableRegions(const std::vector<DraggableRegion>& regions);
+
+  struct DraggableStats {
+    DraggableStats()
+    : updates(0),
+      skipped(0),
+      incremental(0),
+      rebuilt(0),
+      second_updates(0),
+      last_second_updates(0) {}
+
+    void Tick(base::TimeTicks now);
+    int PerSecond(base::TimeTicks now) const;
+
+    int                updates;
+    int                skipped;
+    int                incremental;
+    int                rebuilt;
+    base::TimeTicks    second_start;
+    int                second_updates;
+    int                last_second_updates;
+  };
+
 #if defined(USE_AURA)
   /****************************************************************************/
   /* VIEWS::WIDGETOBSERVER IMPLEMENTATION */
   /****************************************************************************/
   virtual void OnWidgetActivationChanged(
       views::Widget* widget, bool active) OVERRIDE;
+  virtual void OnWidgetVisibilityChanged(
+      views::Widget* widget, bool visible) OVERRIDE;
+  virtual void OnWidgetBoundsChanged(
+      views::Widget* widget, const gfx::Rect& new_bounds) OVERRIDE;
 
   /****************************************************************************/
   /* VIEWS::WIDGETDELEGATE IMPLEMENTATION */
@@ -592,12 +788,23 @@ private:
   // Retrieves whether the window is minimized
   bool PlatformIsMinimized();
 
+  // ### PlatformIsVisible
+  //
+  // Retrieves whether the native window is shown
+  bool PlatformIsVisible();
+
   // ### PlatformGetNativeWindow
   //
   // Returns the NativeWindow for this Shell
   gfx::NativeWindow PlatformGetNativeWindow();
 
-  // Called when the window needs to update its draggable region.
+  // ### PlatformUpdateIcon
+  //
+  // Applies `icon_` to the already displayed window
+  void PlatformUpdateIcon();
+
+  // Called once `draggable_region_` has been updated so that each platform
+  // can apply it to the window.
   void PlatformUpdateDraggableRegions(
       const std::vector<DraggableRegion>& regions);
 
@@ -611,6 +818,8 @@ private:
 
 #if defined(USE_AURA)
   scoped_ptr<views::Widget>                        window_;
+  /* Hosts the content of headless windows, which have no widget. */
+  scoped_ptr<ThrustHeadlessHost>                   headless_host_;
 #if defined(USE_X11)
   scoped_ptr<GlobalMenuBarX11>                     global_menu_bar_;
 #endif
@@ -622,13 +831,26 @@ private:
   gfx::ImageSkia                                   icon_;
   std::string                                      title_;
   bool                                             has_frame_;
+  bool                                             headless_;
+  ThrustCreateTimeline                             timeline_;
+  bool                                             prewarmed_;
+  bool                                             background_;
+  bool                                             backgrounded_;
   scoped_ptr<SkRegion>                             draggable_region_;
+  std::vector<DraggableRegion>                     draggable_regions_;
+  DraggableStats                                   draggable_stats_;
+  ThrustShellNetworkUsage                          network_usage_;
+  std::vector<WebViewEvent>                        web_view_events_;
+  base::ListValue                                  web_view_event_params_;
+  bool                                             web_view_flush_pending_;
 
   scoped_ptr<brightray::InspectableWebContents>    inspectable_web_contents_;
 
   // A static container of all the open instances.
   static std::vector<ThrustWindow*>                s_instances;
 
+  base::WeakPtrFactory<ThrustWindow>               weak_factory_;
+
   friend class ThrustMenu;
 
   DISALLOW_COPY_AND_ASSIGN(ThrustWindow);
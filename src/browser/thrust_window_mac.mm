@@ -105,6 +105,14 @@ static const CGFloat kThrustWindowCornerRadius = 4.0;
   }
 }
 
+- (void)windowDidMiniaturize:(NSNotification*)notification {
+  window_->UpdateBackgroundState();
+}
+
+- (void)windowDidDeminiaturize:(NSNotification*)notification {
+  window_->UpdateBackgroundState();
+}
+
 - (void)windowDidExitFullScreen:(NSNotification*)notification {
   if (!window_->HasFrame()) {
     NSWindow* window = window_->GetNativeWindow();
@@ -374,6 +382,12 @@ ThrustWindow::PlatformShow()
   [window_ makeKeyAndOrderFront:nil];
 }
 
+void
+ThrustWindow::PlatformUpdateIcon()
+{
+  /* Window icons have no effect on OSX. */
+}
+
 void 
 ThrustWindow::PlatformClose() 
 {
@@ -553,6 +567,12 @@ ThrustWindow::PlatformIsMinimized()
   return [window_ isMiniaturized];
 }
 
+bool
+ThrustWindow::PlatformIsVisible()
+{
+  return [window_ isVisible];
+}
+
 
 void 
 ThrustWindow::PlatformSetContentSize(
@@ -574,10 +594,6 @@ void
 ThrustWindow::PlatformUpdateDraggableRegions(
     const std::vector<DraggableRegion>& regions)
 {
-  if(has_frame_) {
-    return;
-  }
-
   // We still need one ControlRegionView to cover the whole window such that
   // mouse events could be captured.
   NSView* webview = GetWebContents()->GetNativeView();
@@ -586,22 +602,6 @@ ThrustWindow::PlatformUpdateDraggableRegions(
   std::vector<gfx::Rect> system_drag_exclude_areas;
   system_drag_exclude_areas.push_back(window_bounds);
 
-  // Aggregate the draggable areas and non-draggable areas such that hit test
-  // could be performed easily.
-  SkRegion* draggable_region = new SkRegion;
-  for (std::vector<DraggableRegion>::const_iterator iter = regions.begin();
-       iter != regions.end();
-       ++iter) {
-    const DraggableRegion& region = *iter;
-    draggable_region->op(
-        region.bounds.x(),
-        region.bounds.y(),
-        region.bounds.right(),
-        region.bounds.bottom(),
-        region.draggable ? SkRegion::kUnion_Op : SkRegion::kDifference_Op);
-  }
-  draggable_region_.reset(draggable_region);
-
   // All ControlRegionViews should be added as children of the WebContentsView,
   // because WebContentsView will be removed and re-added when entering and
   // leaving fullscreen mode.
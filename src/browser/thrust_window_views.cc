@@ -31,6 +31,7 @@
 #include "ui/views/widget/widget.h"
 #include "ui/aura/window.h"
 #include "ui/aura/window_tree_host.h"
+#include "ui/compositor/compositor.h"
 #include "ui/base/hit_test.h"
 #include "ui/views/background.h"
 #include "ui/views/controls/webview/unhandled_keyboard_event_handler.h"
@@ -45,6 +46,7 @@
 #include "src/common/draggable_region.h"
 #include "src/browser/ui/views/menu_bar.h"
 #include "src/browser/ui/views/menu_layout.h"
+#include "src/browser/ui/headless_host_aura.h"
 #include "src/browser/browser_client.h"
 #include "src/browser/thrust_menu.h"
 #include "src/api/thrust_window_binding.h"
@@ -131,6 +133,10 @@ void
 ThrustWindow::AttachMenu(
     ui::MenuModel* menu_model) 
 {
+  /* Headless windows have no menu bar. */
+  if(headless_) {
+    return;
+  }
 #if defined(USE_X11)
   /* TODO(spolu) Menu accelerators */
   /*
@@ -178,6 +184,9 @@ gfx::Rect
 ThrustWindow::ContentBoundsToWindowBounds(
     const gfx::Rect& bounds)
 {
+  if(headless_) {
+    return bounds;
+  }
   gfx::Rect window_bounds =
       window_->non_client_view()->GetWindowBoundsForClientBounds(bounds);
   return window_bounds;
@@ -190,18 +199,29 @@ ThrustWindow::ContentBoundsToWindowBounds(
 void 
 ThrustWindow::PlatformCleanUp() 
 {
-  window_->RemoveObserver(this);
+  if(window_) {
+    window_->RemoveObserver(this);
+  }
+  headless_host_.reset();
 }
 
 void 
 ThrustWindow::PlatformCreateWindow(
     const gfx::Size& size)
 {
-  window_.reset(new views::Widget());
-
   LOG(INFO) << "Create Window: " << size.width() << "x" << size.height();
 
   gfx::Rect bounds(0, 0, size.width(), size.height());
+
+  if(headless_) {
+    /* No widget: the content view is hosted directly by a never shown */
+    /* window tree host (see ThrustHeadlessHost).                      */
+    headless_host_.reset(new ThrustHeadlessHost(bounds));
+    headless_host_->SetContents(web_contents()->GetNativeView());
+    return;
+  }
+
+  window_.reset(new views::Widget());
   window_->AddObserver(this);
 
   views::Widget::InitParams params;
@@ -282,21 +302,41 @@ ThrustWindow::PlatformCreateWindow(
 #endif
 }
 
+void
+ThrustWindow::PlatformUpdateIcon()
+{
+  if(headless_) {
+    return;
+  }
+  window_->UpdateWindowIcon();
+}
+
 void 
 ThrustWindow::PlatformShow() 
 {
+  DCHECK(!headless_);
   window_->Show();
 }
 
 void 
 ThrustWindow::PlatformClose() 
 {
+  if(headless_) {
+    PlatformCloseImmediately();
+    return;
+  }
   window_->Close();
 }
 
 void 
 ThrustWindow::PlatformCloseImmediately() 
 {
+  if(headless_) {
+    /* As the widget deleting its delegate (see DeleteDelegate). */
+    headless_host_->Close();
+    binding_->EmitClosed();
+    return;
+  }
   window_->CloseNow();
 }
 
@@ -304,6 +344,9 @@ void
 ThrustWindow::PlatformSetTitle(
     const std::string& title) 
 {
+  if(headless_) {
+    return;
+  }
   window_->UpdateWindowTitle();
 }
 
@@ -317,6 +360,9 @@ ThrustWindow::PlatformSetFullscreen(
 bool 
 ThrustWindow::PlatformIsFullscreen() 
 {
+  if(headless_) {
+    return false;
+  }
   return window_->IsFullscreen();
 }
 
@@ -371,6 +417,9 @@ ThrustWindow::PlatformRestore()
 gfx::Size
 ThrustWindow::PlatformSize()
 {
+  if(headless_) {
+    return headless_host_->GetBounds().size();
+  }
 #if defined(OS_WIN)
   if(window_->IsMinimized()) {
     return window_->GetRestoredBounds().size();
@@ -393,15 +442,31 @@ ThrustWindow::PlatformContentSize()
 bool
 ThrustWindow::PlatformIsMaximized()
 {
+  if(headless_) {
+    return false;
+  }
   return window_->IsMaximized();
 }
 
 bool
 ThrustWindow::PlatformIsMinimized()
 {
+  if(headless_) {
+    return false;
+  }
   return window_->IsMinimized();
 }
 
+bool
+ThrustWindow::PlatformIsVisible()
+{
+  /* Headless windows are never displayed. */
+  if(headless_) {
+    return false;
+  }
+  return window_->IsVisible();
+}
+
 void 
 ThrustWindow::PlatformSetContentSize(
     int width, int height)
@@ -421,12 +486,20 @@ ThrustWindow::PlatformSetContentSize(
 gfx::Point
 ThrustWindow::PlatformPosition()
 {
+  if(headless_) {
+    return headless_host_->GetBounds().origin();
+  }
   return window_->GetWindowBoundsInScreen().origin();
 }
 
 void
 ThrustWindow::PlatformMove(int x, int y)
 {
+  if(headless_) {
+    headless_host_->SetBounds(
+        gfx::Rect(gfx::Point(x, y), headless_host_->GetBounds().size()));
+    return;
+  }
   gfx::Size size = window_->GetWindowBoundsInScreen().size();
   gfx::Rect bounds(x, y, size.width(), size.height());
   window_->SetBounds(bounds);
@@ -435,6 +508,12 @@ ThrustWindow::PlatformMove(int x, int y)
 void
 ThrustWindow::PlatformResize(int width, int height)
 {
+  if(headless_) {
+    headless_host_->SetBounds(
+        gfx::Rect(headless_host_->GetBounds().origin(),
+                  gfx::Size(width, height)));
+    return;
+  }
   gfx::Point origin = window_->GetWindowBoundsInScreen().origin();
   gfx::Rect bounds(origin.x(), origin.y(), width, height);
   window_->SetBounds(bounds);
@@ -443,6 +522,9 @@ ThrustWindow::PlatformResize(int width, int height)
 gfx::NativeWindow
 ThrustWindow::PlatformGetNativeWindow() 
 {
+  if(headless_) {
+    return headless_host_->GetNativeWindow();
+  }
   return window_->GetNativeWindow(); 
 }
 
@@ -450,26 +532,7 @@ void
 ThrustWindow::PlatformUpdateDraggableRegions(
     const std::vector<DraggableRegion>& regions)
 {
-  if(has_frame_) {
-    return;
-  }
-
-  SkRegion* draggable_region = new SkRegion;
-
-  // By default, the whole window is non-draggable. We need to explicitly
-  // include those draggable regions.
-  for (std::vector<DraggableRegion>::const_iterator iter = regions.begin();
-       iter != regions.end(); ++iter) {
-    const DraggableRegion& region = *iter;
-    draggable_region->op(
-        region.bounds.x(),
-        region.bounds.y(),
-        region.bounds.right(),
-        region.bounds.bottom(),
-        region.draggable ? SkRegion::kUnion_Op : SkRegion::kDifference_Op);
-  }
-
-  draggable_region_.reset(draggable_region);
+  /* The frameless view hit-tests against `draggable_region_` directly. */
 }
 
 
@@ -494,6 +557,29 @@ ThrustWindow::OnWidgetActivationChanged(
   if(active && web_contents()) {
     web_contents()->Focus();
   }
+
+  /* Minimization is not notified as such but changes the activation. */
+  UpdateBackgroundState();
+}
+
+void
+ThrustWindow::OnWidgetVisibilityChanged(
+    views::Widget* widget,
+    bool visible)
+{
+  if(widget != window_.get())
+    return;
+  UpdateBackgroundState();
+}
+
+void
+ThrustWindow::OnWidgetBoundsChanged(
+    views::Widget* widget,
+    const gfx::Rect& new_bounds)
+{
+  if(widget != window_.get())
+    return;
+  UpdateBackgroundState();
 }
 
 
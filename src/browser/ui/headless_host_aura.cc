@@ -0,0 +1,87 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/ui/headless_host_aura.h"
+
+#include "ui/aura/window.h"
+#include "ui/aura/window_tree_host.h"
+#include "ui/compositor/compositor.h"
+
+namespace thrust_shell {
+
+ThrustHeadlessHost::ThrustHeadlessHost(
+    const gfx::Rect& bounds)
+: bounds_(bounds),
+  host_(aura::WindowTreeHost::Create(bounds)),
+  contents_(NULL)
+{
+  host_->InitHost();
+  host_->window()->Show();
+  /* The host itself is never shown (mapped) which leaves its compositor */
+  /* hidden: it is made visible so that the content keeps being drawn.   */
+  host_->compositor()->SetVisible(true);
+}
+
+ThrustHeadlessHost::~ThrustHeadlessHost()
+{
+  Close();
+}
+
+void
+ThrustHeadlessHost::SetContents(
+    aura::Window* contents)
+{
+  if(contents_) {
+    contents_->RemoveObserver(this);
+    if(contents_->parent())
+      contents_->parent()->RemoveChild(contents_);
+  }
+  contents_ = contents;
+  if(!contents_ || !host_)
+    return;
+
+  /* The content view is owned by its WebContents, which may outlive the */
+  /* host (or be destroyed first).                                      */
+  contents_->AddObserver(this);
+  host_->window()->AddChild(contents_);
+  contents_->SetBounds(gfx::Rect(bounds_.size()));
+  contents_->Show();
+}
+
+void
+ThrustHeadlessHost::Close()
+{
+  SetContents(NULL);
+  host_.reset();
+}
+
+void
+ThrustHeadlessHost::SetBounds(
+    const gfx::Rect& bounds)
+{
+  bounds_ = bounds;
+  if(host_)
+    host_->SetBounds(bounds_);
+  if(contents_)
+    contents_->SetBounds(gfx::Rect(bounds_.size()));
+}
+
+gfx::NativeWindow
+ThrustHeadlessHost::GetNativeWindow()
+{
+  return host_ ? host_->window() : NULL;
+}
+
+/******************************************************************************/
+/* WINDOWOBSERVER IMPLEMENTATION */
+/******************************************************************************/
+void
+ThrustHeadlessHost::OnWindowDestroying(
+    aura::Window* window)
+{
+  DCHECK_EQ(contents_, window);
+  contents_->RemoveObserver(this);
+  contents_ = NULL;
+}
+
+} // namespace thrust_shell
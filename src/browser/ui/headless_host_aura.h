@@ -0,0 +1,70 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_UI_HEADLESS_HOST_AURA_H_
+#define THRUST_SHELL_BROWSER_UI_HEADLESS_HOST_AURA_H_
+
+#include "base/memory/scoped_ptr.h"
+#include "ui/aura/window_observer.h"
+#include "ui/gfx/native_widget_types.h"
+#include "ui/gfx/rect.h"
+
+namespace aura {
+class Window;
+class WindowTreeHost;
+}
+
+namespace thrust_shell {
+
+// ### ThrustHeadlessHost
+//
+// Hosts the content view of a headless ThrustWindow without any views::Widget
+// (no frame, client or non-client view, no desktop native widget and no
+// window manager interaction). The content view is parented to the root
+// window of a bare aura::WindowTreeHost which is never shown but whose
+// compositor is kept visible so that frames are produced for capture.
+//
+// On X11 the compositor output surface is still an X window (never mapped):
+// Chromium 38 has no compositor output without a display server, so an X
+// server (Xvfb is enough) is required.
+class ThrustHeadlessHost : public aura::WindowObserver {
+public:
+  explicit ThrustHeadlessHost(const gfx::Rect& bounds);
+  virtual ~ThrustHeadlessHost();
+
+  // ### SetContents
+  // ```
+  // @contents {Window} the content view to host (not owned)
+  // ```
+  void SetContents(aura::Window* contents);
+
+  // ### Close
+  // Detaches the content view and destroys the host. The bounds are kept.
+  void Close();
+
+  // ### GetBounds
+  // Returns the bounds of the (never displayed) window.
+  const gfx::Rect& GetBounds() const { return bounds_; }
+  // ### SetBounds
+  void SetBounds(const gfx::Rect& bounds);
+
+  // ### GetNativeWindow
+  // Returns the root window of the host (NULL once closed).
+  gfx::NativeWindow GetNativeWindow();
+
+  /****************************************************************************/
+  /* WINDOWOBSERVER IMPLEMENTATION */
+  /****************************************************************************/
+  virtual void OnWindowDestroying(aura::Window* window) OVERRIDE;
+
+private:
+  gfx::Rect                                  bounds_;
+  scoped_ptr<aura::WindowTreeHost>           host_;
+  aura::Window*                              contents_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustHeadlessHost);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_UI_HEADLESS_HOST_AURA_H_
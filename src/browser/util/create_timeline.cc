@@ -0,0 +1,123 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/util/create_timeline.h"
+
+#include "base/values.h"
+
+namespace thrust_shell {
+
+namespace {
+
+const char* kPhaseNames[] = {
+  "received", "constructed", "shown", "committed", "first_paint"
+};
+
+}
+
+/******************************************************************************/
+/* THRUSTCREATETIMELINE */
+/******************************************************************************/
+ThrustCreateTimeline::ThrustCreateTimeline()
+{
+  marks_[PHASE_RECEIVED] = base::TimeTicks::Now();
+}
+
+void
+ThrustCreateTimeline::SetReceived(
+    base::TimeTicks received)
+{
+  if(!received.is_null())
+    marks_[PHASE_RECEIVED] = received;
+}
+
+void
+ThrustCreateTimeline::Mark(
+    Phase phase)
+{
+  if(marks_[phase].is_null())
+    marks_[phase] = base::TimeTicks::Now();
+}
+
+bool
+ThrustCreateTimeline::HasMark(
+    Phase phase) const
+{
+  return !marks_[phase].is_null();
+}
+
+base::TimeDelta
+ThrustCreateTimeline::Elapsed(
+    Phase phase) const
+{
+  if(!HasMark(phase) || marks_[phase] < marks_[PHASE_RECEIVED])
+    return base::TimeDelta();
+  return marks_[phase] - marks_[PHASE_RECEIVED];
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustCreateTimeline::ToValue() const
+{
+  scoped_ptr<base::DictionaryValue> timeline(new base::DictionaryValue);
+  for(int i = 0; i < PHASE_COUNT; ++i) {
+    Phase phase = static_cast<Phase>(i);
+    if(HasMark(phase))
+      timeline->SetDouble(PhaseName(phase), Elapsed(phase).InMillisecondsF());
+  }
+  return timeline.Pass();
+}
+
+// static
+const char*
+ThrustCreateTimeline::PhaseName(
+    Phase phase)
+{
+  return kPhaseNames[phase];
+}
+
+/******************************************************************************/
+/* THRUSTCREATETIMINGS */
+/******************************************************************************/
+ThrustCreateTimings::ThrustCreateTimings()
+: count_(0)
+{
+}
+
+void
+ThrustCreateTimings::Add(
+    const ThrustCreateTimeline& timeline)
+{
+  count_++;
+  /* PHASE_RECEIVED is the origin of the timeline. */
+  for(int i = ThrustCreateTimeline::PHASE_CONSTRUCTED;
+      i < ThrustCreateTimeline::PHASE_COUNT; ++i) {
+    ThrustCreateTimeline::Phase phase =
+      static_cast<ThrustCreateTimeline::Phase>(i);
+    if(timeline.HasMark(phase))
+      phases_[i].Add(timeline.Elapsed(phase));
+  }
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustCreateTimings::ToValue() const
+{
+  scoped_ptr<base::DictionaryValue> timings(new base::DictionaryValue);
+  timings->SetInteger("count", count_);
+  for(int i = ThrustCreateTimeline::PHASE_CONSTRUCTED;
+      i < ThrustCreateTimeline::PHASE_COUNT; ++i) {
+    timings->Set(ThrustCreateTimeline::PhaseName(
+                     static_cast<ThrustCreateTimeline::Phase>(i)),
+                 phases_[i].ToValue());
+  }
+  return timings.Pass();
+}
+
+void
+ThrustCreateTimings::Reset()
+{
+  count_ = 0;
+  for(int i = 0; i < ThrustCreateTimeline::PHASE_COUNT; ++i)
+    phases_[i] = ThrustShellTimeHistogram();
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,88 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_UTIL_CREATE_TIMELINE_H_
+#define THRUST_SHELL_BROWSER_UTIL_CREATE_TIMELINE_H_
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+
+#include "src/net/net_stats.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace thrust_shell {
+
+// ### ThrustCreateTimeline
+//
+// Records when the successive phases of the creation of a window or a
+// <webview> guest happened, from the reception of the request (API `create`
+// action or guest creation IPC) to the first paint of its content. Only the
+// first occurrence of each phase is recorded.
+class ThrustCreateTimeline {
+public:
+  enum Phase {
+    PHASE_RECEIVED = 0,
+    PHASE_CONSTRUCTED,
+    PHASE_SHOWN,
+    PHASE_COMMITTED,
+    PHASE_FIRST_PAINT,
+    PHASE_COUNT
+  };
+
+  // Starts the timeline now.
+  ThrustCreateTimeline();
+
+  // ### SetReceived
+  // Moves the start of the timeline to the reception of the request.
+  void SetReceived(base::TimeTicks received);
+
+  // ### Mark
+  // Records |phase| now, unless already recorded.
+  void Mark(Phase phase);
+  bool HasMark(Phase phase) const;
+
+  // ### Elapsed
+  // Returns the time between the reception and |phase|.
+  base::TimeDelta Elapsed(Phase phase) const;
+
+  // ### ToValue
+  // Returns the elapsed time in ms of each recorded phase: `received` (0),
+  // `constructed`, `shown`, `committed` and `first_paint`.
+  scoped_ptr<base::DictionaryValue> ToValue() const;
+
+  static const char* PhaseName(Phase phase);
+
+private:
+  base::TimeTicks                   marks_[PHASE_COUNT];
+};
+
+// ### ThrustCreateTimings
+//
+// Aggregates complete timelines into a histogram per phase.
+class ThrustCreateTimings {
+public:
+  ThrustCreateTimings();
+
+  // ### Add
+  // Records the phases of |timeline| (missing phases are not recorded).
+  void Add(const ThrustCreateTimeline& timeline);
+
+  // ### ToValue
+  // Returns the number of timelines (`count`) along with a histogram summary
+  // per phase (see ThrustShellTimeHistogram).
+  scoped_ptr<base::DictionaryValue> ToValue() const;
+
+  void Reset();
+
+private:
+  uint32                            count_;
+  ThrustShellTimeHistogram          phases_[ThrustCreateTimeline::PHASE_COUNT];
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_UTIL_CREATE_TIMELINE_H_
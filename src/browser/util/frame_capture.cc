@@ -0,0 +1,454 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/util/frame_capture.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/process/process_handle.h"
+#include "base/strings/stringprintf.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/values.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/render_view_host.h"
+#include "content/public/browser/render_widget_host_view.h"
+#include "content/public/browser/web_contents.h"
+#include "skia/ext/image_operations.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/codec/jpeg_codec.h"
+#include "ui/gfx/codec/png_codec.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+namespace {
+
+const int kDefaultJPEGQuality = 90;
+/* Frames larger than this are refused. */
+const int kMaxFrameDimension = 8192;
+
+/* Streams rate bounds (frames per second). */
+const int kDefaultStreamRate = 10;
+const int kMaxStreamRate = 30;
+/* Files reused in turn by a stream. */
+const size_t kStreamSlots = 4;
+
+unsigned int s_next_slots_id = 0;
+
+struct EncodedFrame {
+  EncodedFrame()
+  : width(0),
+    height(0),
+    size(0) {}
+
+  std::string        error;
+  base::FilePath     path;
+  int                width;
+  int                height;
+  size_t             size;
+};
+
+/* Frame file names are confined to the frame directory: no absolute path, */
+/* parent reference or sub-directory is accepted.                          */
+bool
+IsValidFrameName(
+    const base::FilePath& path)
+{
+  return !path.IsAbsolute() &&
+         !path.ReferencesParent() &&
+         path.BaseName() == path &&
+         path.BaseName().value() != base::FilePath::kCurrentDirectory;
+}
+
+/* Called on the blocking pool. */
+bool
+GetFrameDir(
+    base::FilePath* dir)
+{
+#if defined(OS_LINUX)
+  return base::GetShmemTempDir(false, dir);
+#else
+  return base::GetTempDir(dir);
+#endif
+}
+
+/* Called on the blocking pool. */
+bool
+ResolveFramePath(
+    const base::FilePath& path,
+    base::FilePath* resolved)
+{
+  base::FilePath dir;
+  if(!GetFrameDir(&dir))
+    return false;
+  if(path.empty())
+    return base::CreateTemporaryFileInDir(dir, resolved);
+  if(!IsValidFrameName(path))
+    return false;
+  *resolved = dir.Append(path);
+  return dir.IsParent(*resolved);
+}
+
+/* Called on the blocking pool. The frame is written to a temporary file */
+/* renamed over |path| so that a reader never sees a partial frame.      */
+bool
+WriteFrameFile(
+    const base::FilePath& path,
+    const std::vector<unsigned char>& data)
+{
+  base::FilePath tmp;
+  if(!base::CreateTemporaryFileInDir(path.DirName(), &tmp))
+    return false;
+  if(base::WriteFile(tmp,
+                     reinterpret_cast<const char*>(&data[0]),
+                     data.size()) != static_cast<int>(data.size()) ||
+     !base::ReplaceFile(tmp, path, NULL)) {
+    base::DeleteFile(tmp, false);
+    return false;
+  }
+  return true;
+}
+
+/* Called on the blocking pool. */
+EncodedFrame
+EncodeFrame(
+    const SkBitmap& bitmap,
+    const ThrustFrameCapture::Options& options)
+{
+  EncodedFrame frame;
+
+  SkBitmap scaled = bitmap;
+  if(!options.size.IsEmpty() &&
+     (bitmap.width() != options.size.width() ||
+      bitmap.height() != options.size.height())) {
+    /* The copy was not scaled by the compositor (software path). */
+    scaled = skia::ImageOperations::Resize(
+        bitmap, skia::ImageOperations::RESIZE_GOOD,
+        options.size.width(), options.size.height());
+  }
+
+  std::vector<unsigned char> data;
+  bool encoded = false;
+  if(options.format == "jpeg") {
+    SkAutoLockPixels lock(scaled);
+    encoded = gfx::JPEGCodec::Encode(
+        reinterpret_cast<const unsigned char*>(scaled.getPixels()),
+        gfx::JPEGCodec::FORMAT_SkBitmap,
+        scaled.width(), scaled.height(),
+        static_cast<int>(scaled.rowBytes()),
+        options.quality, &data);
+  }
+  else {
+    encoded = gfx::PNGCodec::EncodeBGRASkBitmap(scaled, false, &data);
+  }
+  if(!encoded) {
+    frame.error = "frame_capture:encode_failed";
+    return frame;
+  }
+
+  if(!ResolveFramePath(options.path, &frame.path) ||
+     !WriteFrameFile(frame.path, data)) {
+    frame.error = "frame_capture:write_failed";
+    return frame;
+  }
+
+  frame.width = scaled.width();
+  frame.height = scaled.height();
+  frame.size = data.size();
+  return frame;
+}
+
+void
+OnEncoded(
+    const ThrustFrameCapture::Options& options,
+    const base::TimeTicks& start,
+    const ThrustFrameCapture::CaptureCallback& callback,
+    const EncodedFrame& encoded)
+{
+  if(!encoded.error.empty()) {
+    callback.Run(encoded.error, scoped_ptr<base::DictionaryValue>());
+    return;
+  }
+
+  scoped_ptr<base::DictionaryValue> frame(new base::DictionaryValue);
+  frame->SetString("path", encoded.path.AsUTF8Unsafe());
+  frame->SetString("format", options.format);
+  frame->SetInteger("width", encoded.width);
+  frame->SetInteger("height", encoded.height);
+  frame->SetInteger("size", static_cast<int>(encoded.size));
+  frame->SetDouble("time",
+                   (base::TimeTicks::Now() - start).InMillisecondsF());
+  callback.Run(std::string(), frame.Pass());
+}
+
+/* Called on the blocking pool. */
+void
+DeleteFrameFiles(
+    const std::vector<base::FilePath>& paths)
+{
+  for(size_t i = 0; i < paths.size(); ++i) {
+    base::FilePath resolved;
+    if(ResolveFramePath(paths[i], &resolved))
+      base::DeleteFile(resolved, false);
+  }
+}
+
+}
+
+/******************************************************************************/
+/* THRUSTFRAMECAPTURE */
+/******************************************************************************/
+ThrustFrameCapture::Options::Options()
+: format("png"),
+  quality(kDefaultJPEGQuality)
+{
+}
+
+// static
+bool
+ThrustFrameCapture::ParseOptions(
+    const base::DictionaryValue& args,
+    Options* options,
+    std::string* error)
+{
+  args.GetString("format", &options->format);
+  if(options->format == "jpg")
+    options->format = "jpeg";
+  if(options->format != "png" && options->format != "jpeg") {
+    /* No WebP encoder is exposed by ui/gfx/codec. */
+    *error = "frame_capture:invalid_format";
+    return false;
+  }
+
+  args.GetInteger("quality", &options->quality);
+  options->quality = std::max(0, std::min(100, options->quality));
+
+  int width = 0;
+  int height = 0;
+  if(args.GetInteger("size.width", &width) &&
+     args.GetInteger("size.height", &height)) {
+    if(width <= 0 || height <= 0 ||
+       width > kMaxFrameDimension || height > kMaxFrameDimension) {
+      *error = "frame_capture:invalid_size";
+      return false;
+    }
+    options->size = gfx::Size(width, height);
+  }
+
+  std::string path;
+  if(args.GetString("path", &path)) {
+    options->path = base::FilePath::FromUTF8Unsafe(path);
+    if(!options->path.empty() && !IsValidFrameName(options->path)) {
+      *error = "frame_capture:invalid_path";
+      return false;
+    }
+  }
+  return true;
+}
+
+// static
+void
+ThrustFrameCapture::Capture(
+    WebContents* web_contents,
+    const Options& options,
+    const CaptureCallback& callback)
+{
+  Capture(web_contents, options, BrowserThread::GetBlockingPool(), callback);
+}
+
+// static
+void
+ThrustFrameCapture::Capture(
+    WebContents* web_contents,
+    const Options& options,
+    const scoped_refptr<base::TaskRunner>& task_runner,
+    const CaptureCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  RenderViewHost* rvh = web_contents ? web_contents->GetRenderViewHost() : NULL;
+  if(!rvh || !rvh->GetView()) {
+    scoped_ptr<base::DictionaryValue> none;
+    base::MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(callback, std::string("frame_capture:no_view"),
+                   base::Passed(none.Pass())));
+    return;
+  }
+
+  gfx::Size dst_size = options.size;
+  if(dst_size.IsEmpty())
+    dst_size = rvh->GetView()->GetViewBounds().size();
+
+  rvh->CopyFromBackingStore(
+      gfx::Rect(),
+      dst_size,
+      base::Bind(&ThrustFrameCapture::OnCopied,
+                 options, base::TimeTicks::Now(), task_runner, callback),
+      kN32_SkColorType);
+}
+
+// static
+void
+ThrustFrameCapture::OnCopied(
+    const Options& options,
+    const base::TimeTicks& start,
+    const scoped_refptr<base::TaskRunner>& task_runner,
+    const CaptureCallback& callback,
+    bool success,
+    const SkBitmap& bitmap)
+{
+  if(!success || bitmap.isNull()) {
+    callback.Run("frame_capture:copy_failed",
+                 scoped_ptr<base::DictionaryValue>());
+    return;
+  }
+
+  /* The bitmap is only guaranteed to be valid for the duration of this */
+  /* callback.                                                          */
+  SkBitmap copy;
+  if(!bitmap.deepCopyTo(&copy)) {
+    callback.Run("frame_capture:copy_failed",
+                 scoped_ptr<base::DictionaryValue>());
+    return;
+  }
+
+  base::PostTaskAndReplyWithResult(
+      task_runner.get(),
+      FROM_HERE,
+      base::Bind(&EncodeFrame, copy, options),
+      base::Bind(&OnEncoded, options, start, callback));
+}
+
+/******************************************************************************/
+/* THRUSTFRAMESLOTS */
+/******************************************************************************/
+ThrustFrameSlots::ThrustFrameSlots(
+    size_t count)
+: next_(0),
+  task_runner_(
+      BrowserThread::GetBlockingPool()->GetSequencedTaskRunner(
+          BrowserThread::GetBlockingPool()->GetSequenceToken()))
+{
+  DCHECK_GT(count, 0U);
+  unsigned int slots_id = ++s_next_slots_id;
+  for(size_t i = 0; i < count; ++i) {
+    slots_.push_back(base::FilePath::FromUTF8Unsafe(
+        base::StringPrintf("thrust-frame-%d-%u-%u",
+                           static_cast<int>(base::GetCurrentProcId()),
+                           slots_id, static_cast<unsigned int>(i))));
+  }
+}
+
+ThrustFrameSlots::~ThrustFrameSlots()
+{
+  /* Sequenced after any frame still being encoded to one of the slots. */
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&DeleteFrameFiles, slots_));
+}
+
+base::FilePath
+ThrustFrameSlots::Next()
+{
+  base::FilePath slot = slots_[next_];
+  next_ = (next_ + 1) % slots_.size();
+  return slot;
+}
+
+bool
+ThrustFrameSlots::Release(
+    const std::string& path)
+{
+  base::FilePath name = base::FilePath::FromUTF8Unsafe(path).BaseName();
+  if(std::find(slots_.begin(), slots_.end(), name) == slots_.end())
+    return false;
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&DeleteFrameFiles, std::vector<base::FilePath>(1, name)));
+  return true;
+}
+
+/******************************************************************************/
+/* THRUSTFRAMESTREAM */
+/******************************************************************************/
+ThrustFrameStream::ThrustFrameStream(
+    WebContents* web_contents,
+    const ThrustFrameCapture::Options& options,
+    int rate,
+    const FrameCallback& callback)
+: WebContentsObserver(web_contents),
+  options_(options),
+  rate_(rate > 0 ? std::min(rate, kMaxStreamRate) : kDefaultStreamRate),
+  callback_(callback),
+  slots_(kStreamSlots),
+  in_flight_(false),
+  seq_(0),
+  skipped_(0),
+  weak_factory_(this)
+{
+  timer_.Start(FROM_HERE,
+               base::TimeDelta::FromMilliseconds(1000 / rate_),
+               this,
+               &ThrustFrameStream::Tick);
+}
+
+ThrustFrameStream::~ThrustFrameStream()
+{
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustFrameStream::ToValue() const
+{
+  scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetInteger("rate", rate_);
+  value->SetInteger("frames", seq_);
+  value->SetInteger("skipped", skipped_);
+  return value.Pass();
+}
+
+void
+ThrustFrameStream::WebContentsDestroyed()
+{
+  timer_.Stop();
+}
+
+void
+ThrustFrameStream::Tick()
+{
+  if(in_flight_) {
+    skipped_++;
+    return;
+  }
+  in_flight_ = true;
+
+  unsigned int seq = seq_++;
+  ThrustFrameCapture::Options options = options_;
+  options.path = slots_.Next();
+  ThrustFrameCapture::Capture(
+      web_contents(),
+      options,
+      slots_.task_runner(),
+      base::Bind(&ThrustFrameStream::OnFrame,
+                 weak_factory_.GetWeakPtr(), seq));
+}
+
+void
+ThrustFrameStream::OnFrame(
+    unsigned int seq,
+    const std::string& error,
+    scoped_ptr<base::DictionaryValue> frame)
+{
+  in_flight_ = false;
+  if(frame)
+    frame->SetInteger("seq", seq);
+  callback_.Run(error, frame.Pass());
+}
+
+} // namespace thrust_shell
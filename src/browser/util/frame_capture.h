@@ -0,0 +1,194 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_UTIL_FRAME_CAPTURE_H_
+#define THRUST_SHELL_BROWSER_UTIL_FRAME_CAPTURE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "content/public/browser/web_contents_observer.h"
+#include "ui/gfx/size.h"
+
+class SkBitmap;
+
+namespace base {
+class DictionaryValue;
+class SequencedTaskRunner;
+class TaskRunner;
+}
+
+namespace content {
+class WebContents;
+}
+
+namespace thrust_shell {
+
+// ### ThrustFrameCapture
+//
+// Captures the content of a WebContents from its backing store. The copy is
+// done by the compositor (scaled to the requested size when accelerated),
+// software scaling and PNG/JPEG encoding run on the blocking pool and the
+// encoded frame is written to a file in the shared memory directory
+// (`/dev/shm` on Linux) so that only its path goes through the API.
+//
+// Frame files written to a new temporary file belong to the caller, who is
+// expected to delete them. Untrusted callers capture to ThrustFrameSlots.
+class ThrustFrameCapture {
+public:
+  struct Options {
+    Options();
+
+    // "png" or "jpeg".
+    std::string        format;
+    // JPEG quality (0-100).
+    int                quality;
+    // Target size of the frame (empty for the view size).
+    gfx::Size          size;
+    // Name of the file to write in the shared memory directory (a new
+    // temporary file if empty). Absolute paths, parent references and
+    // sub-directories are refused.
+    base::FilePath     path;
+  };
+
+  // Called with an error (empty on success) and the frame description:
+  // `path`, `format`, `width`, `height`, `size` (bytes) and `time` (ms).
+  typedef base::Callback<void(const std::string& error,
+                              scoped_ptr<base::DictionaryValue> frame)>
+    CaptureCallback;
+
+  // ### ParseOptions
+  // ```
+  // @args    {DictionaryValue} `format`, `quality`, `size.width`,
+  //                            `size.height`, `path`
+  // @options {Options} the parsed options
+  // ```
+  // Returns false and sets |error| if |args| are invalid.
+  static bool ParseOptions(const base::DictionaryValue& args,
+                           Options* options,
+                           std::string* error);
+
+  // ### Capture
+  // ```
+  // @web_contents {WebContents} the contents to capture
+  // @options      {Options} capture options
+  // @callback     {CaptureCallback} called on the UI thread when done
+  // ```
+  static void Capture(content::WebContents* web_contents,
+                      const Options& options,
+                      const CaptureCallback& callback);
+  // Same as above, encoding and writing the frame on |task_runner|.
+  static void Capture(content::WebContents* web_contents,
+                      const Options& options,
+                      const scoped_refptr<base::TaskRunner>& task_runner,
+                      const CaptureCallback& callback);
+
+private:
+  static void OnCopied(const Options& options,
+                       const base::TimeTicks& start,
+                       const scoped_refptr<base::TaskRunner>& task_runner,
+                       const CaptureCallback& callback,
+                       bool success,
+                       const SkBitmap& bitmap);
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ThrustFrameCapture);
+};
+
+// ### ThrustFrameSlots
+//
+// A small ring of frame files in the shared memory directory, reused in turn
+// and deleted with the ring, which bounds the memory used by the frames of a
+// capturer: a frame must be consumed before its slot is overwritten. Frames
+// are encoded and the files deleted on the ring sequence, and each frame is
+// renamed into place so that a reader never sees a partial frame.
+class ThrustFrameSlots {
+public:
+  explicit ThrustFrameSlots(size_t count);
+  ~ThrustFrameSlots();
+
+  // ### Next
+  // Returns the name of the next slot to write a frame to.
+  base::FilePath Next();
+
+  // ### Release
+  // ```
+  // @path {string} the path of a frame written to one of the slots
+  // ```
+  // Deletes the frame file at |path| before the ring is destroyed. Returns
+  // false if |path| is not one of the slots of this ring.
+  bool Release(const std::string& path);
+
+  // The sequence frames written to the slots must be encoded on.
+  const scoped_refptr<base::SequencedTaskRunner>& task_runner() const {
+    return task_runner_;
+  }
+
+private:
+  std::vector<base::FilePath>                   slots_;
+  size_t                                        next_;
+  scoped_refptr<base::SequencedTaskRunner>      task_runner_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustFrameSlots);
+};
+
+// ### ThrustFrameStream
+//
+// Repeatedly captures a WebContents at a capped rate. A tick is skipped while
+// the previous frame is still being captured or encoded, so that a slow
+// encoder lowers the effective rate instead of queuing frames. Frames are
+// written to a ThrustFrameSlots ring deleted with the stream.
+class ThrustFrameStream : public content::WebContentsObserver {
+public:
+  // Called for each frame, as ThrustFrameCapture::CaptureCallback, the frame
+  // description also includes its sequence number `seq`.
+  typedef ThrustFrameCapture::CaptureCallback FrameCallback;
+
+  ThrustFrameStream(content::WebContents* web_contents,
+                    const ThrustFrameCapture::Options& options,
+                    int rate,
+                    const FrameCallback& callback);
+  virtual ~ThrustFrameStream();
+
+  // ### ToValue
+  // Returns the stream statistics: `rate`, `frames` and `skipped`.
+  scoped_ptr<base::DictionaryValue> ToValue() const;
+
+  /****************************************************************************/
+  /* WEBCONTENTSOBSERVER IMPLEMENTATION                                       */
+  /****************************************************************************/
+  virtual void WebContentsDestroyed() OVERRIDE;
+
+private:
+  void Tick();
+  void OnFrame(unsigned int seq,
+               const std::string& error,
+               scoped_ptr<base::DictionaryValue> frame);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  ThrustFrameCapture::Options                   options_;
+  int                                           rate_;
+  FrameCallback                                 callback_;
+  ThrustFrameSlots                              slots_;
+
+  bool                                          in_flight_;
+  unsigned int                                  seq_;
+  unsigned int                                  skipped_;
+
+  base::RepeatingTimer<ThrustFrameStream>       timer_;
+  base::WeakPtrFactory<ThrustFrameStream>       weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustFrameStream);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_UTIL_FRAME_CAPTURE_H_
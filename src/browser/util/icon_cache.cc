@@ -0,0 +1,166 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/browser/util/icon_cache.h"
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/files/file.h"
+#include "base/message_loop/message_loop.h"
+#include "base/task_runner_util.h"
+#include "content/public/browser/browser_thread.h"
+#include "ui/gfx/codec/jpeg_codec.h"
+#include "ui/gfx/codec/png_codec.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+namespace {
+
+/* Decoded icons kept in memory. */
+const size_t kMaxCachedIcons = 32;
+
+/* Called on the blocking pool. Returns a null time if the file is missing. */
+base::Time
+StatIcon(
+    const base::FilePath& path)
+{
+  base::File::Info info;
+  if(!base::GetFileInfo(path, &info) || info.is_directory)
+    return base::Time();
+  return info.last_modified;
+}
+
+/* Called on the blocking pool. Returns a null bitmap on error. */
+SkBitmap
+DecodeIcon(
+    const base::FilePath& path)
+{
+  SkBitmap bitmap;
+  std::string file_contents;
+  if(!base::ReadFileToString(path, &file_contents))
+    return bitmap;
+
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(file_contents.data());
+  size_t size = file_contents.size();
+  if(!gfx::PNGCodec::Decode(data, size, &bitmap)) {
+    scoped_ptr<SkBitmap> decoded(gfx::JPEGCodec::Decode(data, size));
+    if(decoded)
+      bitmap = *decoded;
+  }
+  /* Pixels are shared with the UI thread from now on. */
+  bitmap.setImmutable();
+  return bitmap;
+}
+
+}
+
+// static
+ThrustIconCache*
+ThrustIconCache::GetInstance()
+{
+  return Singleton<ThrustIconCache>::get();
+}
+
+ThrustIconCache::ThrustIconCache()
+: cache_(kMaxCachedIcons),
+  weak_factory_(this)
+{
+}
+
+ThrustIconCache::~ThrustIconCache()
+{
+}
+
+void
+ThrustIconCache::Load(
+    const base::FilePath& path,
+    const IconCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(path.empty()) {
+    base::MessageLoop::current()->PostTask(
+        FROM_HERE, base::Bind(callback, gfx::ImageSkia()));
+    return;
+  }
+
+  /* A load of this path is already in flight, its result is shared. */
+  std::vector<IconCallback>& callbacks = pending_[path];
+  callbacks.push_back(callback);
+  if(callbacks.size() > 1)
+    return;
+
+  /* The modification time is checked on each load so that an updated file */
+  /* is not served stale from the cache.                                    */
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetBlockingPool(),
+      FROM_HERE,
+      base::Bind(&StatIcon, path),
+      base::Bind(&ThrustIconCache::OnStat,
+                 weak_factory_.GetWeakPtr(), path));
+}
+
+void
+ThrustIconCache::OnStat(
+    const base::FilePath& path,
+    const base::Time& last_modified)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(last_modified.is_null()) {
+    RunCallbacks(path, gfx::ImageSkia());
+    return;
+  }
+
+  base::MRUCache<IconKey, gfx::ImageSkia>::iterator it =
+    cache_.Get(IconKey(path, last_modified));
+  if(it != cache_.end()) {
+    RunCallbacks(path, it->second);
+    return;
+  }
+
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetBlockingPool(),
+      FROM_HERE,
+      base::Bind(&DecodeIcon, path),
+      base::Bind(&ThrustIconCache::OnDecoded,
+                 weak_factory_.GetWeakPtr(), path, last_modified));
+}
+
+void
+ThrustIconCache::OnDecoded(
+    const base::FilePath& path,
+    const base::Time& last_modified,
+    const SkBitmap& bitmap)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  gfx::ImageSkia icon;
+  if(!bitmap.isNull()) {
+    icon = gfx::ImageSkia::CreateFrom1xBitmap(bitmap);
+    cache_.Put(IconKey(path, last_modified), icon);
+  }
+  else {
+    LOG(INFO) << "ThrustIconCache: failed to decode " << path.value();
+  }
+  RunCallbacks(path, icon);
+}
+
+void
+ThrustIconCache::RunCallbacks(
+    const base::FilePath& path,
+    const gfx::ImageSkia& icon)
+{
+  std::map<base::FilePath, std::vector<IconCallback> >::iterator it =
+    pending_.find(path);
+  if(it == pending_.end())
+    return;
+  std::vector<IconCallback> callbacks;
+  callbacks.swap(it->second);
+  pending_.erase(it);
+
+  for(size_t i = 0; i < callbacks.size(); ++i)
+    callbacks[i].Run(icon);
+}
+
+} // namespace thrust_shell
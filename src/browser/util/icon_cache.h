@@ -0,0 +1,76 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_BROWSER_UTIL_ICON_CACHE_H_
+#define THRUST_SHELL_BROWSER_UTIL_ICON_CACHE_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/singleton.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/image/image_skia.h"
+
+namespace thrust_shell {
+
+// ### ThrustIconCache
+//
+// Loads and decodes PNG or JPEG icons off the UI thread and keeps the decoded
+// images in an LRU cache keyed by path and modification time, shared by all
+// windows (and menus). Concurrent loads of the same path are coalesced into
+// a single read and decode. A modified file is detected by its modification
+// time and decoded again.
+//
+// Lives on the UI thread.
+class ThrustIconCache {
+public:
+  typedef base::Callback<void(const gfx::ImageSkia& icon)> IconCallback;
+
+  static ThrustIconCache* GetInstance();
+
+  // ### Load
+  // ```
+  // @path     {FilePath} the icon file path
+  // @callback {IconCallback} called with the icon (empty on error)
+  // ```
+  // Retrieves the icon at |path|. |callback| is always called asynchronously.
+  void Load(const base::FilePath& path,
+            const IconCallback& callback);
+
+private:
+  friend struct DefaultSingletonTraits<ThrustIconCache>;
+
+  typedef std::pair<base::FilePath, base::Time> IconKey;
+
+  ThrustIconCache();
+  ~ThrustIconCache();
+
+  void OnStat(const base::FilePath& path,
+              const base::Time& last_modified);
+  void OnDecoded(const base::FilePath& path,
+                 const base::Time& last_modified,
+                 const SkBitmap& bitmap);
+  void RunCallbacks(const base::FilePath& path,
+                    const gfx::ImageSkia& icon);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  base::MRUCache<IconKey, gfx::ImageSkia>                 cache_;
+  std::map<base::FilePath, std::vector<IconCallback> >    pending_;
+
+  base::WeakPtrFactory<ThrustIconCache>                   weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustIconCache);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_BROWSER_UTIL_ICON_CACHE_H_
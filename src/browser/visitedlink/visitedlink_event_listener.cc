@@ -4,6 +4,8 @@
 
 #include "src/browser/visitedlink/visitedlink_event_listener.h"
 
+#include <algorithm>
+
 #include "base/memory/shared_memory.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/notification_types.h"
@@ -19,13 +21,34 @@ using content::RenderWidgetHost;
 
 namespace {
 
-// The amount of time we wait to accumulate visited link additions.
+// The amount of time we wait to accumulate visited link additions. The actual
+// interval adapts between the min and max below: it grows while additions
+// arrive faster than renderers can usefully consume them individually and
+// while no renderer is visible, and shrinks back when the rate drops.
 const int kCommitIntervalMs = 100;
+const int kMinCommitIntervalMs = 50;
+const int kMaxCommitIntervalMs = 1000;
 
 // Size of the buffer after which individual link updates deemed not warranted
 // and the overall update should be used instead.
 const unsigned kVisitedLinkBufferThreshold = 50;
 
+// Same as above for renderers with no visible widget. Hidden renderers only
+// get a compact summary (a reset) once they are shown, so there is little
+// point buffering many raw fingerprints for them.
+const unsigned kHiddenVisitedLinkBufferThreshold = 10;
+
+// Size of a commit after which renderers are handed the current table again
+// (followed by a reset) instead of link deltas. This is what happens during
+// bulk imports, which usually resize the table several times as well.
+const unsigned kNewTableBacklogThreshold = 1000;
+
+bool IsProcessVisible(int render_process_id) {
+  content::RenderProcessHost* process =
+      content::RenderProcessHost::FromID(render_process_id);
+  return process && process->VisibleWidgetCount() > 0;
+}
+
 }  // namespace
 
 namespace visitedlink {
@@ -41,7 +64,9 @@ namespace visitedlink {
 class VisitedLinkUpdater {
  public:
   explicit VisitedLinkUpdater(int render_process_id)
-      : reset_needed_(false), render_process_id_(render_process_id) {
+      : new_table_needed_(false),
+        reset_needed_(false),
+        render_process_id_(render_process_id) {
   }
 
   // Informs the renderer about a new visited link table.
@@ -55,6 +80,7 @@ class VisitedLinkUpdater {
     if (base::SharedMemory::IsHandleValid(handle_for_process))
       process->Send(new ChromeViewMsg_VisitedLink_NewTable(
           handle_for_process));
+    new_table_needed_ = false;
   }
 
   // Buffers |links| to update, but doesn't actually relay them.
@@ -62,7 +88,9 @@ class VisitedLinkUpdater {
     if (reset_needed_)
       return;
 
-    if (pending_.size() + links.size() > kVisitedLinkBufferThreshold) {
+    unsigned threshold = IsProcessVisible(render_process_id_) ?
+        kVisitedLinkBufferThreshold : kHiddenVisitedLinkBufferThreshold;
+    if (pending_.size() + links.size() > threshold) {
       // Once the threshold is reached, there's no need to store pending visited
       // link updates -- we opt for resetting the state for all links.
       AddReset();
@@ -79,9 +107,16 @@ class VisitedLinkUpdater {
     pending_.clear();
   }
 
-  // Sends visited link update messages: a list of links whose visited state
-  // changed or reset of visited state for all links.
-  void Update() {
+  // Tells the updater that the renderer should be handed the current table
+  // on its next update instead of having it shared right away.
+  void AddNewTable() {
+    new_table_needed_ = true;
+  }
+
+  // Sends visited link update messages: the current table if a handoff is
+  // pending, then a list of links whose visited state changed or reset of
+  // visited state for all links.
+  void Update(base::SharedMemory* table_memory) {
     content::RenderProcessHost* process =
         content::RenderProcessHost::FromID(render_process_id_);
     if (!process)
@@ -90,6 +125,9 @@ class VisitedLinkUpdater {
     if (!process->VisibleWidgetCount())
       return;
 
+    if (new_table_needed_ && table_memory)
+      SendVisitedLinkTable(table_memory);
+
     if (reset_needed_) {
       process->Send(new ChromeViewMsg_VisitedLink_Reset());
       reset_needed_ = false;
@@ -105,6 +143,7 @@ class VisitedLinkUpdater {
   }
 
  private:
+  bool new_table_needed_;
   bool reset_needed_;
   int render_process_id_;
   VisitedLinkCommon::Fingerprints pending_;
@@ -113,7 +152,8 @@ class VisitedLinkUpdater {
 VisitedLinkEventListener::VisitedLinkEventListener(
     VisitedLinkMaster* master,
     content::BrowserContext* browser_context)
-    : master_(master),
+    : commit_interval_(TimeDelta::FromMilliseconds(kCommitIntervalMs)),
+      master_(master),
       browser_context_(browser_context) {
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_CREATED,
                  content::NotificationService::AllBrowserContextsAndSources());
@@ -132,7 +172,9 @@ void VisitedLinkEventListener::NewTable(base::SharedMemory* table_memory) {
   if (!table_memory)
     return;
 
-  // Send to all RenderProcessHosts.
+  // Send to all visible RenderProcessHosts. Hidden ones are handed the table
+  // that is current when they are shown, which spares them the intermediate
+  // tables of successive resizes. Their old mapping stays valid until then.
   for (Updaters::iterator i = updaters_.begin(); i != updaters_.end(); ++i) {
     // Make sure to not send to incognito renderers.
     content::RenderProcessHost* process =
@@ -140,7 +182,10 @@ void VisitedLinkEventListener::NewTable(base::SharedMemory* table_memory) {
     if (!process)
       continue;
 
-    i->second->SendVisitedLinkTable(table_memory);
+    if (process->VisibleWidgetCount())
+      i->second->SendVisitedLinkTable(table_memory);
+    else
+      i->second->AddNewTable();
   }
 }
 
@@ -148,32 +193,74 @@ void VisitedLinkEventListener::Add(VisitedLinkMaster::Fingerprint fingerprint) {
   pending_visited_links_.push_back(fingerprint);
 
   if (!coalesce_timer_.IsRunning()) {
-    coalesce_timer_.Start(FROM_HERE,
-        TimeDelta::FromMilliseconds(kCommitIntervalMs), this,
+    coalesce_timer_.Start(FROM_HERE, commit_interval_, this,
         &VisitedLinkEventListener::CommitVisitedLinks);
   }
 }
 
+void VisitedLinkEventListener::AddBatch(
+    const VisitedLinkCommon::Fingerprints& fingerprints) {
+  pending_visited_links_.insert(pending_visited_links_.end(),
+                                fingerprints.begin(), fingerprints.end());
+
+  // A batch is already coalesced, so there is no point in waiting for more
+  // additions: broadcast it along with anything pending right away.
+  coalesce_timer_.Stop();
+  CommitVisitedLinks();
+}
+
 void VisitedLinkEventListener::Reset() {
   pending_visited_links_.clear();
   coalesce_timer_.Stop();
 
   for (Updaters::iterator i = updaters_.begin(); i != updaters_.end(); ++i) {
     i->second->AddReset();
-    i->second->Update();
+    i->second->Update(master_->shared_memory());
   }
 }
 
 void VisitedLinkEventListener::CommitVisitedLinks() {
+  bool handoff = pending_visited_links_.size() > kNewTableBacklogThreshold;
+
   // Send to all RenderProcessHosts.
   for (Updaters::iterator i = updaters_.begin(); i != updaters_.end(); ++i) {
-    i->second->AddLinks(pending_visited_links_);
-    i->second->Update();
+    if (handoff) {
+      i->second->AddNewTable();
+      i->second->AddReset();
+    } else {
+      i->second->AddLinks(pending_visited_links_);
+    }
+    i->second->Update(master_->shared_memory());
   }
 
+  AdaptCommitInterval(pending_visited_links_.size());
   pending_visited_links_.clear();
 }
 
+void VisitedLinkEventListener::AdaptCommitInterval(size_t committed) {
+  TimeDelta min = TimeDelta::FromMilliseconds(kMinCommitIntervalMs);
+  TimeDelta max = TimeDelta::FromMilliseconds(kMaxCommitIntervalMs);
+
+  bool any_visible = false;
+  for (Updaters::iterator i = updaters_.begin(); i != updaters_.end(); ++i) {
+    if (IsProcessVisible(i->first)) {
+      any_visible = true;
+      break;
+    }
+  }
+
+  if (!any_visible) {
+    // Nothing is sent to hidden renderers until they are shown, which
+    // triggers an update on its own.
+    commit_interval_ = max;
+  } else if (committed > kVisitedLinkBufferThreshold) {
+    // Renderers will get a reset anyway, so coalesce more.
+    commit_interval_ = std::min(commit_interval_ * 2, max);
+  } else {
+    commit_interval_ = std::max(commit_interval_ / 2, min);
+  }
+}
+
 void VisitedLinkEventListener::Observe(
     int type,
     const content::NotificationSource& source,
@@ -208,7 +295,7 @@ void VisitedLinkEventListener::Observe(
           content::Source<RenderWidgetHost>(source).ptr();
       int child_id = widget->GetProcess()->GetID();
       if (updaters_.count(child_id))
-        updaters_[child_id]->Update();
+        updaters_[child_id]->Update(master_->shared_memory());
       break;
     }
     default:
@@ -28,7 +28,9 @@ class VisitedLinkUpdater;
 
 // VisitedLinkEventListener broadcasts link coloring database updates to all
 // processes. It also coalesces the updates to avoid excessive broadcasting of
-// messages to the renderers.
+// messages to the renderers. The coalescing interval adapts to the rate of
+// additions and to renderer visibility, and large backlogs are handed off as
+// a new table followed by a reset rather than as individual links.
 class VisitedLinkEventListener : public VisitedLinkMaster::Listener,
                                  public content::NotificationObserver {
  public:
@@ -38,11 +40,17 @@ class VisitedLinkEventListener : public VisitedLinkMaster::Listener,
 
   virtual void NewTable(base::SharedMemory* table_memory) OVERRIDE;
   virtual void Add(VisitedLinkMaster::Fingerprint fingerprint) OVERRIDE;
+  virtual void AddBatch(
+      const VisitedLinkCommon::Fingerprints& fingerprints) OVERRIDE;
   virtual void Reset() OVERRIDE;
 
  private:
   void CommitVisitedLinks();
 
+  // Picks the delay before the next commit from the size of the last one and
+  // from whether any renderer is visible.
+  void AdaptCommitInterval(size_t committed);
+
   // content::NotificationObserver implementation.
   virtual void Observe(int type,
                        const content::NotificationSource& source,
@@ -50,6 +58,7 @@ class VisitedLinkEventListener : public VisitedLinkMaster::Listener,
 
   base::OneShotTimer<VisitedLinkEventListener> coalesce_timer_;
   VisitedLinkCommon::Fingerprints pending_visited_links_;
+  base::TimeDelta commit_interval_;
 
   content::NotificationRegistrar registrar_;
 
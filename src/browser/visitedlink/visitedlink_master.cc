@@ -314,6 +314,78 @@ void VisitedLinkMaster::AddURLs(const std::vector<GURL>& url) {
     WriteFullTable();
 }
 
+void VisitedLinkMaster::AddFingerprints(const Fingerprints& fingerprints) {
+  // Extra check that we are not incognito. This should not happen.
+  if (browser_context_ && browser_context_->IsOffTheRecord()) {
+    NOTREACHED();
+    return;
+  }
+
+  // Grow the table once for the whole batch rather than once per insertion.
+  // Fingerprints that are already present don't count towards the new size.
+  if (!table_builder_.get()) {
+    int32 new_items = 0;
+    for (Fingerprints::const_iterator i = fingerprints.begin();
+         i != fingerprints.end(); ++i) {
+      if (*i != null_fingerprint_ && !IsVisited(*i))
+        new_items++;
+    }
+    if ((used_items_ + new_items) * 2 > table_length_)
+      ResizeTable(NewTableSizeForCount(used_items_ + new_items));
+  }
+
+  Fingerprints added;
+  for (Fingerprints::const_iterator i = fingerprints.begin();
+       i != fingerprints.end(); ++i) {
+    if (*i == null_fingerprint_)
+      continue;
+
+    if (table_builder_.get()) {
+      // See TryToAddURL.
+      deleted_since_rebuild_.erase(*i);
+      added_since_rebuild_.insert(*i);
+    }
+
+    // See TryToAddURL for why we stop at 80%.
+    if (used_items_ / 8 > table_length_ / 10)
+      break;
+
+    if (AddFingerprint(*i, false) != null_hash_)
+      added.push_back(*i);
+  }
+
+  if (added.empty())
+    return;
+
+  // Keeps the file on disk up-to-date. A resize writes the table for us.
+  if (!table_builder_.get() && !ResizeTableIfNecessary() && persist_to_disk_)
+    WriteFullTable();
+
+  listener_->AddBatch(added);
+}
+
+void VisitedLinkMaster::GetSalt(uint8 salt[LINK_SALT_LENGTH]) const {
+  memcpy(salt, salt_, LINK_SALT_LENGTH * sizeof(uint8));
+}
+
+// static
+void VisitedLinkMaster::ComputeURLFingerprints(
+    const std::string* urls,
+    size_t count,
+    const uint8 salt[LINK_SALT_LENGTH],
+    Fingerprint* fingerprints) {
+  for (size_t i = 0; i < count; ++i) {
+    GURL url(urls[i]);
+    if (!url.is_valid()) {
+      fingerprints[i] = null_fingerprint_;
+      continue;
+    }
+    fingerprints[i] = ComputeURLFingerprint(url.spec().data(),
+                                            url.spec().size(),
+                                            salt);
+  }
+}
+
 void VisitedLinkMaster::DeleteAllURLs() {
   // Any pending modifications are invalid.
   added_since_rebuild_.clear();
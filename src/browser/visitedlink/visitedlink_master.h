@@ -9,6 +9,7 @@
 #include <windows.h>
 #endif
 #include <set>
+#include <string>
 #include <vector>
 
 #include "base/callback.h"
@@ -56,6 +57,11 @@ class VisitedLinkMaster : public VisitedLinkCommon {
     // (hash) of the link.
     virtual void Add(Fingerprint fingerprint) = 0;
 
+    // Called once when a set of links has been added in bulk (see
+    // AddFingerprints). The argument holds the fingerprints of the links that
+    // were actually inserted.
+    virtual void AddBatch(const Fingerprints& fingerprints) = 0;
+
     // Called when link coloring state has been reset. This may occur when
     // entire or parts of history were deleted.
     virtual void Reset() = 0;
@@ -101,6 +107,25 @@ class VisitedLinkMaster : public VisitedLinkCommon {
   // Adds a set of URLs to the table.
   void AddURLs(const std::vector<GURL>& url);
 
+  // Adds a set of precomputed fingerprints to the table. The table is grown at
+  // most once up front, written to disk once and the listener receives a
+  // single AddBatch notification. Null fingerprints are skipped. The
+  // fingerprints must have been computed with the salt returned by GetSalt.
+  void AddFingerprints(const Fingerprints& fingerprints);
+
+  // Copies the salt used to compute fingerprints for this table into |salt|.
+  // The salt does not change after Init so it can be handed to other threads
+  // together with ComputeURLFingerprints.
+  void GetSalt(uint8 salt[LINK_SALT_LENGTH]) const;
+
+  // Canonicalizes the |count| URLs starting at |urls| and stores their
+  // fingerprints computed with |salt| into |fingerprints|. Invalid URLs get
+  // null_fingerprint_. This does not touch the table and can run on any thread.
+  static void ComputeURLFingerprints(const std::string* urls,
+                                     size_t count,
+                                     const uint8 salt[LINK_SALT_LENGTH],
+                                     Fingerprint* fingerprints);
+
   // See DeleteURLs.
   class URLIterator {
    public:
@@ -160,6 +185,7 @@ class VisitedLinkMaster : public VisitedLinkCommon {
   FRIEND_TEST_ALL_PREFIXES(VisitedLinkTest, Delete);
   FRIEND_TEST_ALL_PREFIXES(VisitedLinkTest, BigDelete);
   FRIEND_TEST_ALL_PREFIXES(VisitedLinkTest, BigImport);
+  friend class VisitedLinkMasterBenchmark;
 
   // Object to rebuild the table on the history thread (see the .cc file).
   class TableBuilder;
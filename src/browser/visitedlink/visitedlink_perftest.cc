@@ -0,0 +1,323 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+// Microbenchmarks for the visited link database. The master is created with
+// its unit test constructor (explicit database file and table size) so no
+// browser is needed. Run with:
+//
+//   thrust_shell_visitedlink_perftest [--max-table-size=N] [--ops=N]
+//
+// For each table size from kDefaultTableSize up to --max-table-size (32M by
+// default) the table is filled to ~30% load with a synthetic URL corpus, then
+// each operation is timed and reported as ns/op along with the table memory.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/file_util.h"
+#include "base/files/file_path.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "base/process/process_handle.h"
+#include "base/process/process_metrics.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/time.h"
+#include "content/public/browser/browser_thread.h"
+#include "url/gurl.h"
+
+#include "src/browser/visitedlink/visitedlink_master.h"
+#include "src/renderer/visitedlink/visitedlink_slave.h"
+
+using base::TimeDelta;
+using base::TimeTicks;
+using content::BrowserThread;
+
+namespace visitedlink {
+
+namespace {
+
+const char kMaxTableSize[] = "max-table-size";
+const char kOps[] = "ops";
+
+// Fill the tables to this fraction before measuring (resizes happen at 50%).
+const double kFillLoad = 0.3;
+// Number of URLs handed to AddURLs at once while filling.
+const size_t kAddURLsBatchSize = 10000;
+// Number of table handoffs measured for VisitedLinkSlave.
+const int kSlaveUpdates = 20;
+
+// Table sizes used by VisitedLinkMaster::NewTableSizeForCount.
+const int32 kTableSizes[] = {
+  16381, 65521, 262127, 1048549, 4194301, 16777199, 33554347
+};
+
+// Listener that drops all events on the floor but counts them.
+class CountingListener : public VisitedLinkMaster::Listener {
+ public:
+  CountingListener() : new_table_(0), add_(0), reset_(0) {}
+
+  virtual void NewTable(base::SharedMemory*) OVERRIDE { new_table_++; }
+  virtual void Add(VisitedLinkCommon::Fingerprint) OVERRIDE { add_++; }
+  virtual void AddBatch(
+      const VisitedLinkCommon::Fingerprints& fingerprints) OVERRIDE {
+    add_ += fingerprints.size();
+  }
+  virtual void Reset() OVERRIDE { reset_++; }
+
+ private:
+  int    new_table_;
+  size_t add_;
+  int    reset_;
+};
+
+// Generates a deterministic, browsing-history-like URL corpus: a few thousand
+// hosts with a skewed popularity, nested paths and occasional query strings.
+// URL |i| is always the same string so that hits can be regenerated instead
+// of being kept in memory.
+std::string CorpusURL(uint64 i) {
+  uint64 x = i * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E5ULL;
+  x ^= x >> 31;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+
+  // Squaring skews the host distribution towards low ids (popular sites).
+  uint64 h = x % 4096;
+  uint64 host = (h * h) / 4096;
+  static const char* kTlds[] = { "com", "org", "net", "io", "co.uk", "de" };
+  static const char* kDirs[] = {
+    "news", "article", "watch", "user", "search", "wiki", "blog", "static",
+    "images", "products", "questions", "2014"
+  };
+
+  std::string url = base::StringPrintf(
+      "%s://%s%llu.example.%s/%s/",
+      (x & 0x10) ? "https" : "http",
+      (x & 0x20) ? "www.site" : "site",
+      static_cast<unsigned long long>(host),
+      kTlds[(x >> 8) % arraysize(kTlds)],
+      kDirs[(x >> 12) % arraysize(kDirs)]);
+  int depth = (x >> 16) % 4;
+  for (int d = 0; d < depth; ++d)
+    url += std::string(kDirs[(x >> (20 + 4 * d)) % arraysize(kDirs)]) + "/";
+  url += base::StringPrintf("%llu", static_cast<unsigned long long>(i));
+  if ((x >> 40) % 3 == 0)
+    url += base::StringPrintf("?id=%llu&ref=%llu",
+                              static_cast<unsigned long long>(x >> 44),
+                              static_cast<unsigned long long>(host));
+  return url;
+}
+
+void PrintResult(const std::string& measurement,
+                 int32 table_size,
+                 double value,
+                 const std::string& units) {
+  printf("RESULT %s: table_%d= %.2f %s\n",
+         measurement.c_str(), table_size, value, units.c_str());
+  fflush(stdout);
+}
+
+double NsPerOp(TimeDelta elapsed, size_t ops) {
+  if (ops == 0)
+    return 0;
+  return elapsed.InMicrosecondsF() * 1000.0 / ops;
+}
+
+void PrintMemory(int32 table_size, VisitedLinkMaster* master) {
+  PrintResult("table_memory", table_size,
+              master->shared_memory()->requested_size() / 1024.0, "KB");
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+  PrintResult("working_set", table_size,
+              metrics->GetWorkingSetSize() / 1024.0, "KB");
+}
+
+}  // namespace
+
+// Friend of VisitedLinkMaster so that ResizeTable and InitFromFile can be
+// measured directly.
+class VisitedLinkMasterBenchmark {
+ public:
+  VisitedLinkMasterBenchmark(const base::FilePath& dir, size_t ops)
+      : dir_(dir),
+        ops_(ops) {}
+
+  void Run(int32 table_size) {
+    size_t fill = static_cast<size_t>(table_size * kFillLoad);
+
+    scoped_ptr<VisitedLinkMaster> master(new VisitedLinkMaster(
+        new CountingListener, NULL, false, true, base::FilePath(),
+        table_size));
+    CHECK(master->Init());
+
+    // AddURLs: fill the table in batches.
+    TimeDelta elapsed;
+    for (size_t begin = 0; begin < fill; begin += kAddURLsBatchSize) {
+      size_t end = std::min(begin + kAddURLsBatchSize, fill);
+      std::vector<GURL> urls;
+      urls.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i)
+        urls.push_back(GURL(CorpusURL(i)));
+      TimeTicks start = TimeTicks::HighResNow();
+      master->AddURLs(urls);
+      elapsed += TimeTicks::HighResNow() - start;
+    }
+    PrintResult("add_urls", table_size, NsPerOp(elapsed, fill), "ns/op");
+    PrintMemory(table_size, master.get());
+
+    // IsVisited with 100%, 50% and 0% hits. Miss URLs come from the part of
+    // the corpus that was never added.
+    size_t ops = std::min(ops_, fill);
+    const int kHitPercents[] = { 100, 50, 0 };
+    for (size_t m = 0; m < arraysize(kHitPercents); ++m) {
+      std::vector<GURL> probes;
+      probes.reserve(ops);
+      for (size_t i = 0; i < ops; ++i) {
+        bool hit = static_cast<int>(i % 100) < kHitPercents[m];
+        uint64 id = hit ? (i * 7919) % fill : fill + ops + i;
+        probes.push_back(GURL(CorpusURL(id)));
+      }
+      size_t found = 0;
+      TimeTicks start = TimeTicks::HighResNow();
+      for (size_t i = 0; i < probes.size(); ++i) {
+        if (master->IsVisited(probes[i]))
+          found++;
+      }
+      TimeDelta t = TimeTicks::HighResNow() - start;
+      PrintResult(base::StringPrintf("is_visited_hit%d", kHitPercents[m]),
+                  table_size, NsPerOp(t, ops), "ns/op");
+      CHECK_GE(found, ops * kHitPercents[m] / 100);
+    }
+
+    // AddURL: individual additions of new URLs, staying below the resize
+    // threshold so that no resize is included in the measurement.
+    size_t adds = std::min(ops, static_cast<size_t>(table_size * 0.45) - fill);
+    {
+      std::vector<GURL> urls;
+      urls.reserve(adds);
+      for (size_t i = 0; i < adds; ++i)
+        urls.push_back(GURL(CorpusURL(2 * (fill + ops) + i)));
+      TimeTicks start = TimeTicks::HighResNow();
+      for (size_t i = 0; i < urls.size(); ++i)
+        master->AddURL(urls[i]);
+      PrintResult("add_url", table_size,
+                  NsPerOp(TimeTicks::HighResNow() - start, adds), "ns/op");
+    }
+
+    // VisitedLinkSlave::OnUpdateVisitedLinks: handoff of the current table
+    // to a reader, as done for each renderer on NewTable.
+    {
+      VisitedLinkSlave slave;
+      TimeDelta t;
+      for (int i = 0; i < kSlaveUpdates; ++i) {
+        base::SharedMemoryHandle handle;
+        CHECK(master->shared_memory()->ShareToProcess(
+            base::GetCurrentProcessHandle(), &handle));
+        TimeTicks start = TimeTicks::HighResNow();
+        slave.OnUpdateVisitedLinks(handle);
+        t += TimeTicks::HighResNow() - start;
+      }
+      PrintResult("slave_update_visited_links", table_size,
+                  NsPerOp(t, kSlaveUpdates), "ns/op");
+      CHECK(slave.IsVisited(GURL(CorpusURL(0))));
+    }
+
+    // ResizeTable: grow to the next size, as triggered by AddURL at 50% load.
+    // Reported per table and per entry rehashed.
+    {
+      int32 used = master->GetUsedCount();
+      int32 new_size = master->NewTableSizeForCount(table_size);
+      TimeTicks start = TimeTicks::HighResNow();
+      master->ResizeTable(new_size);
+      TimeDelta t = TimeTicks::HighResNow() - start;
+      PrintResult("resize_table", table_size, NsPerOp(t, 1), "ns/op");
+      PrintResult("resize_table_per_entry", table_size, NsPerOp(t, used),
+                  "ns/op");
+    }
+    master.reset();
+
+    // InitFromFile: write a table of the same size and load it back.
+    base::FilePath file = dir_.Append(
+        base::StringPrintf("Visited Links %d", table_size));
+    {
+      scoped_ptr<VisitedLinkMaster> writer(new VisitedLinkMaster(
+          new CountingListener, NULL, true, true, file, table_size));
+      CHECK(writer->Init());
+      VisitedLinkCommon::Fingerprints fingerprints(fill);
+      uint8 salt[LINK_SALT_LENGTH];
+      writer->GetSalt(salt);
+      for (size_t i = 0; i < fill; ++i) {
+        std::string url = CorpusURL(i);
+        VisitedLinkMaster::ComputeURLFingerprints(&url, 1, salt,
+                                                  &fingerprints[i]);
+      }
+      writer->AddFingerprints(fingerprints);
+    }
+    // The writes are asynchronous on the blocking pool.
+    BrowserThread::GetBlockingPool()->FlushForTesting();
+    {
+      scoped_ptr<VisitedLinkMaster> reader(new VisitedLinkMaster(
+          new CountingListener, NULL, true, true, file, table_size));
+      TimeTicks start = TimeTicks::HighResNow();
+      CHECK(reader->InitFromFile());
+      TimeDelta t = TimeTicks::HighResNow() - start;
+      PrintResult("init_from_file", table_size, NsPerOp(t, 1), "ns/op");
+      CHECK(reader->IsVisited(GURL(CorpusURL(0))));
+    }
+    BrowserThread::GetBlockingPool()->FlushForTesting();
+    base::DeleteFile(file, false);
+  }
+
+  static int32 DefaultTableSize() {
+    return static_cast<int32>(VisitedLinkMaster::kDefaultTableSize);
+  }
+
+ private:
+  base::FilePath dir_;
+  size_t         ops_;
+
+  DISALLOW_COPY_AND_ASSIGN(VisitedLinkMasterBenchmark);
+};
+
+}  // namespace visitedlink
+
+int main(int argc, char** argv) {
+  base::AtExitManager at_exit;
+  CommandLine::Init(argc, argv);
+  const CommandLine* command_line = CommandLine::ForCurrentProcess();
+
+  int max_table_size = 33554347;
+  if (command_line->HasSwitch(visitedlink::kMaxTableSize)) {
+    base::StringToInt(
+        command_line->GetSwitchValueASCII(visitedlink::kMaxTableSize),
+        &max_table_size);
+  }
+  int ops = 200000;
+  if (command_line->HasSwitch(visitedlink::kOps)) {
+    base::StringToInt(command_line->GetSwitchValueASCII(visitedlink::kOps),
+                      &ops);
+  }
+
+  base::ScopedTempDir temp_dir;
+  CHECK(temp_dir.CreateUniqueTempDir());
+
+  visitedlink::VisitedLinkMasterBenchmark benchmark(temp_dir.path(), ops);
+  DCHECK_EQ(visitedlink::kTableSizes[0],
+            visitedlink::VisitedLinkMasterBenchmark::DefaultTableSize());
+  for (size_t i = 0; i < arraysize(visitedlink::kTableSizes); ++i) {
+    if (visitedlink::kTableSizes[i] > max_table_size)
+      break;
+    benchmark.Run(visitedlink::kTableSizes[i]);
+  }
+
+  BrowserThread::GetBlockingPool()->Shutdown();
+  return 0;
+}
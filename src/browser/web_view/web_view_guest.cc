@@ -4,7 +4,6 @@
 
 #include "src/browser/web_view/web_view_guest.h"
 
-#include "base/lazy_instance.h"
 #include "base/process/kill.h"
 #include "base/process/process_handle.h" 
 #include "base/strings/utf_string_conversions.h"
@@ -29,21 +28,25 @@
 #include "third_party/WebKit/public/web/WebView.h"
 #include "third_party/WebKit/public/web/WebFindOptions.h"
 
+#include "src/common/web_view_event.h"
 #include "src/browser/web_view/web_view_constants.h"
 #include "src/browser/web_view/web_view_javascript_dialog_manager.h"
 #include "src/browser/browser_client.h"
 #include "src/browser/session/thrust_session.h"
+#include "src/browser/thrust_registry.h"
 #include "src/browser/thrust_window.h"
+#include "src/browser/util/frame_capture.h"
 
 using content::WebContents;
 
 namespace {
 
-// WebContents* => WebViewGuest*
-typedef std::map<WebContents*, thrust_shell::WebViewGuest*> 
-  WebContentsWebViewGuestMap;
-static base::LazyInstance<WebContentsWebViewGuestMap> webcontents_webview_map =
-    LAZY_INSTANCE_INITIALIZER;
+/* Files reused in turn by the captures of a guest. */
+const size_t kCaptureSlots = 4;
+
+}
+
+namespace {
 
 std::string WindowOpenDispositionToString(
   WindowOpenDisposition window_open_disposition) {
@@ -118,6 +121,7 @@ class WebViewGuest::EmbedderWebContentsObserver : public WebContentsObserver {
     }
     destroyed_ = true;
     guest_->embedder_web_contents_ = NULL;
+    ThrustRegistry::GetInstance()->SetGuestEmbedder(guest_, NULL);
     //guest_->EmbedderDestroyed();
     guest_->Destroy();
   }
@@ -137,6 +141,11 @@ WebViewGuest::WebViewGuest(
   guest_instance_id_(guest_instance_id),
   view_instance_id_(webview::kInstanceIDNone),
   auto_size_enabled_(false),
+  priority_class_("auto"),
+  visible_(true),
+  scheduled_process_id_(0),
+  scheduled_view_id_(0),
+  prewarmed_(false),
   weak_ptr_factory_(this) 
 {
   LOG(INFO) << "WebViewGuest Constructor: " << this;
@@ -152,8 +161,7 @@ WebViewGuest::Init(
   guest_web_contents->SetDelegate(this);
   browser_context_ = guest_web_contents->GetBrowserContext();
 
-  webcontents_webview_map.Get().insert(
-      std::make_pair(guest_web_contents, this));
+  ThrustRegistry::GetInstance()->AddGuest(this, guest_web_contents);
 
   notification_registrar_.Add(
       this, content::NOTIFICATION_LOAD_COMPLETED_MAIN_FRAME,
@@ -167,6 +175,7 @@ WebViewGuest::Init(
     AddGuest(guest_instance_id_, guest_web_contents);
 
   LOG(INFO) << "WebViewGuest Init: " << this;
+  timeline_.Mark(ThrustCreateTimeline::PHASE_CONSTRUCTED);
 }
 
 
@@ -183,9 +192,7 @@ WebViewGuest*
 WebViewGuest::FromWebContents(
     WebContents* web_contents) 
 {
-  WebContentsWebViewGuestMap* webview_map = webcontents_webview_map.Pointer();
-  WebContentsWebViewGuestMap::iterator it = webview_map->find(web_contents);
-  return it == webview_map->end() ? NULL : it->second;
+  return ThrustRegistry::GetInstance()->GuestForWebContents(web_contents);
 }
 
 // static.
@@ -244,10 +251,16 @@ WebViewGuest::Destroy()
   if(!destruction_callback_.is_null())
     destruction_callback_.Run();
 
-  webcontents_webview_map.Get().erase(guest_web_contents());
+  ThrustRegistry::GetInstance()->RemoveGuest(this);
 
-  ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(browser_context_)->
-    RemoveGuest(guest_instance_id_);
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        browser_context_);
+  if(scheduled_view_id_) {
+    session->RemoveRequestPriorityClass(scheduled_process_id_,
+                                        scheduled_view_id_);
+  }
+  session->RemoveGuest(guest_instance_id_);
 
   guest_web_contents_.reset();
 }
@@ -255,6 +268,7 @@ WebViewGuest::Destroy()
 void 
 WebViewGuest::DidAttach() 
 {
+  timeline_.Mark(ThrustCreateTimeline::PHASE_SHOWN);
   GetThrustWindow()->WebViewEmit(
       guest_instance_id_,
       "did-attach",
@@ -285,6 +299,16 @@ WebViewGuest::GuestSizeChanged(
   }
   guest_size_ = new_size;
   //GuestSizeChangedDueToAutoSize(old_size, new_size);
+
+  ThrustWindow* window = GetThrustWindow();
+  if(!window) {
+    return;
+  }
+  WebViewEvent event(guest_instance_id_, "size-changed",
+                     WebViewEvent::KIND_SIZE_CHANGED);
+  event.old_size = old_size;
+  event.new_size = new_size;
+  window->WebViewEmit(event);
 }
 
 
@@ -301,6 +325,7 @@ WebViewGuest::WillAttach(
     const base::DictionaryValue& extra_params) 
 {
   embedder_web_contents_ = embedder_web_contents;
+  ThrustRegistry::GetInstance()->SetGuestEmbedder(this, embedder_web_contents);
   embedder_web_contents_observer_.reset(
       new EmbedderWebContentsObserver(this));
   embedder_render_process_id_ =
@@ -322,6 +347,7 @@ WebViewGuest::CreateNewGuestWindow(
 WebViewGuest::~WebViewGuest() 
 {
   LOG(INFO) << "WebViewGuest Destructor: " << this;
+  ThrustRegistry::GetInstance()->RemoveGuest(this);
 }
 
 void 
@@ -488,6 +514,75 @@ WebViewGuest::JavaScriptDialogClosed(
   dialog_manager_.get()->JavaScriptDialogClosed(success, response);
 }
 
+void
+WebViewGuest::AddNetworkUsage(
+    const ThrustShellNetworkUsage& usage)
+{
+  network_usage_.Add(usage);
+
+  ThrustWindow* window = GetThrustWindow();
+  if(!window) {
+    return;
+  }
+  window->AddNetworkUsage(usage);
+
+  scoped_ptr<base::DictionaryValue> event(network_usage_.ToValue());
+  window->WebViewEmit(
+      guest_instance_id_,
+      "network-usage",
+      *event.get());
+}
+
+void
+WebViewGuest::SetPriorityClass(
+    const std::string& priority_class)
+{
+  if(priority_class != "auto" && priority_class != "foreground" &&
+     priority_class != "normal" && priority_class != "background") {
+    LOG(ERROR) << "Invalid priority class: " << priority_class;
+    return;
+  }
+  priority_class_ = priority_class;
+  UpdateRequestPriorityClass();
+}
+
+void
+WebViewGuest::Capture(
+    int request_id,
+    const base::DictionaryValue& options)
+{
+  /* The embedder page does not choose where frames are written: they go */
+  /* to the guest slots, which bounds the memory used by its frames.     */
+  scoped_ptr<base::DictionaryValue> args(options.DeepCopy());
+  args->Remove("path", NULL);
+
+  ThrustFrameCapture::Options capture_options;
+  std::string error;
+  if(!ThrustFrameCapture::ParseOptions(*args, &capture_options, &error)) {
+    OnCaptured(request_id, error, scoped_ptr<base::DictionaryValue>());
+    return;
+  }
+  if(!capture_slots_) {
+    capture_slots_.reset(new ThrustFrameSlots(kCaptureSlots));
+  }
+  capture_options.path = capture_slots_->Next();
+  ThrustFrameCapture::Capture(
+      guest_web_contents(),
+      capture_options,
+      capture_slots_->task_runner(),
+      base::Bind(&WebViewGuest::OnCaptured,
+                 weak_ptr_factory_.GetWeakPtr(), request_id));
+}
+
+void
+WebViewGuest::ReleaseCapture(
+    const std::string& path)
+{
+  if(!capture_slots_ || !capture_slots_->Release(path)) {
+    LOG(ERROR) << "Invalid capture path: " << path;
+  }
+}
+
 /******************************************************************************/
 /* PUBLIC API */
 /******************************************************************************/
@@ -528,13 +623,65 @@ WebViewGuest::SetAutoSize(
 ThrustWindow*
 WebViewGuest::GetThrustWindow()
 {
-  std::vector<ThrustWindow*> instances = ThrustWindow::instances();
-  for(size_t i = 0; i < instances.size(); ++i) {
-    if(instances[i]->GetWebContents() == embedder_web_contents_) {
-      return instances[i];
-    }
+  return ThrustRegistry::GetInstance()->WindowForWebContents(
+      embedder_web_contents_);
+}
+
+void
+WebViewGuest::OnCaptured(
+    int request_id,
+    const std::string& error,
+    scoped_ptr<base::DictionaryValue> frame)
+{
+  ThrustWindow* window = GetThrustWindow();
+  if(!window) {
+    return;
   }
-  return NULL;
+  if(!frame) {
+    frame.reset(new base::DictionaryValue);
+  }
+  frame->SetInteger("request_id", request_id);
+  if(!error.empty()) {
+    frame->SetString("error", error);
+  }
+  window->WebViewEmit(
+      guest_instance_id_,
+      "capture",
+      *frame.get());
+}
+
+void
+WebViewGuest::UpdateRequestPriorityClass()
+{
+  content::RenderViewHost* rvh = guest_web_contents()->GetRenderViewHost();
+  if(!rvh) {
+    return;
+  }
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        browser_context_);
+
+  int process_id = rvh->GetProcess()->GetID();
+  int view_id = rvh->GetRoutingID();
+  if(scheduled_view_id_ && 
+     (process_id != scheduled_process_id_ || view_id != scheduled_view_id_)) {
+    session->RemoveRequestPriorityClass(scheduled_process_id_,
+                                        scheduled_view_id_);
+  }
+  scheduled_process_id_ = process_id;
+  scheduled_view_id_ = view_id;
+
+  ThrustShellRequestScheduler::PriorityClass priority_class =
+    ThrustShellRequestScheduler::PRIORITY_CLASS_NORMAL;
+  if(priority_class_ == "foreground" || 
+     (priority_class_ == "auto" && visible_)) {
+    priority_class = ThrustShellRequestScheduler::PRIORITY_CLASS_FOREGROUND;
+  }
+  else if(priority_class_ == "background" || 
+          (priority_class_ == "auto" && !visible_)) {
+    priority_class = ThrustShellRequestScheduler::PRIORITY_CLASS_BACKGROUND;
+  }
+  session->SetRequestPriorityClass(process_id, view_id, priority_class);
 }
 
 /******************************************************************************/
@@ -550,6 +697,21 @@ WebViewGuest::RenderViewReady()
   else {
     rvh->DisableAutoResize(element_size_);
   }
+  UpdateRequestPriorityClass();
+}
+
+void
+WebViewGuest::WasShown()
+{
+  visible_ = true;
+  UpdateRequestPriorityClass();
+}
+
+void
+WebViewGuest::WasHidden()
+{
+  visible_ = false;
+  UpdateRequestPriorityClass();
 }
 
 void 
@@ -628,16 +790,14 @@ WebViewGuest::DidGetRedirectForResourceRequest(
     content::RenderViewHost* render_view_host,
     const content::ResourceRedirectDetails& details) 
 {
-  base::DictionaryValue event;
-  event.SetString("current_url", details.url.spec());
-  event.SetString("new_url", details.new_url.spec());
-  event.SetBoolean("is_top_level", 
-                   details.resource_type == content::RESOURCE_TYPE_MAIN_FRAME);
-
-  GetThrustWindow()->WebViewEmit(
-      guest_instance_id_,
-      "did-get-redirect-request",
-      event);
+  WebViewEvent event(guest_instance_id_, "did-get-redirect-request",
+                     WebViewEvent::KIND_REDIRECT);
+  event.current_url = details.url;
+  event.new_url = details.new_url;
+  event.is_top_level = 
+    details.resource_type == content::RESOURCE_TYPE_MAIN_FRAME;
+
+  GetThrustWindow()->WebViewEmit(event);
 }
 
 
@@ -652,6 +812,9 @@ WebViewGuest::DidCommitProvisionalLoadForFrame(
 {
   //find_helper_.CancelAllFindSessions();
 
+  if(!render_frame_host->GetParent())
+    timeline_.Mark(ThrustCreateTimeline::PHASE_COMMITTED);
+
   base::DictionaryValue event;
   event.SetString("url", url.spec());
   event.SetBoolean("is_top_level", !render_frame_host->GetParent());
@@ -735,6 +898,35 @@ WebViewGuest::RenderProcessGone(
       event);
 }
 
+void
+WebViewGuest::DidFirstVisuallyNonEmptyPaint()
+{
+  if(timeline_.HasMark(ThrustCreateTimeline::PHASE_FIRST_PAINT))
+    return;
+  timeline_.Mark(ThrustCreateTimeline::PHASE_FIRST_PAINT);
+
+  ThrustSession* session = 
+    ThrustShellBrowserClient::Get()->ThrustSessionForBrowserContext(
+        browser_context_);
+  if(session) {
+    session->GetWebContentsPool()->RecordFirstPaint(
+        ThrustSessionWebContentsPool::KIND_GUEST, prewarmed_,
+        timeline_.Elapsed(ThrustCreateTimeline::PHASE_FIRST_PAINT));
+    session->RecordCreateTimeline(true, timeline_);
+  }
+
+  ThrustWindow* window = GetThrustWindow();
+  if(!window) {
+    return;
+  }
+  scoped_ptr<base::DictionaryValue> timing = timeline_.ToValue();
+  timing->SetBoolean("prewarmed", prewarmed_);
+  window->WebViewEmit(
+      guest_instance_id_,
+      "timing",
+      *timing.get());
+}
+
 void 
 WebViewGuest::UserAgentOverrideSet(
     const std::string& user_agent) 
@@ -778,16 +970,14 @@ WebViewGuest::AddMessageToConsole(
     int32 line_no,
     const base::string16& source_id) 
 {
-  base::DictionaryValue event;
-  event.SetInteger("level", level);
-  event.SetString("message", message);
-  event.SetInteger("line", line_no);
-  event.SetString("source_id", source_id);
-
-  GetThrustWindow()->WebViewEmit(
-      guest_instance_id_,
-      "console",
-      event);
+  WebViewEvent event(guest_instance_id_, "console",
+                     WebViewEvent::KIND_CONSOLE);
+  event.level = level;
+  event.message = message;
+  event.line = line_no;
+  event.source_id = source_id;
+
+  GetThrustWindow()->WebViewEmit(event);
   return true;
 }
 
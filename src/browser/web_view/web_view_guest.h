@@ -18,8 +18,12 @@
 
 #include "vendor/brightray/browser/inspectable_web_contents.h"
 
+#include "src/browser/util/create_timeline.h"
+#include "src/net/network_usage.h"
+
 namespace thrust_shell {
 
+class ThrustFrameSlots;
 class ThrustWindow;
 class WebViewGuestJavaScriptDialogManager;
 
@@ -197,11 +201,54 @@ public:
   void JavaScriptDialogClosed(bool success, 
                               const std::string& response);
 
+  // ### AddNetworkUsage
+  //
+  // Accounts network usage to this guest and its embedding window, and emits
+  // a `network-usage` event with the updated counters
+  // ```
+  // @usage {ThrustShellNetworkUsage} the usage to add
+  // ```
+  void AddNetworkUsage(const ThrustShellNetworkUsage& usage);
+
+  // ### SetPriorityClass
+  //
+  // Sets the scheduling class of the network requests of this guest. In
+  // `auto` mode (the default) the guest is in `foreground` while visible and
+  // in `background` while hidden.
+  // ```
+  // @priority_class {string} auto, foreground, normal or background
+  // ```
+  void SetPriorityClass(const std::string& priority_class);
+
+  // ### Capture
+  //
+  // Captures the guest content to a file and emits a `capture` event with the
+  // frame description (see ThrustFrameCapture). Frames are written to a small
+  // ring of files reused in turn and deleted with the guest.
+  // ```
+  // @request_id {int} the request_id for this capture
+  // @options    {DictionaryValue} the capture options
+  // ```
+  void Capture(int request_id,
+               const base::DictionaryValue& options);
+
+  // ### ReleaseCapture
+  //
+  // Deletes the file of a frame captured with `Capture` once consumed
+  // ```
+  // @path {string} the path of the frame
+  // ```
+  void ReleaseCapture(const std::string& path);
+
   /****************************************************************************/
   /* PUBLIC API */
   /****************************************************************************/
   void Init(content::WebContents* guest_web_contents);
 
+  // Records whether the guest renderer process came from the session pool
+  // (see ThrustSessionWebContentsPool).
+  void SetPrewarmed(bool prewarmed) { prewarmed_ = prewarmed; }
+
   // Toggles autosize mode for this GuestView.
   void SetAutoSize(bool enabled,
                    const gfx::Size& min_size,
@@ -243,11 +290,22 @@ public:
 
   ThrustWindow* GetThrustWindow();
 
+  // Propagates the effective priority class of this guest to the request
+  // scheduler of its session.
+  void UpdateRequestPriorityClass();
+
+  // Emits the result of a capture request.
+  void OnCaptured(int request_id,
+                  const std::string& error,
+                  scoped_ptr<base::DictionaryValue> frame);
+
   /****************************************************************************/
   /* WEBCONTENTSOBSERVER IMPLEMENTATION */
   /****************************************************************************/
   virtual void RenderViewReady() OVERRIDE FINAL;
   virtual void WebContentsDestroyed() OVERRIDE FINAL;
+  virtual void WasShown() OVERRIDE;
+  virtual void WasHidden() OVERRIDE;
 
   virtual void DidFinishLoad(content::RenderFrameHost* render_frame_host,
                              const GURL& validated_url) override;
@@ -278,6 +336,7 @@ public:
       bool is_error_page,
       bool is_iframe_srcdoc) OVERRIDE;
   virtual void RenderProcessGone(base::TerminationStatus status) OVERRIDE;
+  virtual void DidFirstVisuallyNonEmptyPaint() OVERRIDE;
   virtual void UserAgentOverrideSet(const std::string& user_agent) OVERRIDE;
   virtual void TitleWasSet(content::NavigationEntry* entry, 
                            bool explicit_set) OVERRIDE;
@@ -353,6 +412,20 @@ public:
   gfx::Size                                       max_auto_size_;
   // The minimum size constraints of the container element in autosize mode.
   gfx::Size                                       min_auto_size_;
+  // The network usage of this guest since its creation.
+  ThrustShellNetworkUsage                         network_usage_;
+  // The priority class set through the API and the visibility of the guest,
+  // along with the render view registered with the request scheduler.
+  std::string                                     priority_class_;
+  bool                                            visible_;
+  int                                             scheduled_process_id_;
+  int                                             scheduled_view_id_;
+  // The creation timeline of the guest, emitted on first paint, and whether
+  // its process was prewarmed.
+  ThrustCreateTimeline                            timeline_;
+  bool                                            prewarmed_;
+  // The files captured frames are written to, created on first capture.
+  scoped_ptr<ThrustFrameSlots>                    capture_slots_;
   // This is used to ensure pending tasks will not fire after this object is
   // destroyed.
   base::WeakPtrFactory<WebViewGuest>              weak_ptr_factory_;
@@ -10,4 +10,8 @@ DraggableRegion::DraggableRegion()
     : draggable(false) {
 }
 
+bool DraggableRegion::operator==(const DraggableRegion& other) const {
+  return draggable == other.draggable && bounds == other.bounds;
+}
+
 }  // namespace atom
@@ -14,6 +14,11 @@ struct DraggableRegion {
   gfx::Rect bounds;
 
   DraggableRegion();
+
+  bool operator==(const DraggableRegion& other) const;
+  bool operator!=(const DraggableRegion& other) const {
+    return !(*this == other);
+  }
 };
 
 }  // namespace thrust_shell
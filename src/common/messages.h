@@ -13,6 +13,7 @@
 #include "ui/gfx/ipc/gfx_param_traits.h"
 
 #include "src/common/draggable_region.h"
+#include "src/common/web_view_event.h"
 
 /* The message starter should be declared in ipc/ipc_message_start.h. Since */
 /* we don't want to patch Chromium, we just pretend to be Content Shell.    */
@@ -24,15 +25,44 @@ IPC_STRUCT_TRAITS_BEGIN(thrust_shell::DraggableRegion)
   IPC_STRUCT_TRAITS_MEMBER(bounds)
 IPC_STRUCT_TRAITS_END()
 
+IPC_ENUM_TRAITS_MAX_VALUE(thrust_shell::WebViewEvent::Kind,
+                          thrust_shell::WebViewEvent::KIND_LAST)
+
+IPC_STRUCT_TRAITS_BEGIN(thrust_shell::WebViewEvent)
+  IPC_STRUCT_TRAITS_MEMBER(guest_instance_id)
+  IPC_STRUCT_TRAITS_MEMBER(type)
+  IPC_STRUCT_TRAITS_MEMBER(kind)
+  IPC_STRUCT_TRAITS_MEMBER(params_index)
+  IPC_STRUCT_TRAITS_MEMBER(level)
+  IPC_STRUCT_TRAITS_MEMBER(message)
+  IPC_STRUCT_TRAITS_MEMBER(line)
+  IPC_STRUCT_TRAITS_MEMBER(source_id)
+  IPC_STRUCT_TRAITS_MEMBER(current_url)
+  IPC_STRUCT_TRAITS_MEMBER(new_url)
+  IPC_STRUCT_TRAITS_MEMBER(is_top_level)
+  IPC_STRUCT_TRAITS_MEMBER(old_size)
+  IPC_STRUCT_TRAITS_MEMBER(new_size)
+IPC_STRUCT_TRAITS_END()
+
 // Sent by the renderer when the draggable regions are updated.
 IPC_MESSAGE_ROUTED1(ThrustViewHostMsg_UpdateDraggableRegions,
                     std::vector<thrust_shell::DraggableRegion> /* regions */)
 
 
+// WebViewReserveInstanceIDs
+// Sent by the renderer when it is running low on guest instance IDs.
+IPC_MESSAGE_ROUTED0(ThrustFrameHostMsg_WebViewReserveInstanceIDs)
+// WebViewInstanceIDsReserved
+// Sent to the main frame with a range of guest instance IDs reserved for it
+// (empty if the request was refused).
+IPC_MESSAGE_ROUTED2(ThrustFrameMsg_WebViewInstanceIDsReserved,
+                    int, /* first_instance_id */
+                    int /* count */)
+
 // CreateWebViewGuest
-IPC_SYNC_MESSAGE_ROUTED1_1(ThrustFrameHostMsg_CreateWebViewGuest,
-                           base::DictionaryValue, /* params */
-                           int /* guest_instance_id */)
+IPC_MESSAGE_ROUTED2(ThrustFrameHostMsg_CreateWebViewGuest,
+                    int, /* guest_instance_id */
+                    base::DictionaryValue /* params */)
 // DestroyWebViewGuest
 IPC_MESSAGE_ROUTED1(ThrustFrameHostMsg_DestroyWebViewGuest,
                     int /* guest_instance_id */)
@@ -66,6 +96,11 @@ IPC_MESSAGE_ROUTED2(ThrustFrameHostMsg_WebViewGuestSetZoom,
                     int, /* guest_instance_id */
                     double /* zoom_factor */)
 
+// WebViewGuestSetPriority
+IPC_MESSAGE_ROUTED2(ThrustFrameHostMsg_WebViewGuestSetPriority,
+                    int, /* guest_instance_id */
+                    std::string /* priority_class */)
+
 // WebViewGuestFind
 IPC_MESSAGE_ROUTED4(ThrustFrameHostMsg_WebViewGuestFind,
                     int, /* guest_instance_id */
@@ -73,6 +108,17 @@ IPC_MESSAGE_ROUTED4(ThrustFrameHostMsg_WebViewGuestFind,
                     std::string, /* search_text */
                     base::DictionaryValue /* options */)
 
+// WebViewGuestCapture
+IPC_MESSAGE_ROUTED3(ThrustFrameHostMsg_WebViewGuestCapture,
+                    int, /* guest_instance_id */
+                    int, /* request_id */
+                    base::DictionaryValue /* options */)
+
+// WebViewGuestReleaseCapture
+IPC_MESSAGE_ROUTED2(ThrustFrameHostMsg_WebViewGuestReleaseCapture,
+                    int, /* guest_instance_id */
+                    std::string /* path */)
+
 // WebViewGuestStopFinding
 IPC_MESSAGE_ROUTED2(ThrustFrameHostMsg_WebViewGuestStopFinding,
                     int, /* guest_instance_id */
@@ -108,11 +154,12 @@ IPC_MESSAGE_ROUTED3(ThrustFrameHostMsg_WebViewGuestJavaScriptDialogClosed,
                     std::string /* response */)
 
 
-// WebViewEmit
-IPC_MESSAGE_ROUTED3(ThrustFrameMsg_WebViewEmit,
-                    int, /* guest_instance_id */
-                    std::string, /* type */
-                    base::DictionaryValue /* event */)
+// WebViewEmitBatch
+// Events are batched per embedder frame, generic events reference their
+// dictionary in |params|.
+IPC_MESSAGE_ROUTED2(ThrustFrameMsg_WebViewEmitBatch,
+                    std::vector<thrust_shell::WebViewEvent>, /* events */
+                    base::ListValue /* params */)
 
 
 // RemoteSendMessage
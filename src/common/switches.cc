@@ -14,4 +14,17 @@ const char kOverlayScrollbars[]          = "overlay-scrollbars";
 const char kOverlayFullscreenVideo[]     = "overlay-fullscreen-video";
 const char kSharedWorker[]               = "shared-worker";
 
+// In-memory NetLog buffer size (in KB, 0 to disable) and capture level (one
+// of "events", the default, "basic", "all_but_bytes", "all").
+const char kNetLogBufferSize[]           = "netlog-buffer-size";
+const char kNetLogBufferLevel[]          = "netlog-buffer-level";
+
+// Packed application archive served over the app:// scheme.
+const char kAppArchive[]                 = "app-archive";
+
+// Number of renderer processes kept ready by the system session for new
+// windows and <webview> guests.
+const char kPrewarmWindows[]             = "prewarm-windows";
+const char kPrewarmGuests[]              = "prewarm-guests";
+
 }  // namespace switches
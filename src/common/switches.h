@@ -16,6 +16,14 @@ extern const char kOverlayScrollbars[];
 extern const char kOverlayFullscreenVideo[];
 extern const char kSharedWorker[];
 
+extern const char kNetLogBufferSize[];
+extern const char kNetLogBufferLevel[];
+
+extern const char kAppArchive[];
+
+extern const char kPrewarmWindows[];
+extern const char kPrewarmGuests[];
+
 }  // namespace switches
 
 #endif  // THRUST_SHELL_COMMON_SWITCHES_H_
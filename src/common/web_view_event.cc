@@ -0,0 +1,30 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/common/web_view_event.h"
+
+namespace thrust_shell {
+
+WebViewEvent::WebViewEvent()
+    : guest_instance_id(0),
+      kind(KIND_GENERIC),
+      params_index(-1),
+      level(0),
+      line(0),
+      is_top_level(false) {
+}
+
+WebViewEvent::WebViewEvent(
+    int guest_instance_id,
+    const std::string& type,
+    Kind kind)
+    : guest_instance_id(guest_instance_id),
+      type(type),
+      kind(kind),
+      params_index(-1),
+      level(0),
+      line(0),
+      is_top_level(false) {
+}
+
+}  // namespace thrust_shell
@@ -0,0 +1,59 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_COMMON_WEB_VIEW_EVENT_H_
+#define THRUST_SHELL_COMMON_WEB_VIEW_EVENT_H_
+
+#include <string>
+
+#include "base/strings/string16.h"
+#include "ui/gfx/size.h"
+#include "url/gurl.h"
+
+namespace thrust_shell {
+
+// ### WebViewEvent
+//
+// An event emitted by a WebViewGuest to its <webview> element. Events are
+// sent to the embedder by batches (see ThrustWindow::WebViewEmit). Frequent
+// events are typed so that they are serialized and converted to V8 without
+// going through a base::DictionaryValue. Other events are generic and carry
+// the index of their dictionary in the batch parameters.
+struct WebViewEvent {
+  enum Kind {
+    KIND_GENERIC = 0,
+    KIND_CONSOLE,
+    KIND_REDIRECT,
+    KIND_SIZE_CHANGED,
+    KIND_LAST = KIND_SIZE_CHANGED
+  };
+
+  WebViewEvent();
+  WebViewEvent(int guest_instance_id, const std::string& type, Kind kind);
+
+  int guest_instance_id;
+  std::string type;
+  Kind kind;
+
+  /* KIND_GENERIC */
+  int params_index;
+
+  /* KIND_CONSOLE */
+  int level;
+  base::string16 message;
+  int line;
+  base::string16 source_id;
+
+  /* KIND_REDIRECT */
+  GURL current_url;
+  GURL new_url;
+  bool is_top_level;
+
+  /* KIND_SIZE_CHANGED */
+  gfx::Size old_size;
+  gfx::Size new_size;
+};
+
+}  // namespace thrust_shell
+
+#endif  // THRUST_SHELL_COMMON_WEB_VIEW_EVENT_H_
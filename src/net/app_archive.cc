@@ -0,0 +1,117 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/app_archive.h"
+
+#include <string.h>
+
+#include "base/files/file_path.h"
+#include "base/logging.h"
+
+namespace thrust_shell {
+
+namespace {
+
+const char kMagic[] = "THRUSTPK";
+const size_t kMagicSize = 8;
+const uint32 kVersion = 1;
+const size_t kHeaderSize = kMagicSize + 4 + 4;
+const size_t kEntryHeaderSize = 4 + 4 + 2 + 2 + 2 + 2;
+
+/* Thrust only targets little endian platforms. */
+uint32
+ReadUInt32(
+    const uint8* p)
+{
+  uint32 v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint16
+ReadUInt16(
+    const uint8* p)
+{
+  uint16 v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+}
+
+ThrustShellAppArchive::ThrustShellAppArchive()
+{
+}
+
+ThrustShellAppArchive::~ThrustShellAppArchive()
+{
+}
+
+// static
+scoped_refptr<ThrustShellAppArchive>
+ThrustShellAppArchive::Open(
+    const base::FilePath& path)
+{
+  scoped_refptr<ThrustShellAppArchive> archive(new ThrustShellAppArchive);
+  if(!archive->file_.Initialize(path)) {
+    LOG(ERROR) << "Could not map app archive " << path.value();
+    return NULL;
+  }
+  if(!archive->Index()) {
+    LOG(ERROR) << "Malformed app archive " << path.value();
+    return NULL;
+  }
+  LOG(INFO) << "App archive " << path.value() << ": "
+            << archive->size() << " entries";
+  return archive;
+}
+
+bool
+ThrustShellAppArchive::Index()
+{
+  const uint8* data = file_.data();
+  size_t length = file_.length();
+
+  if(length < kHeaderSize || memcmp(data, kMagic, kMagicSize) != 0 ||
+     ReadUInt32(data + kMagicSize) != kVersion) {
+    return false;
+  }
+  uint32 count = ReadUInt32(data + kMagicSize + 4);
+
+  size_t pos = kHeaderSize;
+  for(uint32 i = 0; i < count; ++i) {
+    if(length - pos < kEntryHeaderSize)
+      return false;
+    uint32 offset = ReadUInt32(data + pos);
+    uint32 size = ReadUInt32(data + pos + 4);
+    uint16 path_len = ReadUInt16(data + pos + 8);
+    uint16 mime_len = ReadUInt16(data + pos + 10);
+    uint16 etag_len = ReadUInt16(data + pos + 12);
+    pos += kEntryHeaderSize;
+
+    if(length - pos < static_cast<size_t>(path_len) + mime_len + etag_len ||
+       offset > length || length - offset < size) {
+      return false;
+    }
+    const char* strings = reinterpret_cast<const char*>(data + pos);
+    Entry& entry = entries_[std::string(strings, path_len)];
+    entry.data = data + offset;
+    entry.size = size;
+    entry.mime_type.assign(strings + path_len, mime_len);
+    entry.etag.assign(strings + path_len + mime_len, etag_len);
+    pos += path_len + mime_len + etag_len;
+  }
+  return true;
+}
+
+const ThrustShellAppArchive::Entry*
+ThrustShellAppArchive::Find(
+    const std::string& path) const
+{
+  base::hash_map<std::string, Entry>::const_iterator it = entries_.find(path);
+  if(it == entries_.end())
+    return NULL;
+  return &it->second;
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,79 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_APP_ARCHIVE_H_
+#define THRUST_SHELL_NET_APP_ARCHIVE_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/hash_tables.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/memory/ref_counted.h"
+
+namespace base {
+class FilePath;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellAppArchive
+//
+// Read-only, memory-mapped archive of application resources served over the
+// `app://` scheme. The archive is produced by `scripts/pack-app.py` and is
+// made of a header and an index (with the MIME type and ETag of each entry
+// precomputed) followed by the entries data:
+// ```
+// "THRUSTPK" | uint32 version | uint32 count
+// count * { uint32 offset | uint32 size |
+//           uint16 path_len | uint16 mime_len | uint16 etag_len | uint16 0 |
+//           path | mime | etag }
+// data
+// ```
+// All integers are little endian and offsets are relative to the beginning of
+// the file. The index is parsed once when the archive is opened; entries data
+// are then served straight from the mapping from any thread.
+class ThrustShellAppArchive
+  : public base::RefCountedThreadSafe<ThrustShellAppArchive> {
+public:
+  struct Entry {
+    const uint8*              data;
+    size_t                    size;
+    std::string               mime_type;
+    std::string               etag;
+  };
+
+  // ### Open
+  // Maps and indexes the archive at |path|. Returns NULL if the archive can't
+  // be mapped or is malformed. Performs blocking IO.
+  // ```
+  // @path {FilePath} the archive path
+  // ```
+  static scoped_refptr<ThrustShellAppArchive> Open(const base::FilePath& path);
+
+  // ### Find
+  // Returns the entry for |path| (relative, without leading slash) or NULL.
+  const Entry* Find(const std::string& path) const;
+
+  size_t size() const { return entries_.size(); }
+
+private:
+  friend class base::RefCountedThreadSafe<ThrustShellAppArchive>;
+
+  ThrustShellAppArchive();
+  ~ThrustShellAppArchive();
+
+  bool Index();
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  base::MemoryMappedFile                     file_;
+  base::hash_map<std::string, Entry>         entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellAppArchive);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_APP_ARCHIVE_H_
@@ -0,0 +1,204 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/app_protocol_handler.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "net/base/escape.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_util.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_job.h"
+#include "net/url_request/url_request_status.h"
+
+#include "src/net/app_archive.h"
+
+namespace thrust_shell {
+
+const char kAppScheme[] = "app";
+
+namespace {
+
+const char kIndexFile[] = "index.html";
+
+class ThrustShellAppURLRequestJob : public net::URLRequestJob {
+public:
+  ThrustShellAppURLRequestJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<ThrustShellAppArchive>& archive)
+  : net::URLRequestJob(request, network_delegate),
+    archive_(archive),
+    entry_(NULL),
+    position_(0),
+    remaining_(0),
+    weak_factory_(this)
+  {
+  }
+
+  /****************************************************************************/
+  /* URLREQUESTJOB IMPLEMENTATION                                             */
+  /****************************************************************************/
+  virtual void Start() OVERRIDE {
+    /* Headers must not be notified synchronously from Start. */
+    base::MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(&ThrustShellAppURLRequestJob::StartAsync,
+                   weak_factory_.GetWeakPtr()));
+  }
+
+  virtual void Kill() OVERRIDE {
+    weak_factory_.InvalidateWeakPtrs();
+    net::URLRequestJob::Kill();
+  }
+
+  virtual void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) OVERRIDE {
+    headers.GetHeader(net::HttpRequestHeaders::kIfNoneMatch, &if_none_match_);
+    std::string range;
+    if(headers.GetHeader(net::HttpRequestHeaders::kRange, &range)) {
+      std::vector<net::HttpByteRange> ranges;
+      /* Multiple ranges are not supported, the whole entry is served. */
+      if(net::HttpUtil::ParseRangeHeader(range, &ranges) &&
+         ranges.size() == 1) {
+        byte_range_ = ranges[0];
+      }
+    }
+  }
+
+  virtual bool ReadRawData(net::IOBuffer* buf,
+                           int buf_size,
+                           int* bytes_read) OVERRIDE {
+    size_t count = std::min(remaining_, static_cast<size_t>(buf_size));
+    if(count > 0)
+      memcpy(buf->data(), entry_->data + position_, count);
+    position_ += count;
+    remaining_ -= count;
+    *bytes_read = count;
+    return true;
+  }
+
+  virtual bool GetMimeType(std::string* mime_type) const OVERRIDE {
+    if(!entry_)
+      return false;
+    *mime_type = entry_->mime_type;
+    return true;
+  }
+
+  virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
+    info->headers = headers_;
+  }
+
+  virtual int GetResponseCode() const OVERRIDE {
+    return headers_.get() ? headers_->response_code() : -1;
+  }
+
+private:
+  virtual ~ThrustShellAppURLRequestJob() {}
+
+  void StartAsync() {
+    std::string path = net::UnescapeURLComponent(
+        request()->url().path(),
+        net::UnescapeRule::SPACES | net::UnescapeRule::URL_SPECIAL_CHARS);
+    if(!path.empty() && path[0] == '/')
+      path = path.substr(1);
+    if(path.empty() || path[path.size() - 1] == '/')
+      path += kIndexFile;
+
+    entry_ = archive_->Find(path);
+    if(!entry_) {
+      NotifyStartError(net::URLRequestStatus(net::URLRequestStatus::FAILED,
+                                             net::ERR_FILE_NOT_FOUND));
+      return;
+    }
+
+    std::string status = "HTTP/1.1 200 OK";
+    std::string extra;
+    position_ = 0;
+    remaining_ = entry_->size;
+
+    if(!if_none_match_.empty() &&
+       (if_none_match_ == entry_->etag || if_none_match_ == "*")) {
+      status = "HTTP/1.1 304 Not Modified";
+      remaining_ = 0;
+    }
+    else if(byte_range_.IsValid()) {
+      if(!byte_range_.ComputeBounds(entry_->size)) {
+        NotifyStartError(
+            net::URLRequestStatus(net::URLRequestStatus::FAILED,
+                                  net::ERR_REQUEST_RANGE_NOT_SATISFIABLE));
+        return;
+      }
+      status = "HTTP/1.1 206 Partial Content";
+      position_ = byte_range_.first_byte_position();
+      remaining_ = byte_range_.last_byte_position() - position_ + 1;
+      extra = "Content-Range: bytes " +
+        base::Int64ToString(byte_range_.first_byte_position()) + "-" +
+        base::Int64ToString(byte_range_.last_byte_position()) + "/" +
+        base::Uint64ToString(entry_->size) + "\n";
+    }
+
+    std::string raw_headers = status + "\n" +
+      "Content-Type: " + entry_->mime_type + "\n" +
+      "Content-Length: " + base::Uint64ToString(remaining_) + "\n" +
+      "Accept-Ranges: bytes\n" +
+      /* Always revalidated, which is answered by a 304 from memory. */
+      "Cache-Control: no-cache\n" +
+      extra;
+    if(!entry_->etag.empty())
+      raw_headers += "ETag: " + entry_->etag + "\n";
+
+    headers_ = new net::HttpResponseHeaders(
+        net::HttpUtil::AssembleRawHeaders(raw_headers.c_str(),
+                                          raw_headers.size()));
+    set_expected_content_size(remaining_);
+    NotifyHeadersComplete();
+  }
+
+  scoped_refptr<ThrustShellAppArchive>            archive_;
+  const ThrustShellAppArchive::Entry*             entry_;
+  std::string                                     if_none_match_;
+  net::HttpByteRange                              byte_range_;
+  size_t                                          position_;
+  size_t                                          remaining_;
+  scoped_refptr<net::HttpResponseHeaders>         headers_;
+
+  base::WeakPtrFactory<ThrustShellAppURLRequestJob> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellAppURLRequestJob);
+};
+
+}
+
+ThrustShellAppProtocolHandler::ThrustShellAppProtocolHandler(
+    const scoped_refptr<ThrustShellAppArchive>& archive)
+: archive_(archive)
+{
+}
+
+ThrustShellAppProtocolHandler::~ThrustShellAppProtocolHandler()
+{
+}
+
+net::URLRequestJob*
+ThrustShellAppProtocolHandler::MaybeCreateJob(
+    net::URLRequest* request,
+    net::NetworkDelegate* network_delegate) const
+{
+  return new ThrustShellAppURLRequestJob(request, network_delegate, archive_);
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,45 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_APP_PROTOCOL_HANDLER_H_
+#define THRUST_SHELL_NET_APP_PROTOCOL_HANDLER_H_
+
+#include "base/memory/ref_counted.h"
+#include "net/url_request/url_request_job_factory.h"
+
+namespace thrust_shell {
+
+class ThrustShellAppArchive;
+
+extern const char kAppScheme[];
+
+// ### ThrustShellAppProtocolHandler
+//
+// Serves `app://<host>/<path>` requests from a ThrustShellAppArchive. The
+// host is ignored, directories resolve to their `index.html`. Responses
+// carry the precomputed MIME type and ETag of the entry, conditional
+// (`If-None-Match`) and single range requests are supported. Data is copied
+// from the mapping directly into the network buffers on the IO thread.
+class ThrustShellAppProtocolHandler
+  : public net::URLRequestJobFactory::ProtocolHandler {
+public:
+  explicit ThrustShellAppProtocolHandler(
+      const scoped_refptr<ThrustShellAppArchive>& archive);
+  virtual ~ThrustShellAppProtocolHandler();
+
+  /****************************************************************************/
+  /* URLREQUESTJOBFACTORY::PROTOCOLHANDLER IMPLEMENTATION                     */
+  /****************************************************************************/
+  virtual net::URLRequestJob* MaybeCreateJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate) const OVERRIDE;
+
+private:
+  scoped_refptr<ThrustShellAppArchive>       archive_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellAppProtocolHandler);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_APP_PROTOCOL_HANDLER_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/header_rules.h"
+
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+
+namespace thrust_shell {
+
+ThrustShellHeaderRules::Spec::Spec()
+: phase(PHASE_REQUEST),
+  operation(OPERATION_SET)
+{
+}
+
+ThrustShellHeaderRules::Counters::Counters()
+: matched(0),
+  applied(0)
+{
+}
+
+ThrustShellHeaderRules::ThrustShellHeaderRules()
+: has_request_rules_(false),
+  has_response_rules_(false)
+{
+}
+
+ThrustShellHeaderRules::~ThrustShellHeaderRules()
+{
+}
+
+// static
+bool
+ThrustShellHeaderRules::MatchesURL(
+    const Rule& rule,
+    const GURL& url,
+    std::string* spec)
+{
+  if(rule.url_pattern.empty())
+    return true;
+  if(spec->empty())
+    *spec = StringToLowerASCII(url.spec());
+  return MatchPattern(*spec, rule.url_pattern);
+}
+
+// static
+scoped_ptr<ThrustShellHeaderRules>
+ThrustShellHeaderRules::Compile(
+    const std::vector<Spec>& specs)
+{
+  scoped_ptr<ThrustShellHeaderRules> rules(new ThrustShellHeaderRules);
+  rules->rules_.reserve(specs.size());
+
+  for(size_t i = 0; i < specs.size(); ++i) {
+    Rule rule;
+    rule.phase = specs[i].phase;
+    rule.operation = specs[i].operation;
+    rule.name = specs[i].name;
+    rule.value = specs[i].value;
+    if(specs[i].url != "*")
+      rule.url_pattern = StringToLowerASCII(specs[i].url);
+
+    /* Rules with an invalid header are kept (to preserve the counters */
+    /* indices) but never match.                                       */
+    if(!net::HttpUtil::IsValidHeaderName(rule.name) ||
+       !net::HttpUtil::IsValidHeaderValue(rule.value)) {
+      LOG(ERROR) << "Invalid header rule: " << rule.name;
+      rule.name.clear();
+    }
+    if(rule.phase == PHASE_REQUEST)
+      rules->has_request_rules_ = true;
+    else
+      rules->has_response_rules_ = true;
+    rules->rules_.push_back(rule);
+  }
+  return rules.Pass();
+}
+
+void
+ThrustShellHeaderRules::ApplyToRequest(
+    const GURL& url,
+    net::HttpRequestHeaders* headers)
+{
+  if(!has_request_rules_)
+    return;
+
+  std::string spec;
+  for(size_t i = 0; i < rules_.size(); ++i) {
+    Rule& rule = rules_[i];
+    if(rule.phase != PHASE_REQUEST || rule.name.empty() ||
+       !MatchesURL(rule, url, &spec)) {
+      continue;
+    }
+    rule.counters.matched++;
+
+    std::string current;
+    bool present = headers->GetHeader(rule.name, &current);
+    switch(rule.operation) {
+      case OPERATION_SET:
+        if(present && current == rule.value)
+          continue;
+        headers->SetHeader(rule.name, rule.value);
+        break;
+      case OPERATION_APPEND:
+        headers->SetHeader(rule.name,
+                           present ? current + ", " + rule.value : rule.value);
+        break;
+      case OPERATION_REMOVE:
+        if(!present)
+          continue;
+        headers->RemoveHeader(rule.name);
+        break;
+    }
+    rule.counters.applied++;
+  }
+}
+
+void
+ThrustShellHeaderRules::ApplyToResponse(
+    const GURL& url,
+    const net::HttpResponseHeaders* original,
+    scoped_refptr<net::HttpResponseHeaders>* override_headers)
+{
+  if(!has_response_rules_ || !original)
+    return;
+
+  /* The copy is only made once a rule actually modifies the headers. */
+  scoped_refptr<net::HttpResponseHeaders> headers;
+  std::string spec;
+  for(size_t i = 0; i < rules_.size(); ++i) {
+    Rule& rule = rules_[i];
+    if(rule.phase != PHASE_RESPONSE || rule.name.empty() ||
+       !MatchesURL(rule, url, &spec)) {
+      continue;
+    }
+    rule.counters.matched++;
+
+    const net::HttpResponseHeaders* current =
+      headers.get() ? headers.get() : original;
+    bool present = current->HasHeader(rule.name);
+    if(rule.operation == OPERATION_REMOVE && !present)
+      continue;
+    if(rule.operation == OPERATION_SET && present &&
+       current->HasHeaderValue(rule.name, rule.value)) {
+      continue;
+    }
+
+    if(!headers.get())
+      headers = new net::HttpResponseHeaders(original->raw_headers());
+    if(rule.operation != OPERATION_APPEND)
+      headers->RemoveHeader(rule.name);
+    if(rule.operation != OPERATION_REMOVE)
+      headers->AddHeader(rule.name + ": " + rule.value);
+    rule.counters.applied++;
+  }
+
+  if(headers.get())
+    *override_headers = headers;
+}
+
+std::vector<ThrustShellHeaderRules::Counters>
+ThrustShellHeaderRules::GetCounters() const
+{
+  std::vector<Counters> counters;
+  counters.reserve(rules_.size());
+  for(size_t i = 0; i < rules_.size(); ++i) {
+    counters.push_back(rules_[i].counters);
+  }
+  return counters;
+}
+
+} // namespace thrust_shell
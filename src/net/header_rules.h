@@ -0,0 +1,118 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_HEADER_RULES_H_
+#define THRUST_SHELL_NET_HEADER_RULES_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "url/gurl.h"
+
+namespace net {
+class HttpRequestHeaders;
+class HttpResponseHeaders;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellHeaderRules
+//
+// Declarative header rewrite rules applied by the network delegate on the IO
+// thread to the headers of outgoing requests (OnBeforeSendHeaders) and of
+// incoming responses (OnHeadersReceived). Each rule sets, appends to or
+// removes a header, optionally restricted to URLs matching a pattern (`*`
+// and `?` wildcards). Rules are applied in order and count how many times
+// their URL matched and how many times they actually modified headers.
+//
+// Rules are compiled and used on the IO thread only.
+class ThrustShellHeaderRules {
+public:
+  enum Phase {
+    PHASE_REQUEST = 0,
+    PHASE_RESPONSE
+  };
+
+  enum Operation {
+    OPERATION_SET = 0,
+    OPERATION_APPEND,
+    OPERATION_REMOVE
+  };
+
+  // The uncompiled description of a rule, as received from the API.
+  struct Spec {
+    Spec();
+
+    Phase                     phase;
+    Operation                 operation;
+    std::string               name;
+    std::string               value;
+    std::string               url;
+  };
+
+  struct Counters {
+    Counters();
+
+    uint64                    matched;
+    uint64                    applied;
+  };
+
+  // ### Compile
+  // ```
+  // @specs {vector<Spec>} the rules, in the order they are applied
+  // ```
+  static scoped_ptr<ThrustShellHeaderRules> Compile(
+      const std::vector<Spec>& specs);
+  ~ThrustShellHeaderRules();
+
+  // ### ApplyToRequest
+  // Rewrites the request |headers| in place.
+  void ApplyToRequest(const GURL& url,
+                      net::HttpRequestHeaders* headers);
+
+  // ### ApplyToResponse
+  // Sets |override_headers| to a rewritten copy of |original| if any rule
+  // modified it, leaves it untouched otherwise.
+  void ApplyToResponse(
+      const GURL& url,
+      const net::HttpResponseHeaders* original,
+      scoped_refptr<net::HttpResponseHeaders>* override_headers);
+
+  // ### GetCounters
+  // Returns the counters of each rule, in the order of the specs.
+  std::vector<Counters> GetCounters() const;
+
+private:
+  struct Rule {
+    Phase                     phase;
+    Operation                 operation;
+    std::string               name;
+    std::string               value;
+    /* Lowercased pattern, empty when the rule applies to all URLs. */
+    std::string               url_pattern;
+    Counters                  counters;
+  };
+
+  ThrustShellHeaderRules();
+
+  // Matches |rule| against |url|, lowercasing it in |spec| on first use.
+  static bool MatchesURL(const Rule& rule,
+                         const GURL& url,
+                         std::string* spec);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  std::vector<Rule>                  rules_;
+  bool                               has_request_rules_;
+  bool                               has_response_rules_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellHeaderRules);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_HEADER_RULES_H_
@@ -0,0 +1,243 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/host_resolver.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/values.h"
+#include "net/base/address_family.h"
+#include "net/base/address_list.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+
+namespace thrust_shell {
+
+namespace {
+
+const size_t kDefaultCacheSize = 1000;
+/* Matches the TTL HostResolverImpl uses for getaddrinfo results, which come */
+/* without a record TTL.                                                     */
+const int kDefaultTTLSeconds = 60;
+
+net::HostCache::Key
+CacheKeyForRequest(
+    const net::HostResolver::RequestInfo& info)
+{
+  return net::HostCache::Key(info.hostname(),
+                             info.address_family(),
+                             info.host_resolver_flags());
+}
+
+}
+
+ThrustShellHostResolver::Options::Options()
+: async_dns(false),
+  cache_size(kDefaultCacheSize)
+{
+}
+
+ThrustShellHostResolver::Stats::Stats()
+: requests(0),
+  cache_hits(0),
+  resolves(0),
+  failures(0)
+{
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellHostResolver::Stats::ToValue() const
+{
+  scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetDouble("requests", requests);
+  value->SetDouble("cache_hits", cache_hits);
+  value->SetDouble("hit_rate", 
+                   requests ? static_cast<double>(cache_hits) / requests : 0);
+  value->SetDouble("resolves", resolves);
+  value->SetDouble("failures", failures);
+  value->SetDouble("mean_latency", resolves ? 
+                   total_latency.InMillisecondsF() / resolves : 0);
+  value->SetDouble("max_latency", max_latency.InMillisecondsF());
+  return value.Pass();
+}
+
+ThrustShellHostResolver::ThrustShellHostResolver(
+    const Options& options,
+    net::NetLog* net_log)
+: options_(options),
+  cache_(options.cache_size)
+{
+  /* Results are cached here, where size and TTL can be configured. The  */
+  /* inner resolver keeps its own cache only because it is where the TTL */
+  /* of the DNS records is available (see RecordTTL); it still serves    */
+  /* the entries evicted from ours before they expire.                   */
+  net::HostResolver::Options resolver_options;
+  resolver_options.enable_caching = true;
+  resolver_ = net::HostResolver::CreateSystemResolver(resolver_options,
+                                                      net_log);
+  resolver_->SetDnsClientEnabled(options_.async_dns);
+}
+
+ThrustShellHostResolver::~ThrustShellHostResolver()
+{
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellHostResolver::GetStats(
+    bool reset)
+{
+  scoped_ptr<base::DictionaryValue> value = stats_.ToValue();
+  value->SetBoolean("async_dns", options_.async_dns);
+  value->SetInteger("cache_size", cache_.max_entries());
+  value->SetInteger("cache_entries", cache_.size());
+  if(reset)
+    stats_ = Stats();
+  return value.Pass();
+}
+
+bool
+ThrustShellHostResolver::LookupCache(
+    const RequestInfo& info,
+    net::AddressList* addresses)
+{
+  if(!info.allow_cached_response())
+    return false;
+  const net::HostCache::Entry* entry =
+    cache_.Lookup(CacheKeyForRequest(info), base::TimeTicks::Now());
+  if(!entry)
+    return false;
+  *addresses = net::AddressList::CopyWithPort(entry->addrlist, info.port());
+  return true;
+}
+
+int
+ThrustShellHostResolver::Resolve(
+    const RequestInfo& info,
+    net::RequestPriority priority,
+    net::AddressList* addresses,
+    const net::CompletionCallback& callback,
+    RequestHandle* out_req,
+    const net::BoundNetLog& net_log)
+{
+  stats_.requests++;
+  if(LookupCache(info, addresses)) {
+    stats_.cache_hits++;
+    return net::OK;
+  }
+
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  /* The inner resolver is owned by this object and drops its callbacks */
+  /* when destroyed.                                                    */
+  int rv = resolver_->Resolve(
+      info, priority, addresses,
+      base::Bind(&ThrustShellHostResolver::OnResolveComplete,
+                 base::Unretained(this), info, addresses, start_time,
+                 callback),
+      out_req, net_log);
+  /* Synchronous results are not resolutions. Successes other than IP     */
+  /* literals are served from the inner resolver cache (entries evicted   */
+  /* from ours, which is bounded) or the HOSTS file: they are cache hits. */
+  net::IPAddressNumber ip;
+  if(rv == net::OK && !net::ParseIPLiteralToNumber(info.hostname(), &ip))
+    stats_.cache_hits++;
+  return rv;
+}
+
+void
+ThrustShellHostResolver::OnResolveComplete(
+    const RequestInfo& info,
+    net::AddressList* addresses,
+    base::TimeTicks start_time,
+    const net::CompletionCallback& callback,
+    int result)
+{
+  RecordResolve(info, *addresses, start_time, result);
+  callback.Run(result);
+}
+
+void
+ThrustShellHostResolver::RecordResolve(
+    const RequestInfo& info,
+    const net::AddressList& addresses,
+    base::TimeTicks start_time,
+    int result)
+{
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeDelta latency = now - start_time;
+  stats_.resolves++;
+  stats_.total_latency += latency;
+  stats_.max_latency = std::max(stats_.max_latency, latency);
+  if(result != net::OK) {
+    stats_.failures++;
+    return;
+  }
+  base::TimeDelta ttl = std::max(RecordTTL(info, now), options_.ttl_floor);
+  cache_.Set(CacheKeyForRequest(info),
+             net::HostCache::Entry(net::OK, addresses),
+             now, ttl);
+}
+
+base::TimeDelta
+ThrustShellHostResolver::RecordTTL(
+    const RequestInfo& info,
+    base::TimeTicks now)
+{
+  net::HostCache* cache = resolver_->GetHostCache();
+  if(cache) {
+    net::HostCache::Key key = CacheKeyForRequest(info);
+    const net::HostCache::Entry* entry = cache->Lookup(key, now);
+    /* Unspecified families are resolved as IPv4 when IPv6 is unreachable. */
+    if(!entry && key.address_family == net::ADDRESS_FAMILY_UNSPECIFIED) {
+      key.address_family = net::ADDRESS_FAMILY_IPV4;
+      key.host_resolver_flags |=
+        net::HOST_RESOLVER_DEFAULT_FAMILY_SET_DUE_TO_NO_IPV6;
+      entry = cache->Lookup(key, now);
+    }
+    /* Only results of the built-in DNS client carry the record TTL. */
+    if(entry && entry->has_ttl())
+      return entry->ttl;
+  }
+  return base::TimeDelta::FromSeconds(kDefaultTTLSeconds);
+}
+
+int
+ThrustShellHostResolver::ResolveFromCache(
+    const RequestInfo& info,
+    net::AddressList* addresses,
+    const net::BoundNetLog& net_log)
+{
+  if(LookupCache(info, addresses))
+    return net::OK;
+  /* Handles IP literals and localhost (and entries evicted from our cache */
+  /* that are still valid there).                                         */
+  return resolver_->ResolveFromCache(info, addresses, net_log);
+}
+
+void
+ThrustShellHostResolver::CancelRequest(
+    RequestHandle req)
+{
+  resolver_->CancelRequest(req);
+}
+
+void
+ThrustShellHostResolver::SetDnsClientEnabled(
+    bool enabled)
+{
+  resolver_->SetDnsClientEnabled(enabled);
+}
+
+net::HostCache*
+ThrustShellHostResolver::GetHostCache()
+{
+  return &cache_;
+}
+
+base::Value*
+ThrustShellHostResolver::GetDnsConfigAsValue() const
+{
+  return resolver_->GetDnsConfigAsValue();
+}
+
+} // namespace thrust_shell
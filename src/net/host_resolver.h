@@ -0,0 +1,112 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_HOST_RESOLVER_H_
+#define THRUST_SHELL_NET_HOST_RESOLVER_H_
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+#include "net/dns/host_cache.h"
+#include "net/dns/host_resolver.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace net {
+class NetLog;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellHostResolver
+//
+// Host resolver of a session. Wraps the default resolver (optionally using
+// the built-in asynchronous DNS client instead of the getaddrinfo worker
+// threads) and owns the session host cache so that its size and TTL can be
+// configured. Successful resolutions are cached for `max(record TTL,
+// ttl_floor)`, the record TTL being the one returned by the DNS server with
+// the built-in DNS client, and 60s (what the default resolver uses) for
+// getaddrinfo results. Failures are not cached. Cache hits and resolution
+// latencies are recorded and exposed through GetStats.
+//
+// Lives on the IO thread, owned by the URLRequestContextStorage.
+class ThrustShellHostResolver : public net::HostResolver {
+public:
+  struct Options {
+    Options();
+
+    bool                          async_dns;
+    size_t                        cache_size;
+    base::TimeDelta               ttl_floor;
+  };
+
+  struct Stats {
+    Stats();
+
+    scoped_ptr<base::DictionaryValue> ToValue() const;
+
+    uint64                        requests;
+    uint64                        cache_hits;
+    uint64                        resolves;
+    uint64                        failures;
+    base::TimeDelta               total_latency;
+    base::TimeDelta               max_latency;
+  };
+
+  ThrustShellHostResolver(const Options& options, net::NetLog* net_log);
+  virtual ~ThrustShellHostResolver();
+
+  // ### GetStats
+  // ```
+  // @reset {bool} whether to reset the statistics once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetStats(bool reset);
+
+  /****************************************************************************/
+  /* HOSTRESOLVER IMPLEMENTATION                                              */
+  /****************************************************************************/
+  virtual int Resolve(const RequestInfo& info,
+                      net::RequestPriority priority,
+                      net::AddressList* addresses,
+                      const net::CompletionCallback& callback,
+                      RequestHandle* out_req,
+                      const net::BoundNetLog& net_log) OVERRIDE;
+  virtual int ResolveFromCache(const RequestInfo& info,
+                               net::AddressList* addresses,
+                               const net::BoundNetLog& net_log) OVERRIDE;
+  virtual void CancelRequest(RequestHandle req) OVERRIDE;
+  virtual void SetDnsClientEnabled(bool enabled) OVERRIDE;
+  virtual net::HostCache* GetHostCache() OVERRIDE;
+  virtual base::Value* GetDnsConfigAsValue() const OVERRIDE;
+
+private:
+  bool LookupCache(const RequestInfo& info, net::AddressList* addresses);
+  void OnResolveComplete(const RequestInfo& info,
+                         net::AddressList* addresses,
+                         base::TimeTicks start_time,
+                         const net::CompletionCallback& callback,
+                         int result);
+  void RecordResolve(const RequestInfo& info,
+                     const net::AddressList& addresses,
+                     base::TimeTicks start_time,
+                     int result);
+  // Returns the TTL of the records the inner resolver just returned for
+  // |info| (the getaddrinfo default if unknown).
+  base::TimeDelta RecordTTL(const RequestInfo& info, base::TimeTicks now);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  const Options                        options_;
+  scoped_ptr<net::HostResolver>        resolver_;
+  net::HostCache                       cache_;
+  Stats                                stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellHostResolver);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_HOST_RESOLVER_H_
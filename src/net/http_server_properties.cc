@@ -0,0 +1,199 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/http_server_properties.h"
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task_runner_util.h"
+#include "base/values.h"
+#include "net/base/host_port_pair.h"
+
+namespace thrust_shell {
+
+namespace {
+
+const base::FilePath::CharType kServerPropertiesFile[] =
+  FILE_PATH_LITERAL("ServerProperties");
+const int kVersion = 1;
+/* Bounds the size of the file, most recently used entries are kept. */
+const size_t kMaxPersistedServers = 200;
+
+scoped_ptr<base::DictionaryValue>
+LoadState(
+    const base::FilePath& path)
+{
+  /* Runs on the background runner. */
+  std::string data;
+  if(!base::ReadFileToString(path, &data))
+    return scoped_ptr<base::DictionaryValue>();
+  scoped_ptr<base::Value> value(base::JSONReader::Read(data));
+  base::DictionaryValue* state = NULL;
+  int version = 0;
+  if(!value || !value->GetAsDictionary(&state) ||
+     !state->GetInteger("version", &version) || version != kVersion) {
+    LOG(WARNING) << "Ignoring invalid server properties: " << path.value();
+    return scoped_ptr<base::DictionaryValue>();
+  }
+  value.release();
+  return make_scoped_ptr(state);
+}
+
+}
+
+ThrustShellHttpServerProperties::ThrustShellHttpServerProperties(
+    const base::FilePath& path,
+    const scoped_refptr<base::SequencedTaskRunner>& background_runner)
+: writer_(path.Append(kServerPropertiesFile), background_runner),
+  weak_factory_(this)
+{
+  base::PostTaskAndReplyWithResult(
+      background_runner.get(), FROM_HERE,
+      base::Bind(&LoadState, writer_.path()),
+      base::Bind(&ThrustShellHttpServerProperties::OnLoaded,
+                 weak_factory_.GetWeakPtr()));
+}
+
+ThrustShellHttpServerProperties::~ThrustShellHttpServerProperties()
+{
+  if(writer_.HasPendingWrite())
+    writer_.DoScheduledWrite();
+}
+
+void
+ThrustShellHttpServerProperties::OnLoaded(
+    scoped_ptr<base::DictionaryValue> state)
+{
+  if(!state)
+    return;
+
+  base::ListValue* spdy_list = NULL;
+  if(state->GetList("spdy_servers", &spdy_list)) {
+    std::vector<std::string> spdy_servers;
+    for(size_t i = 0; i < spdy_list->GetSize(); ++i) {
+      std::string server;
+      if(spdy_list->GetString(i, &server))
+        spdy_servers.push_back(server);
+    }
+    InitializeSpdyServers(&spdy_servers, true);
+  }
+
+  base::ListValue* alternate_list = NULL;
+  if(state->GetList("alternate_protocols", &alternate_list)) {
+    net::AlternateProtocolMap alternate_map(kMaxPersistedServers);
+    /* Listed from most to least recently used. */
+    for(size_t i = alternate_list->GetSize(); i > 0; --i) {
+      base::DictionaryValue* entry = NULL;
+      std::string server;
+      std::string protocol;
+      int port = 0;
+      double probability = 1.0;
+      if(!alternate_list->GetDictionary(i - 1, &entry) ||
+         !entry->GetString("server", &server) ||
+         !entry->GetString("protocol", &protocol) ||
+         !entry->GetInteger("port", &port)) {
+        continue;
+      }
+      entry->GetDouble("probability", &probability);
+      net::AlternateProtocol alternate_protocol =
+        net::AlternateProtocolFromString(protocol);
+      if(!net::IsAlternateProtocolValid(alternate_protocol) ||
+         port <= 0 || port > 65535) {
+        continue;
+      }
+      net::HostPortPair host_port = net::HostPortPair::FromString(server);
+      if(host_port.host().empty())
+        continue;
+      alternate_map.Put(host_port,
+                        net::AlternateProtocolInfo(port, alternate_protocol,
+                                                   probability));
+    }
+    /* Entries learnt since startup take precedence. */
+    InitializeAlternateProtocolServers(&alternate_map);
+  }
+}
+
+void
+ThrustShellHttpServerProperties::Clear()
+{
+  net::HttpServerPropertiesImpl::Clear();
+  writer_.ScheduleWrite(this);
+}
+
+void
+ThrustShellHttpServerProperties::SetSupportsSpdy(
+    const net::HostPortPair& server,
+    bool support_spdy)
+{
+  net::HttpServerPropertiesImpl::SetSupportsSpdy(server, support_spdy);
+  writer_.ScheduleWrite(this);
+}
+
+void
+ThrustShellHttpServerProperties::SetAlternateProtocol(
+    const net::HostPortPair& server,
+    uint16 alternate_port,
+    net::AlternateProtocol alternate_protocol,
+    double probability)
+{
+  net::HttpServerPropertiesImpl::SetAlternateProtocol(
+      server, alternate_port, alternate_protocol, probability);
+  writer_.ScheduleWrite(this);
+}
+
+void
+ThrustShellHttpServerProperties::SetBrokenAlternateProtocol(
+    const net::HostPortPair& server)
+{
+  net::HttpServerPropertiesImpl::SetBrokenAlternateProtocol(server);
+  writer_.ScheduleWrite(this);
+}
+
+void
+ThrustShellHttpServerProperties::ClearAlternateProtocol(
+    const net::HostPortPair& server)
+{
+  net::HttpServerPropertiesImpl::ClearAlternateProtocol(server);
+  writer_.ScheduleWrite(this);
+}
+
+bool
+ThrustShellHttpServerProperties::SerializeData(
+    std::string* data)
+{
+  base::DictionaryValue state;
+  state.SetInteger("version", kVersion);
+
+  base::ListValue* spdy_list = new base::ListValue;
+  GetSpdyServerList(spdy_list, kMaxPersistedServers);
+  state.Set("spdy_servers", spdy_list);
+
+  /* Broken protocols are not persisted so that they are retried after a */
+  /* restart.                                                           */
+  base::ListValue* alternate_list = new base::ListValue;
+  const net::AlternateProtocolMap& alternate_map = alternate_protocol_map();
+  for(net::AlternateProtocolMap::const_iterator it = alternate_map.begin();
+      it != alternate_map.end() && 
+        alternate_list->GetSize() < kMaxPersistedServers; ++it) {
+    if(!net::IsAlternateProtocolValid(it->second.protocol))
+      continue;
+    base::DictionaryValue* entry = new base::DictionaryValue;
+    entry->SetString("server", it->first.ToString());
+    entry->SetInteger("port", it->second.port);
+    entry->SetString("protocol", 
+                     net::AlternateProtocolToString(it->second.protocol));
+    entry->SetDouble("probability", it->second.probability);
+    alternate_list->Append(entry);
+  }
+  state.Set("alternate_protocols", alternate_list);
+
+  base::JSONWriter::Write(&state, data);
+  return true;
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,78 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_HTTP_SERVER_PROPERTIES_H_
+#define THRUST_SHELL_NET_HTTP_SERVER_PROPERTIES_H_
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/important_file_writer.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/http/http_server_properties_impl.h"
+
+namespace base {
+class DictionaryValue;
+class SequencedTaskRunner;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellHttpServerProperties
+//
+// HttpServerPropertiesImpl persisted to `<path>/ServerProperties` for
+// persistent sessions. The SPDY servers and alternate protocol hints are
+// loaded asynchronously on the background runner at creation (and merged
+// with what was learnt in the meantime); every change schedules a write of
+// the whole state, debounced by the ImportantFileWriter commit interval.
+// Pending writes are flushed at destruction.
+//
+// Lives on the IO thread, owned by the URLRequestContextStorage.
+class ThrustShellHttpServerProperties 
+  : public net::HttpServerPropertiesImpl,
+    public base::ImportantFileWriter::DataSerializer {
+public:
+  ThrustShellHttpServerProperties(
+      const base::FilePath& path,
+      const scoped_refptr<base::SequencedTaskRunner>& background_runner);
+  virtual ~ThrustShellHttpServerProperties();
+
+  /****************************************************************************/
+  /* HTTPSERVERPROPERTIES IMPLEMENTATION                                      */
+  /****************************************************************************/
+  virtual void Clear() OVERRIDE;
+  virtual void SetSupportsSpdy(const net::HostPortPair& server,
+                               bool support_spdy) OVERRIDE;
+  virtual void SetAlternateProtocol(
+      const net::HostPortPair& server,
+      uint16 alternate_port,
+      net::AlternateProtocol alternate_protocol,
+      double probability) OVERRIDE;
+  virtual void SetBrokenAlternateProtocol(
+      const net::HostPortPair& server) OVERRIDE;
+  virtual void ClearAlternateProtocol(
+      const net::HostPortPair& server) OVERRIDE;
+
+  /****************************************************************************/
+  /* IMPORTANTFILEWRITER::DATASERIALIZER IMPLEMENTATION                       */
+  /****************************************************************************/
+  virtual bool SerializeData(std::string* data) OVERRIDE;
+
+private:
+  void OnLoaded(scoped_ptr<base::DictionaryValue> state);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  base::ImportantFileWriter                                writer_;
+
+  base::WeakPtrFactory<ThrustShellHttpServerProperties>    weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellHttpServerProperties);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_HTTP_SERVER_PROPERTIES_H_
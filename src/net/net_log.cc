@@ -6,16 +6,30 @@
 
 #include <stdio.h>
 
+#include "base/bind.h"
 #include "base/command_line.h"
+#include "base/file_util.h"
 #include "base/files/file_path.h"
+#include "base/json/json_writer.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task_runner_util.h"
 #include "base/values.h"
+#include "content/public/browser/browser_thread.h"
 #include "content/public/common/content_switches.h"
 #include "net/base/net_log_logger.h"
 
+#include "src/common/switches.h"
+#include "src/net/net_log_ring_buffer.h"
+
+using namespace content;
+
 namespace thrust_shell {
 
 namespace {
 
+/* Default size of the in-memory buffer, in KB. */
+const size_t kDefaultRingBufferSizeKB = 4096;
+
 base::DictionaryValue* 
 GetThrustShellConstants() 
 {
@@ -32,6 +46,66 @@ GetThrustShellConstants()
   return constants_dict;
 }
 
+/* Returns whether the buffer keeps the entries parameters and sets the */
+/* level to observe at. By default (`events`) only the events are kept,  */
+/* which spares materializing their parameters on every net event.       */
+bool
+RingBufferLogLevel(
+    const CommandLine* command_line,
+    net::NetLog::LogLevel* log_level)
+{
+  std::string level = 
+    command_line->GetSwitchValueASCII(switches::kNetLogBufferLevel);
+  /* Cookies and credentials are stripped unless explicitly requested as */
+  /* the buffer is always on.                                            */
+  *log_level = net::NetLog::LOG_STRIP_PRIVATE_DATA;
+  if(level == "all")
+    *log_level = net::NetLog::LOG_ALL;
+  else if(level == "all_but_bytes")
+    *log_level = net::NetLog::LOG_ALL_BUT_BYTES;
+  else if(level != "basic")
+    return false;
+  return true;
+}
+
+bool
+WriteNetLogDump(
+    const base::FilePath& path,
+    const std::string& constants,
+    const base::ListValue* entries)
+{
+  FILE* file = base::OpenFile(path, "w");
+  if(file == NULL) {
+    LOG(ERROR) << "Could not open file " << path.value()
+               << " for net log dump";
+    return false;
+  }
+
+  bool ok = fprintf(file, "{\"constants\": %s,\n\"events\": [\n",
+                    constants.c_str()) > 0;
+  /* Entries are only serialized here, on the blocking pool. */
+  std::string json;
+  for(size_t i = 0; ok && i < entries->GetSize(); ++i) {
+    const base::Value* entry = NULL;
+    entries->Get(i, &entry);
+    base::JSONWriter::Write(entry, &json);
+    ok = fputs(json.c_str(), file) >= 0 &&
+         fputs(i + 1 < entries->GetSize() ? ",\n" : "\n", file) >= 0;
+  }
+  ok = ok && fputs("]}\n", file) >= 0;
+  ok = base::CloseFile(file) && ok;
+  return ok;
+}
+
+void
+RunDumpCallback(
+    const ThrustShellNetLog::DumpCallback& callback,
+    size_t count,
+    bool ok)
+{
+  callback.Run(ok, ok ? count : 0);
+}
+
 }  // namespace
 
 ThrustShellNetLog::ThrustShellNetLog() 
@@ -63,6 +137,20 @@ ThrustShellNetLog::ThrustShellNetLog()
       net_log_logger_->StartObserving(this);
     }
   }
+
+  size_t size_kb = kDefaultRingBufferSizeKB;
+  if(command_line->HasSwitch(switches::kNetLogBufferSize)) {
+    base::StringToSizeT(
+        command_line->GetSwitchValueASCII(switches::kNetLogBufferSize),
+        &size_kb);
+  }
+  if(size_kb > 0) {
+    net::NetLog::LogLevel level;
+    bool with_params = RingBufferLogLevel(command_line, &level);
+    ring_buffer_.reset(new ThrustShellNetLogRingBuffer(size_kb * 1024,
+                                                       with_params));
+    AddThreadSafeObserver(ring_buffer_.get(), level);
+  }
 }
 
 ThrustShellNetLog::~ThrustShellNetLog() 
@@ -70,6 +158,37 @@ ThrustShellNetLog::~ThrustShellNetLog()
   // Remove the observer we own before we're destroyed.
   if (net_log_logger_)
     RemoveThreadSafeObserver(net_log_logger_.get());
+  if (ring_buffer_)
+    RemoveThreadSafeObserver(ring_buffer_.get());
+}
+
+void
+ThrustShellNetLog::Dump(
+    const base::FilePath& path,
+    base::TimeDelta window,
+    const DumpCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if(!ring_buffer_) {
+    callback.Run(false, 0);
+    return;
+  }
+
+  /* The snapshot is a copy so that the buffer keeps recording while the */
+  /* file is being written.                                              */
+  base::ListValue* entries = new base::ListValue;
+  ring_buffer_->Snapshot(window, entries);
+  size_t count = entries->GetSize();
+
+  std::string constants;
+  scoped_ptr<base::Value> constants_v(GetThrustShellConstants());
+  base::JSONWriter::Write(constants_v.get(), &constants);
+
+  base::PostTaskAndReplyWithResult(
+      BrowserThread::GetBlockingPool(),
+      FROM_HERE,
+      base::Bind(&WriteNetLogDump, path, constants, base::Owned(entries)),
+      base::Bind(&RunDumpCallback, callback, count));
 }
 
 } // namespace thrust_shell
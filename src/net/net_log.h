@@ -7,18 +7,41 @@
 
 #include <string>
 
+#include "base/callback.h"
+#include "base/files/file_path.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
 #include "net/base/net_log_logger.h"
 
 namespace thrust_shell {
 
+class ThrustShellNetLogRingBuffer;
+
 class ThrustShellNetLog : public net::NetLog {
  public:
+  typedef base::Callback<void(bool, size_t)> DumpCallback;
+
   ThrustShellNetLog();
   virtual ~ThrustShellNetLog();
 
+  // ### Dump
+  //
+  // Writes the entries of the in-memory buffer added in the last |window| to
+  // |path| in the format expected by chrome://net-internals. The file is
+  // written on the blocking pool and |callback| is called on the UI thread
+  // with whether the write succeeded and the number of entries written.
+  // ```
+  // @path     {FilePath} the destination file
+  // @window   {TimeDelta} the time window to dump (zero for the whole buffer)
+  // @callback {DumpCallback} called once written
+  // ```
+  void Dump(const base::FilePath& path,
+            base::TimeDelta window,
+            const DumpCallback& callback);
+
  private:
-  scoped_ptr<net::NetLogLogger> net_log_logger_;
+  scoped_ptr<net::NetLogLogger>              net_log_logger_;
+  scoped_ptr<ThrustShellNetLogRingBuffer>    ring_buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(ThrustShellNetLog);
 };
@@ -0,0 +1,133 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/net_log_ring_buffer.h"
+
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+
+namespace thrust_shell {
+
+namespace {
+
+/* Estimated overhead of a Value (object, allocation and container slot). */
+const size_t kValueOverhead = 32;
+
+/* Estimates the memory used by |value| without serializing it. */
+size_t
+EstimateSize(
+    const base::Value& value)
+{
+  size_t size = kValueOverhead;
+  switch(value.GetType()) {
+    case base::Value::TYPE_STRING: {
+      std::string str;
+      value.GetAsString(&str);
+      size += str.size();
+      break;
+    }
+    case base::Value::TYPE_BINARY: {
+      size += static_cast<const base::BinaryValue&>(value).GetSize();
+      break;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict = NULL;
+      value.GetAsDictionary(&dict);
+      for(base::DictionaryValue::Iterator it(*dict);
+          !it.IsAtEnd(); it.Advance()) {
+        size += it.key().size() + EstimateSize(it.value());
+      }
+      break;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list = NULL;
+      value.GetAsList(&list);
+      for(base::ListValue::const_iterator it = list->begin();
+          it != list->end(); ++it) {
+        size += EstimateSize(**it);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return size;
+}
+
+}  // namespace
+
+ThrustShellNetLogRingBuffer::ThrustShellNetLogRingBuffer(
+    size_t max_bytes,
+    bool with_params)
+: max_bytes_(max_bytes),
+  with_params_(with_params),
+  bytes_(0)
+{
+}
+
+ThrustShellNetLogRingBuffer::~ThrustShellNetLogRingBuffer()
+{
+}
+
+void
+ThrustShellNetLogRingBuffer::OnAddEntry(
+    const net::NetLog::Entry& entry)
+{
+  /* Nothing is serialized here, on the network threads. Parameters are */
+  /* only available for the duration of the call and are materialized   */
+  /* outside of the lock when kept.                                     */
+  Item item;
+  item.time = base::TimeTicks::Now();
+  item.type = entry.type();
+  item.source = entry.source();
+  item.phase = entry.phase();
+  item.bytes = sizeof(Item);
+  if(with_params_) {
+    item.params.reset(entry.ParametersToValue());
+    if(item.params.get())
+      item.bytes += EstimateSize(*item.params);
+  }
+  if(item.bytes > max_bytes_)
+    return;
+
+  base::AutoLock lock(lock_);
+  bytes_ += item.bytes;
+  items_.push_back(item);
+  while(bytes_ > max_bytes_) {
+    bytes_ -= items_.front().bytes;
+    items_.pop_front();
+  }
+}
+
+void
+ThrustShellNetLogRingBuffer::Snapshot(
+    base::TimeDelta window,
+    base::ListValue* entries) const
+{
+  base::TimeTicks since;
+  if(window > base::TimeDelta())
+    since = base::TimeTicks::Now() - window;
+
+  base::AutoLock lock(lock_);
+  /* Items are ordered by time so we only need to find the first one. */
+  std::deque<Item>::const_iterator it = items_.begin();
+  while(it != items_.end() && it->time < since)
+    ++it;
+  for(; it != items_.end(); ++it) {
+    /* Same format as net::NetLog::Entry::ToValue. */
+    base::DictionaryValue* entry = new base::DictionaryValue;
+    entry->SetString("time", base::Int64ToString(
+        (it->time - base::TimeTicks()).InMilliseconds()));
+    base::DictionaryValue* source = new base::DictionaryValue;
+    source->SetInteger("id", it->source.id);
+    source->SetInteger("type", it->source.type);
+    entry->Set("source", source);
+    entry->SetInteger("type", it->type);
+    entry->SetInteger("phase", it->phase);
+    if(it->params.get())
+      entry->Set("params", it->params->DeepCopy());
+    entries->Append(entry);
+  }
+}
+
+} // namespace thrust_shell
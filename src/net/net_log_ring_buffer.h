@@ -0,0 +1,81 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_NET_LOG_RING_BUFFER_H_
+#define THRUST_SHELL_NET_NET_LOG_RING_BUFFER_H_
+
+#include <deque>
+
+#include "base/basictypes.h"
+#include "base/memory/linked_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "net/base/net_log.h"
+
+namespace base {
+class ListValue;
+class Value;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellNetLogRingBuffer
+//
+// NetLog observer keeping the most recent entries in memory within a bounded
+// number of bytes (estimated). Oldest entries are evicted first. Entries are
+// kept unserialized: their event, source and phase, plus their parameters
+// only if requested (materializing them is the expensive part of logging).
+// They are converted to the `chrome://net-internals` format when a snapshot
+// is taken, and serialized to JSON by the caller.
+// Entries are added from any thread (NetLog observers are called on the
+// thread emitting the event) so the buffer is protected by a lock.
+class ThrustShellNetLogRingBuffer : public net::NetLog::ThreadSafeObserver {
+public:
+  // ```
+  // @max_bytes   {size_t} the maximum size of the entries kept
+  // @with_params {boolean} whether to keep the entries parameters
+  // ```
+  ThrustShellNetLogRingBuffer(size_t max_bytes, bool with_params);
+  virtual ~ThrustShellNetLogRingBuffer();
+
+  // ### Snapshot
+  // Copies the entries added in the last |window| (all of them if |window| is
+  // zero), oldest first, as `chrome://net-internals` event dictionaries.
+  // ```
+  // @window  {TimeDelta} the time window to retrieve
+  // @entries {ListValue} out: the entries
+  // ```
+  void Snapshot(base::TimeDelta window,
+                base::ListValue* entries) const;
+
+  /****************************************************************************/
+  /* NET::NETLOG::THREADSAFEOBSERVER IMPLEMENTATION                           */
+  /****************************************************************************/
+  virtual void OnAddEntry(const net::NetLog::Entry& entry) OVERRIDE;
+
+private:
+  struct Item {
+    base::TimeTicks                time;
+    net::NetLog::EventType         type;
+    net::NetLog::Source            source;
+    net::NetLog::EventPhase        phase;
+    linked_ptr<base::Value>        params;
+    size_t                         bytes;
+  };
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  const size_t                       max_bytes_;
+  const bool                         with_params_;
+
+  mutable base::Lock                 lock_;
+  std::deque<Item>                   items_;
+  size_t                             bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellNetLogRingBuffer);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_NET_LOG_RING_BUFFER_H_
@@ -0,0 +1,213 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/net_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#include "base/values.h"
+#include "net/base/load_timing_info.h"
+#include "net/url_request/url_request.h"
+
+namespace thrust_shell {
+
+namespace {
+
+/* Beyond this number of hosts, requests are aggregated under kOtherHosts. */
+const size_t kMaxHosts = 512;
+const char kOtherHosts[] = "(other)";
+
+const char* kPhaseNames[] = {
+  "dns", "connect", "ssl", "ttfb", "transfer", "total"
+};
+
+base::TimeDelta
+Between(
+    base::TimeTicks start,
+    base::TimeTicks end)
+{
+  if(start.is_null() || end.is_null() || end < start)
+    return base::TimeDelta();
+  return end - start;
+}
+
+}
+
+/******************************************************************************/
+/* HISTOGRAM */
+/******************************************************************************/
+
+ThrustShellTimeHistogram::ThrustShellTimeHistogram()
+: count_(0),
+  sum_us_(0),
+  max_us_(0)
+{
+  memset(buckets_, 0, sizeof(buckets_));
+}
+
+void
+ThrustShellTimeHistogram::Add(
+    base::TimeDelta duration)
+{
+  int64 us = std::max<int64>(duration.InMicroseconds(), 1);
+  int bucket = 0;
+  while(bucket < kBucketCount - 1 && (us >> (bucket + 1)) > 0)
+    ++bucket;
+  buckets_[bucket]++;
+  count_++;
+  sum_us_ += us;
+  max_us_ = std::max(max_us_, us);
+}
+
+double
+ThrustShellTimeHistogram::Percentile(
+    double p) const
+{
+  if(count_ == 0)
+    return 0;
+  double rank = p * count_;
+  uint32 seen = 0;
+  for(int i = 0; i < kBucketCount; ++i) {
+    if(buckets_[i] == 0)
+      continue;
+    if(seen + buckets_[i] >= rank) {
+      /* Interpolates within [2^i, 2^(i+1)) microseconds. */
+      double fraction = (rank - seen) / buckets_[i];
+      double low = std::ldexp(1.0, i);
+      return std::min(low + fraction * low, static_cast<double>(max_us_));
+    }
+    seen += buckets_[i];
+  }
+  return max_us_;
+}
+
+base::DictionaryValue*
+ThrustShellTimeHistogram::ToValue() const
+{
+  base::DictionaryValue* histogram_v = new base::DictionaryValue;
+  histogram_v->SetInteger("count", count_);
+  histogram_v->SetDouble("mean_ms",
+                         count_ ? sum_us_ / 1000.0 / count_ : 0.0);
+  histogram_v->SetDouble("p50_ms", Percentile(0.5) / 1000.0);
+  histogram_v->SetDouble("p90_ms", Percentile(0.9) / 1000.0);
+  histogram_v->SetDouble("p99_ms", Percentile(0.99) / 1000.0);
+  histogram_v->SetDouble("max_ms", max_us_ / 1000.0);
+  return histogram_v;
+}
+
+/******************************************************************************/
+/* STATS */
+/******************************************************************************/
+
+ThrustShellNetStats::Stats::Stats()
+: requests(0),
+  errors(0)
+{
+}
+
+void
+ThrustShellNetStats::Stats::Record(
+    const base::TimeDelta durations[PHASE_COUNT],
+    bool success)
+{
+  requests++;
+  if(!success) {
+    errors++;
+    return;
+  }
+  for(int i = 0; i < PHASE_COUNT; ++i) {
+    /* Phases that did not happen (reused socket, cached response...) are */
+    /* not recorded.                                                      */
+    if(durations[i] > base::TimeDelta())
+      phases[i].Add(durations[i]);
+  }
+}
+
+base::DictionaryValue*
+ThrustShellNetStats::Stats::ToValue() const
+{
+  base::DictionaryValue* stats_v = new base::DictionaryValue;
+  stats_v->SetInteger("requests", requests);
+  stats_v->SetInteger("errors", errors);
+  for(int i = 0; i < PHASE_COUNT; ++i) {
+    stats_v->Set(kPhaseNames[i], phases[i].ToValue());
+  }
+  return stats_v;
+}
+
+/******************************************************************************/
+/* NET STATS */
+/******************************************************************************/
+
+ThrustShellNetStats::ThrustShellNetStats()
+{
+}
+
+ThrustShellNetStats::~ThrustShellNetStats()
+{
+}
+
+void
+ThrustShellNetStats::RecordRequest(
+    net::URLRequest* request)
+{
+  if(!request->url().SchemeIsHTTPOrHTTPS())
+    return;
+
+  net::LoadTimingInfo timing;
+  request->GetLoadTimingInfo(&timing);
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  base::TimeDelta durations[PHASE_COUNT];
+  durations[PHASE_DNS] = Between(timing.connect_timing.dns_start,
+                                 timing.connect_timing.dns_end);
+  durations[PHASE_CONNECT] = Between(timing.connect_timing.connect_start,
+                                     timing.connect_timing.connect_end);
+  durations[PHASE_SSL] = Between(timing.connect_timing.ssl_start,
+                                 timing.connect_timing.ssl_end);
+  durations[PHASE_TTFB] = Between(timing.send_start,
+                                  timing.receive_headers_end);
+  durations[PHASE_TRANSFER] = Between(timing.receive_headers_end, now);
+  durations[PHASE_TOTAL] = Between(timing.request_start, now);
+
+  bool success = request->status().is_success();
+  session_.Record(durations, success);
+
+  std::string host = request->url().host();
+  std::map<std::string, Stats>::iterator it = hosts_.find(host);
+  if(it == hosts_.end() && hosts_.size() >= kMaxHosts)
+    it = hosts_.insert(std::make_pair(kOtherHosts, Stats())).first;
+  else if(it == hosts_.end())
+    it = hosts_.insert(std::make_pair(host, Stats())).first;
+  it->second.Record(durations, success);
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellNetStats::Summary(
+    const std::string& host) const
+{
+  scoped_ptr<base::DictionaryValue> summary_v(session_.ToValue());
+
+  base::DictionaryValue* hosts_v = new base::DictionaryValue;
+  for(std::map<std::string, Stats>::const_iterator it = hosts_.begin();
+      it != hosts_.end(); ++it) {
+    if(!host.empty() && it->first != host)
+      continue;
+    /* Hosts may contain dots which would be interpreted as paths by Set. */
+    hosts_v->SetWithoutPathExpansion(it->first, it->second.ToValue());
+  }
+  summary_v->Set("hosts", hosts_v);
+
+  return summary_v.Pass();
+}
+
+void
+ThrustShellNetStats::Reset()
+{
+  session_ = Stats();
+  hosts_.clear();
+}
+
+} // namespace thrust_shell
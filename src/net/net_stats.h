@@ -0,0 +1,109 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_NET_STATS_H_
+#define THRUST_SHELL_NET_NET_STATS_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace net {
+class URLRequest;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellTimeHistogram
+//
+// Histogram of durations with a bucket per power of 2 microseconds (up to
+// ~67s). Percentiles are interpolated within buckets.
+class ThrustShellTimeHistogram {
+public:
+  ThrustShellTimeHistogram();
+
+  void Add(base::TimeDelta duration);
+  double Percentile(double p) const;
+  // Returns `count`, `mean_ms`, `p50_ms`, `p90_ms`, `p99_ms` and `max_ms`.
+  base::DictionaryValue* ToValue() const;
+
+private:
+  static const int kBucketCount = 27;
+
+  uint32        buckets_[kBucketCount];
+  uint32        count_;
+  int64         sum_us_;
+  int64         max_us_;
+};
+
+// ### ThrustShellNetStats
+//
+// Aggregates the load timing of completed requests (DNS, connect, TLS, time to
+// first byte, transfer and total) per session and per host into fixed size
+// log scale histograms. It lives on the IO thread, owned by the network
+// delegate, so no locking is needed.
+class ThrustShellNetStats {
+public:
+  enum Phase {
+    PHASE_DNS = 0,
+    PHASE_CONNECT,
+    PHASE_SSL,
+    PHASE_TTFB,
+    PHASE_TRANSFER,
+    PHASE_TOTAL,
+    PHASE_COUNT
+  };
+
+  ThrustShellNetStats();
+  ~ThrustShellNetStats();
+
+  // ### RecordRequest
+  // Records the timing of a completed request.
+  // ```
+  // @request {URLRequest} the request, on completion
+  // ```
+  void RecordRequest(net::URLRequest* request);
+
+  // ### Summary
+  // Returns the session summary along with one summary per host (or only
+  // |host| if not empty).
+  // ```
+  // @host {string} optional host filter
+  // ```
+  scoped_ptr<base::DictionaryValue> Summary(const std::string& host) const;
+
+  // ### Reset
+  void Reset();
+
+private:
+  struct Stats {
+    Stats();
+
+    void Record(const base::TimeDelta durations[PHASE_COUNT],
+                bool success);
+    base::DictionaryValue* ToValue() const;
+
+    uint32                      requests;
+    uint32                      errors;
+    ThrustShellTimeHistogram    phases[PHASE_COUNT];
+  };
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  Stats                              session_;
+  std::map<std::string, Stats>       hosts_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellNetStats);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_NET_STATS_H_
@@ -4,19 +4,66 @@
 
 #include "src/net/network_delegate.h"
 
+#include "base/bind.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/resource_request_info.h"
+#include "content/public/common/resource_type.h"
 #include "net/base/net_errors.h"
 #include "net/base/static_cookie_policy.h"
+#include "net/base/upload_data_stream.h"
 #include "net/url_request/url_request.h"
 
+#include "src/browser/thrust_window.h"
+
 using namespace content;
 
 namespace thrust_shell {
 
 namespace {
 bool g_accept_all_cookies = true;
+
+/* Network usage is handed to the UI thread at most once per interval. */
+const int kNetworkUsageFlushIntervalMs = 1000;
+
+ThrustShellURLRuleSet::ResourceType
+URLRuleTypeForRequest(
+    net::URLRequest* request)
+{
+  const ResourceRequestInfo* info = ResourceRequestInfo::ForRequest(request);
+  if(!info)
+    return ThrustShellURLRuleSet::TYPE_OTHER;
+
+  switch(info->GetResourceType()) {
+    case ResourceType::MAIN_FRAME:
+      return ThrustShellURLRuleSet::TYPE_DOCUMENT;
+    case ResourceType::SUB_FRAME:
+      return ThrustShellURLRuleSet::TYPE_SUBDOCUMENT;
+    case ResourceType::STYLESHEET:
+      return ThrustShellURLRuleSet::TYPE_STYLESHEET;
+    case ResourceType::SCRIPT:
+      return ThrustShellURLRuleSet::TYPE_SCRIPT;
+    case ResourceType::IMAGE:
+    case ResourceType::FAVICON:
+      return ThrustShellURLRuleSet::TYPE_IMAGE;
+    case ResourceType::FONT_RESOURCE:
+      return ThrustShellURLRuleSet::TYPE_FONT;
+    case ResourceType::OBJECT:
+      return ThrustShellURLRuleSet::TYPE_OBJECT;
+    case ResourceType::MEDIA:
+      return ThrustShellURLRuleSet::TYPE_MEDIA;
+    case ResourceType::XHR:
+      return ThrustShellURLRuleSet::TYPE_XMLHTTPREQUEST;
+    case ResourceType::PING:
+      return ThrustShellURLRuleSet::TYPE_PING;
+    default:
+      return ThrustShellURLRuleSet::TYPE_OTHER;
+  }
+}
+
 }
 
 ThrustShellNetworkDelegate::ThrustShellNetworkDelegate() 
+: request_scheduler_(NULL)
 {
 }
 
@@ -31,12 +78,89 @@ ThrustShellNetworkDelegate::SetAcceptAllCookies(
   g_accept_all_cookies = accept;
 }
 
+void
+ThrustShellNetworkDelegate::SetURLRules(
+    const scoped_refptr<ThrustShellURLRuleSet>& rules)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  url_rules_ = rules;
+}
+
+void
+ThrustShellNetworkDelegate::SetHeaderRules(
+    scoped_ptr<ThrustShellHeaderRules> rules)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  header_rules_ = rules.Pass();
+}
+
+std::vector<ThrustShellHeaderRules::Counters>
+ThrustShellNetworkDelegate::GetHeaderRulesCounters() const
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(!header_rules_)
+    return std::vector<ThrustShellHeaderRules::Counters>();
+  return header_rules_->GetCounters();
+}
+
+ThrustShellNetworkUsage*
+ThrustShellNetworkDelegate::UsageForRequest(
+    const net::URLRequest& request)
+{
+  const ResourceRequestInfo* info = ResourceRequestInfo::ForRequest(&request);
+  int render_process_id = 0;
+  int render_frame_id = 0;
+  if(!info ||
+     !info->GetAssociatedRenderFrame(&render_process_id, &render_frame_id)) {
+    return NULL;
+  }
+
+  if(!network_usage_timer_.IsRunning()) {
+    network_usage_timer_.Start(
+        FROM_HERE,
+        base::TimeDelta::FromMilliseconds(kNetworkUsageFlushIntervalMs),
+        this,
+        &ThrustShellNetworkDelegate::FlushNetworkUsage);
+  }
+  return &network_usage_[std::make_pair(render_process_id, render_frame_id)];
+}
+
+void
+ThrustShellNetworkDelegate::FlushNetworkUsage()
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(network_usage_.empty())
+    return;
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(&ThrustWindow::AccountNetworkUsage, network_usage_));
+  network_usage_.clear();
+}
+
 int 
 ThrustShellNetworkDelegate::OnBeforeURLRequest(
     net::URLRequest* request,
     const net::CompletionCallback& callback,
-    GURL* new_url) {
-  return net::OK;
+    GURL* new_url) 
+{
+  if(!url_rules_.get())
+    return net::OK;
+
+  GURL redirect_url;
+  switch(url_rules_->Match(request->url(),
+                           request->first_party_for_cookies(),
+                           URLRuleTypeForRequest(request),
+                           &redirect_url)) {
+    case ThrustShellURLRuleSet::ACTION_BLOCK:
+      return net::ERR_BLOCKED_BY_CLIENT;
+    case ThrustShellURLRuleSet::ACTION_CANCEL:
+      return net::ERR_ABORTED;
+    case ThrustShellURLRuleSet::ACTION_REDIRECT:
+      *new_url = redirect_url;
+      return net::OK;
+    default:
+      return net::OK;
+  }
 }
 
 int 
@@ -45,6 +169,8 @@ ThrustShellNetworkDelegate::OnBeforeSendHeaders(
     const net::CompletionCallback& callback,
     net::HttpRequestHeaders* headers) 
 {
+  if(header_rules_)
+    header_rules_->ApplyToRequest(request->url(), headers);
   return net::OK;
 }
 
@@ -53,6 +179,12 @@ ThrustShellNetworkDelegate::OnSendHeaders(
     net::URLRequest* request,
     const net::HttpRequestHeaders& headers) 
 {
+  ThrustShellNetworkUsage* usage = UsageForRequest(*request);
+  if(usage) {
+    usage->bytes_sent += headers.ToString().size();
+    if(request->get_upload())
+      usage->bytes_sent += request->get_upload()->size();
+  }
 }
 
 int 
@@ -63,6 +195,11 @@ ThrustShellNetworkDelegate::OnHeadersReceived(
     scoped_refptr<net::HttpResponseHeaders>* override_response_headers,
     GURL* allowed_unsafe_redirect_url)
 {
+  if(header_rules_) {
+    header_rules_->ApplyToResponse(request->url(), 
+                                   original_response_headers,
+                                   override_response_headers);
+  }
   return net::OK;
 }
 
@@ -84,6 +221,12 @@ ThrustShellNetworkDelegate::OnRawBytesRead(
     const net::URLRequest& request,
     int bytes_read) 
 {
+  /* Reads from the cache are not network usage. */
+  if(request.was_cached())
+    return;
+  ThrustShellNetworkUsage* usage = UsageForRequest(request);
+  if(usage)
+    usage->bytes_received += bytes_read;
 }
 
 void 
@@ -91,6 +234,15 @@ ThrustShellNetworkDelegate::OnCompleted(
     net::URLRequest* request, 
     bool started) 
 {
+  if(started)
+    net_stats_.RecordRequest(request);
+
+  ThrustShellNetworkUsage* usage = UsageForRequest(*request);
+  if(usage) {
+    usage->requests++;
+    if(request->was_cached())
+      usage->cache_hits++;
+  }
 }
 
 void 
@@ -7,8 +7,16 @@
 
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/timer/timer.h"
 #include "net/base/network_delegate.h"
 
+#include "src/net/header_rules.h"
+#include "src/net/net_stats.h"
+#include "src/net/network_usage.h"
+#include "src/net/request_scheduler.h"
+#include "src/net/url_rule_set.h"
+
 namespace thrust_shell {
 
 class ThrustShellNetworkDelegate : public net::NetworkDelegate {
@@ -18,7 +26,47 @@ class ThrustShellNetworkDelegate : public net::NetworkDelegate {
 
   static void SetAcceptAllCookies(bool accept);
 
+  // ### SetURLRules
+  // Installs the rule set evaluated for each request in OnBeforeURLRequest.
+  // Runs on the IO thread.
+  // ```
+  // @rules {ThrustShellURLRuleSet} the compiled rules (NULL to clear)
+  // ```
+  void SetURLRules(const scoped_refptr<ThrustShellURLRuleSet>& rules);
+
+  // ### SetHeaderRules
+  // Installs the header rewrite rules applied in OnBeforeSendHeaders and
+  // OnHeadersReceived. Runs on the IO thread.
+  // ```
+  // @rules {ThrustShellHeaderRules} the compiled rules
+  // ```
+  void SetHeaderRules(scoped_ptr<ThrustShellHeaderRules> rules);
+  // ### GetHeaderRulesCounters
+  // Returns the counters of the installed header rules. Runs on the IO thread.
+  std::vector<ThrustShellHeaderRules::Counters> GetHeaderRulesCounters() const;
+
+  // ### net_stats
+  // The load timing statistics of the requests of this delegate. Must only be
+  // accessed on the IO thread.
+  ThrustShellNetStats* net_stats() { return &net_stats_; }
+
+  // ### request_scheduler
+  // The scheduler of the session this delegate belongs to (owned by the
+  // URLRequestContextGetter). Must only be accessed on the IO thread.
+  ThrustShellRequestScheduler* request_scheduler() const {
+    return request_scheduler_;
+  }
+  void set_request_scheduler(ThrustShellRequestScheduler* scheduler) {
+    request_scheduler_ = scheduler;
+  }
+
  private:
+  /* Returns the usage counters of the frame |request| belongs to, NULL if */
+  /* it does not belong to a frame.                                       */
+  ThrustShellNetworkUsage* UsageForRequest(const net::URLRequest& request);
+  /* Hands the accumulated usage to the UI thread for attribution. */
+  void FlushNetworkUsage();
+
   /* net::NetworkDelegate implementation. */
   virtual int OnBeforeURLRequest(net::URLRequest* request,
                                  const net::CompletionCallback& callback,
@@ -62,6 +110,16 @@ class ThrustShellNetworkDelegate : public net::NetworkDelegate {
       net::SocketStream* stream,
       const net::CompletionCallback& callback) OVERRIDE;
 
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  scoped_refptr<ThrustShellURLRuleSet>             url_rules_;
+  scoped_ptr<ThrustShellHeaderRules>               header_rules_;
+  ThrustShellNetStats                              net_stats_;
+  ThrustShellNetworkUsageMap                       network_usage_;
+  base::OneShotTimer<ThrustShellNetworkDelegate>   network_usage_timer_;
+  ThrustShellRequestScheduler*                     request_scheduler_;
+
   DISALLOW_COPY_AND_ASSIGN(ThrustShellNetworkDelegate);
 };
 
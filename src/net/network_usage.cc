@@ -0,0 +1,40 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/network_usage.h"
+
+#include "base/values.h"
+
+namespace thrust_shell {
+
+ThrustShellNetworkUsage::ThrustShellNetworkUsage()
+: bytes_received(0),
+  bytes_sent(0),
+  requests(0),
+  cache_hits(0)
+{
+}
+
+void
+ThrustShellNetworkUsage::Add(
+    const ThrustShellNetworkUsage& other)
+{
+  bytes_received += other.bytes_received;
+  bytes_sent += other.bytes_sent;
+  requests += other.requests;
+  cache_hits += other.cache_hits;
+}
+
+base::DictionaryValue*
+ThrustShellNetworkUsage::ToValue() const
+{
+  /* Counters may exceed the range of integer values. */
+  base::DictionaryValue* usage_v = new base::DictionaryValue;
+  usage_v->SetDouble("bytes_received", bytes_received);
+  usage_v->SetDouble("bytes_sent", bytes_sent);
+  usage_v->SetDouble("requests", requests);
+  usage_v->SetDouble("cache_hits", cache_hits);
+  return usage_v;
+}
+
+} // namespace thrust_shell
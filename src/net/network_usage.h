@@ -0,0 +1,40 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_NETWORK_USAGE_H_
+#define THRUST_SHELL_NET_NETWORK_USAGE_H_
+
+#include <map>
+#include <utility>
+
+#include "base/basictypes.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellNetworkUsage
+//
+// Network usage counters accumulated by the network delegate on the IO thread
+// and attributed on the UI thread to WebViewGuests and ThrustWindows.
+struct ThrustShellNetworkUsage {
+  ThrustShellNetworkUsage();
+
+  void Add(const ThrustShellNetworkUsage& other);
+  base::DictionaryValue* ToValue() const;
+
+  int64                       bytes_received;
+  int64                       bytes_sent;
+  int64                       requests;
+  int64                       cache_hits;
+};
+
+// Usage keyed by (render_process_id, render_frame_id).
+typedef std::map<std::pair<int, int>, ThrustShellNetworkUsage> 
+  ThrustShellNetworkUsageMap;
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_NETWORK_USAGE_H_
@@ -0,0 +1,806 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/parallel_download.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/files/file.h"
+#include "base/files/important_file_writer.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/timer/timer.h"
+#include "base/values.h"
+#include "content/public/browser/browser_thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_response_headers.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_context.h"
+#include "url/gurl.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+namespace {
+
+const int kDefaultConnections = 4;
+const int kMaxConnections = 16;
+const int64 kDefaultMinSegmentSize = 1024 * 1024;
+const int kReadBufferSize = 64 * 1024;
+const int kMaxSegmentRetries = 3;
+const int kRetryDelayMs = 1000;
+const int kProgressIntervalMs = 500;
+const base::FilePath::CharType kStateExtension[] = 
+  FILE_PATH_LITERAL(".tdownload");
+
+}
+
+/******************************************************************************/
+/* FILE */
+/******************************************************************************/
+
+/* The target file and its state file. All methods run on the file runner. */
+class ThrustShellParallelDownloader::File
+  : public base::RefCountedThreadSafe<ThrustShellParallelDownloader::File> {
+public:
+  explicit File(const base::FilePath& path)
+  : path_(path),
+    state_path_(path.AddExtension(kStateExtension))
+  {
+  }
+
+  scoped_ptr<base::DictionaryValue> LoadState() {
+    std::string data;
+    if(!base::ReadFileToString(state_path_, &data))
+      return scoped_ptr<base::DictionaryValue>();
+    scoped_ptr<base::Value> value(base::JSONReader::Read(data));
+    base::DictionaryValue* state = NULL;
+    double total = 0;
+    int64 length = 0;
+    /* The target is preallocated to its full size when opened: a missing */
+    /* or truncated target means the ranges recorded as received are     */
+    /* gone and the state is discarded.                                  */
+    if(!value || !value->GetAsDictionary(&state) ||
+       !state->GetDouble("total", &total) ||
+       !base::GetFileSize(path_, &length) || length != total) {
+      base::DeleteFile(state_path_, false);
+      return scoped_ptr<base::DictionaryValue>();
+    }
+    value.release();
+    return make_scoped_ptr(state);
+  }
+
+  bool Open(int64 length, bool truncate) {
+    base::CreateDirectory(path_.DirName());
+    file_.Initialize(path_, 
+                     (truncate ? base::File::FLAG_CREATE_ALWAYS :
+                                 base::File::FLAG_OPEN_ALWAYS) |
+                     base::File::FLAG_READ | base::File::FLAG_WRITE);
+    if(!file_.IsValid())
+      return false;
+    /* Extending the file does not write it, which leaves it sparse on */
+    /* file systems supporting it.                                     */
+    if(length >= 0 && file_.GetLength() != length && !file_.SetLength(length))
+      return false;
+    return true;
+  }
+
+  bool Write(int64 offset, scoped_refptr<net::IOBuffer> buffer, int size) {
+    return file_.IsValid() && 
+      file_.Write(offset, buffer->data(), size) == size;
+  }
+
+  void SaveState(const std::string& state) {
+    if(!file_.IsValid())
+      return;
+    base::ImportantFileWriter::WriteFileAtomically(state_path_, state);
+  }
+
+  void Close() {
+    file_.Close();
+  }
+
+  void Complete() {
+    file_.Close();
+    base::DeleteFile(state_path_, false);
+  }
+
+private:
+  friend class base::RefCountedThreadSafe<File>;
+  ~File() {}
+
+  const base::FilePath         path_;
+  const base::FilePath         state_path_;
+  base::File                   file_;
+
+  DISALLOW_COPY_AND_ASSIGN(File);
+};
+
+/******************************************************************************/
+/* JOB */
+/******************************************************************************/
+
+class ThrustShellParallelDownloader::Job : public net::URLRequest::Delegate {
+public:
+  Job(ThrustShellParallelDownloader* downloader,
+      int id,
+      const GURL& url,
+      const base::FilePath& path,
+      const Options& options,
+      const EventCallback& callback);
+  virtual ~Job();
+
+  void Start();
+  void Cancel();
+
+  /* Segment interface. */
+  net::URLRequestContext* context() const { return downloader_->context_; }
+  const GURL& url() const { return url_; }
+  const std::string& validator() const { return validator_; }
+  const scoped_refptr<File>& file() const { return file_; }
+  base::SequencedTaskRunner* file_runner() const { 
+    return downloader_->file_runner_.get(); 
+  }
+  void OnSegmentComplete(Segment* segment);
+  void OnSegmentFailed(Segment* segment, const std::string& error);
+
+  /****************************************************************************/
+  /* URLREQUEST::DELEGATE IMPLEMENTATION (PROBE)                              */
+  /****************************************************************************/
+  virtual void OnResponseStarted(net::URLRequest* request) OVERRIDE;
+  virtual void OnReadCompleted(net::URLRequest* request, 
+                               int bytes_read) OVERRIDE;
+
+private:
+  void OnStateLoaded(scoped_ptr<base::DictionaryValue> state);
+  bool RestoreSegments(const base::DictionaryValue& state);
+  void CreateSegments();
+  void OnFileOpened(bool ok);
+  void OnCompleted();
+  std::string SerializeState();
+  int64 Received();
+  void ProgressTick();
+  void CancelSegments();
+  void Interrupt(const std::string& type, const std::string& error);
+  void Finish(const std::string& type, 
+              scoped_ptr<base::DictionaryValue> event);
+
+  ThrustShellParallelDownloader*       downloader_;
+  const int                            id_;
+  const GURL                           url_;
+  const base::FilePath                 path_;
+  const Options                        options_;
+  const EventCallback                  callback_;
+  scoped_refptr<File>                  file_;
+
+  scoped_ptr<base::DictionaryValue>    saved_state_;
+  scoped_ptr<net::URLRequest>          probe_;
+  bool                                 ranged_;
+  int64                                total_;
+  std::string                          etag_;
+  std::string                          last_modified_;
+  std::string                          validator_;
+  ScopedVector<Segment>                segments_;
+  bool                                 opened_;
+  bool                                 finished_;
+
+  base::TimeTicks                      start_time_;
+  int64                                last_received_;
+  base::RepeatingTimer<Job>            progress_timer_;
+
+  base::WeakPtrFactory<Job>            weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(Job);
+};
+
+/******************************************************************************/
+/* SEGMENT */
+/******************************************************************************/
+
+/* A range of the file downloaded over its own request. Non ranged segments */
+/* span the whole resource, whose size may be unknown.                      */
+class ThrustShellParallelDownloader::Segment 
+  : public net::URLRequest::Delegate {
+public:
+  Segment(Job* job, int64 start, int64 end, int64 received, bool ranged)
+  : job_(job),
+    start_(start),
+    end_(end),
+    received_(received),
+    ranged_(ranged),
+    eof_(false),
+    retries_(0),
+    weak_factory_(this)
+  {
+  }
+
+  void Start() {
+    request_ = job_->context()->CreateRequest(
+        job_->url(), net::DEFAULT_PRIORITY, this, NULL);
+    request_->SetLoadFlags(net::LOAD_DISABLE_CACHE);
+    if(ranged_) {
+      request_->SetExtraRequestHeaderByName(
+          net::HttpRequestHeaders::kRange,
+          "bytes=" + base::Int64ToString(start_ + received_) + "-" +
+            base::Int64ToString(end_),
+          true);
+      /* Answered with the whole resource (200) if it has changed. */
+      if(!job_->validator().empty()) {
+        request_->SetExtraRequestHeaderByName(
+            net::HttpRequestHeaders::kIfRange, job_->validator(), true);
+      }
+    }
+    else {
+      received_ = 0;
+    }
+    request_->Start();
+  }
+
+  void Cancel() {
+    request_.reset();
+    retry_timer_.Stop();
+    weak_factory_.InvalidateWeakPtrs();
+  }
+
+  bool complete() const {
+    return ranged_ ? start_ + received_ > end_ : eof_;
+  }
+  int64 start() const { return start_; }
+  int64 end() const { return end_; }
+  int64 received() const { return received_; }
+
+  /****************************************************************************/
+  /* URLREQUEST::DELEGATE IMPLEMENTATION                                      */
+  /****************************************************************************/
+  virtual void OnResponseStarted(net::URLRequest* request) OVERRIDE {
+    if(!request->status().is_success()) {
+      Retry(net::ErrorToString(request->status().error()));
+      return;
+    }
+    int code = request->GetResponseCode();
+    if(code >= 500) {
+      Retry("http_error_" + base::IntToString(code));
+      return;
+    }
+    if(ranged_ && code == 200) {
+      job_->OnSegmentFailed(this, "remote_changed");
+      return;
+    }
+    if(code != (ranged_ ? 206 : 200)) {
+      job_->OnSegmentFailed(this, "http_error_" + base::IntToString(code));
+      return;
+    }
+    ReadMore();
+  }
+
+  virtual void OnReadCompleted(net::URLRequest* request, 
+                               int bytes_read) OVERRIDE {
+    if(bytes_read < 0 || !request->status().is_success()) {
+      Retry(net::ErrorToString(request->status().error()));
+      return;
+    }
+    OnData(bytes_read);
+  }
+
+private:
+  void ReadMore() {
+    if(!buffer_.get())
+      buffer_ = new net::IOBuffer(kReadBufferSize);
+    int bytes_read = 0;
+    if(request_->Read(buffer_.get(), kReadBufferSize, &bytes_read)) {
+      OnData(bytes_read);
+      return;
+    }
+    if(request_->status().is_io_pending())
+      return;
+    Retry(net::ErrorToString(request_->status().error()));
+  }
+
+  void OnData(int bytes_read) {
+    if(bytes_read == 0) {
+      request_.reset();
+      if(ranged_) {
+        /* Complete ranges are detected as they are written. */
+        Retry("connection_closed");
+        return;
+      }
+      eof_ = true;
+      job_->OnSegmentComplete(this);
+      return;
+    }
+    int size = bytes_read;
+    if(ranged_) {
+      size = std::min<int64>(size, end_ - (start_ + received_) + 1);
+    }
+    /* The next read is issued once this chunk is written, which also */
+    /* keeps the buffer untouched in the meantime.                    */
+    base::PostTaskAndReplyWithResult(
+        job_->file_runner(), FROM_HERE,
+        base::Bind(&File::Write, job_->file(), 
+                   start_ + received_, buffer_, size),
+        base::Bind(&Segment::OnWritten, weak_factory_.GetWeakPtr(), size));
+  }
+
+  void OnWritten(int size, bool ok) {
+    if(!ok) {
+      job_->OnSegmentFailed(this, "file_error");
+      return;
+    }
+    received_ += size;
+    /* Only consecutive failures without progress count as retries. */
+    retries_ = 0;
+    if(complete()) {
+      request_.reset();
+      job_->OnSegmentComplete(this);
+      return;
+    }
+    ReadMore();
+  }
+
+  void Retry(const std::string& error) {
+    request_.reset();
+    /* A non ranged segment can't be resumed. */
+    if(!ranged_ || ++retries_ > kMaxSegmentRetries) {
+      job_->OnSegmentFailed(this, error);
+      return;
+    }
+    LOG(WARNING) << "Download segment " << start_ << "-" << end_ 
+                 << " retrying: " << error;
+    retry_timer_.Start(FROM_HERE,
+                       base::TimeDelta::FromMilliseconds(
+                           kRetryDelayMs * retries_),
+                       this,
+                       &Segment::Start);
+  }
+
+  Job*                                 job_;
+  const int64                          start_;
+  const int64                          end_;
+  int64                                received_;
+  const bool                           ranged_;
+  bool                                 eof_;
+  int                                  retries_;
+  scoped_ptr<net::URLRequest>          request_;
+  scoped_refptr<net::IOBuffer>         buffer_;
+  base::OneShotTimer<Segment>          retry_timer_;
+
+  base::WeakPtrFactory<Segment>        weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(Segment);
+};
+
+/******************************************************************************/
+/* JOB IMPLEMENTATION */
+/******************************************************************************/
+
+ThrustShellParallelDownloader::Job::Job(
+    ThrustShellParallelDownloader* downloader,
+    int id,
+    const GURL& url,
+    const base::FilePath& path,
+    const Options& options,
+    const EventCallback& callback)
+: downloader_(downloader),
+  id_(id),
+  url_(url),
+  path_(path),
+  options_(options),
+  callback_(callback),
+  file_(new File(path)),
+  ranged_(false),
+  total_(-1),
+  opened_(false),
+  finished_(false),
+  last_received_(0),
+  weak_factory_(this)
+{
+}
+
+ThrustShellParallelDownloader::Job::~Job()
+{
+  /* Interrupted by the destruction of the context: kept resumable. */
+  if(!finished_) {
+    CancelSegments();
+    if(opened_ && ranged_) {
+      file_runner()->PostTask(
+          FROM_HERE, base::Bind(&File::SaveState, file_, SerializeState()));
+    }
+    file_runner()->PostTask(FROM_HERE, base::Bind(&File::Close, file_));
+  }
+}
+
+void
+ThrustShellParallelDownloader::Job::Start()
+{
+  base::PostTaskAndReplyWithResult(
+      file_runner(), FROM_HERE,
+      base::Bind(&File::LoadState, file_),
+      base::Bind(&Job::OnStateLoaded, weak_factory_.GetWeakPtr()));
+}
+
+void
+ThrustShellParallelDownloader::Job::OnStateLoaded(
+    scoped_ptr<base::DictionaryValue> state)
+{
+  saved_state_ = state.Pass();
+
+  /* Retrieves the size and validators of the resource. */
+  probe_ = context()->CreateRequest(url_, net::DEFAULT_PRIORITY, this, NULL);
+  probe_->SetLoadFlags(net::LOAD_DISABLE_CACHE);
+  probe_->SetExtraRequestHeaderByName(net::HttpRequestHeaders::kRange,
+                                      "bytes=0-0", true);
+  probe_->Start();
+}
+
+void
+ThrustShellParallelDownloader::Job::OnResponseStarted(
+    net::URLRequest* request)
+{
+  if(!request->status().is_success()) {
+    Interrupt("download_error", 
+              net::ErrorToString(request->status().error()));
+    return;
+  }
+
+  int code = request->GetResponseCode();
+  net::HttpResponseHeaders* headers = request->response_headers();
+  int64 first = 0;
+  int64 last = 0;
+  int64 length = 0;
+  if(code == 206 && headers &&
+     headers->GetContentRange(&first, &last, &length) && length > 0) {
+    total_ = length;
+    headers->EnumerateHeader(NULL, "ETag", &etag_);
+    headers->EnumerateHeader(NULL, "Last-Modified", &last_modified_);
+    /* Weak ETags can't be used for range requests. */
+    if(!etag_.empty() && !StartsWithASCII(etag_, "W/", true))
+      validator_ = etag_;
+    else
+      validator_ = last_modified_;
+    /* Without a validator, ranges of a resource that changed meanwhile  */
+    /* would be spliced silently: it is downloaded over a single plain   */
+    /* request and is not resumable.                                     */
+    ranged_ = !validator_.empty();
+  }
+  else if(code == 200) {
+    ranged_ = false;
+    total_ = request->GetExpectedContentSize();
+  }
+  else if(code == 206) {
+    /* Ranges are supported but the total size is unknown (`bytes 0-0/*`): */
+    /* the resource can't be split and is downloaded over a single plain  */
+    /* request.                                                            */
+    ranged_ = false;
+    total_ = -1;
+  }
+  else {
+    Interrupt("download_error", "http_error_" + base::IntToString(code));
+    return;
+  }
+  probe_.reset();
+
+  bool resume = ranged_ && saved_state_ && RestoreSegments(*saved_state_);
+  if(!resume)
+    CreateSegments();
+  saved_state_.reset();
+
+  base::PostTaskAndReplyWithResult(
+      file_runner(), FROM_HERE,
+      base::Bind(&File::Open, file_, ranged_ ? total_ : -1, !resume),
+      base::Bind(&Job::OnFileOpened, weak_factory_.GetWeakPtr()));
+}
+
+void
+ThrustShellParallelDownloader::Job::OnReadCompleted(
+    net::URLRequest* request,
+    int bytes_read)
+{
+  /* The probe is cancelled as soon as its headers are received. */
+  NOTREACHED();
+}
+
+bool
+ThrustShellParallelDownloader::Job::RestoreSegments(
+    const base::DictionaryValue& state)
+{
+  std::string url;
+  std::string etag;
+  std::string last_modified;
+  double total = 0;
+  const base::ListValue* list = NULL;
+  if(!state.GetString("url", &url) || url != url_.spec() ||
+     !state.GetDouble("total", &total) || total != total_ ||
+     !state.GetString("etag", &etag) || etag != etag_ ||
+     !state.GetString("last_modified", &last_modified) || 
+     last_modified != last_modified_ ||
+     !state.GetList("segments", &list)) {
+    return false;
+  }
+  for(size_t i = 0; i < list->GetSize(); ++i) {
+    const base::DictionaryValue* segment = NULL;
+    double start = 0;
+    double end = 0;
+    double received = 0;
+    if(!list->GetDictionary(i, &segment) ||
+       !segment->GetDouble("start", &start) ||
+       !segment->GetDouble("end", &end) ||
+       !segment->GetDouble("received", &received) ||
+       start < 0 || end < start || end >= total_ ||
+       received < 0 || received > end - start + 1) {
+      segments_.clear();
+      return false;
+    }
+    segments_.push_back(new Segment(this, start, end, received, true));
+  }
+  return !segments_.empty();
+}
+
+void
+ThrustShellParallelDownloader::Job::CreateSegments()
+{
+  if(!ranged_) {
+    segments_.push_back(new Segment(this, 0, -1, 0, false));
+    return;
+  }
+  int64 count = std::max<int64>(1, std::min<int64>(
+      options_.connections, total_ / options_.min_segment_size));
+  int64 size = total_ / count;
+  for(int64 i = 0; i < count; ++i) {
+    int64 start = i * size;
+    int64 end = (i == count - 1) ? total_ - 1 : start + size - 1;
+    segments_.push_back(new Segment(this, start, end, 0, true));
+  }
+}
+
+void
+ThrustShellParallelDownloader::Job::OnFileOpened(
+    bool ok)
+{
+  if(!ok) {
+    Interrupt("download_error", "file_error");
+    return;
+  }
+  opened_ = true;
+  start_time_ = base::TimeTicks::Now();
+  last_received_ = Received();
+  progress_timer_.Start(FROM_HERE,
+                        base::TimeDelta::FromMilliseconds(kProgressIntervalMs),
+                        this,
+                        &Job::ProgressTick);
+
+  bool complete = true;
+  for(size_t i = 0; i < segments_.size(); ++i) {
+    if(!segments_[i]->complete()) {
+      complete = false;
+      segments_[i]->Start();
+    }
+  }
+  /* Resumed downloads may already be complete. */
+  if(complete && !segments_.empty())
+    OnSegmentComplete(segments_[0]);
+}
+
+void
+ThrustShellParallelDownloader::Job::OnSegmentComplete(
+    Segment* segment)
+{
+  for(size_t i = 0; i < segments_.size(); ++i) {
+    if(!segments_[i]->complete())
+      return;
+  }
+  progress_timer_.Stop();
+  base::PostTaskAndReply(
+      file_runner(), FROM_HERE,
+      base::Bind(&File::Complete, file_),
+      base::Bind(&Job::OnCompleted, weak_factory_.GetWeakPtr()));
+}
+
+void
+ThrustShellParallelDownloader::Job::OnCompleted()
+{
+  scoped_ptr<base::DictionaryValue> event(new base::DictionaryValue);
+  event->SetString("path", path_.AsUTF8Unsafe());
+  event->SetDouble("total", Received());
+  event->SetDouble("duration", 
+                   (base::TimeTicks::Now() - start_time_).InMillisecondsF());
+  Finish("download_complete", event.Pass());
+}
+
+void
+ThrustShellParallelDownloader::Job::OnSegmentFailed(
+    Segment* segment,
+    const std::string& error)
+{
+  Interrupt("download_error", error);
+}
+
+void
+ThrustShellParallelDownloader::Job::Cancel()
+{
+  Interrupt("download_cancelled", std::string());
+}
+
+std::string
+ThrustShellParallelDownloader::Job::SerializeState()
+{
+  base::DictionaryValue state;
+  state.SetString("url", url_.spec());
+  state.SetDouble("total", total_);
+  state.SetString("etag", etag_);
+  state.SetString("last_modified", last_modified_);
+  base::ListValue* list = new base::ListValue;
+  for(size_t i = 0; i < segments_.size(); ++i) {
+    base::DictionaryValue* segment = new base::DictionaryValue;
+    segment->SetDouble("start", segments_[i]->start());
+    segment->SetDouble("end", segments_[i]->end());
+    segment->SetDouble("received", segments_[i]->received());
+    list->Append(segment);
+  }
+  state.Set("segments", list);
+  std::string data;
+  base::JSONWriter::Write(&state, &data);
+  return data;
+}
+
+int64
+ThrustShellParallelDownloader::Job::Received()
+{
+  int64 received = 0;
+  for(size_t i = 0; i < segments_.size(); ++i)
+    received += segments_[i]->received();
+  return received;
+}
+
+void
+ThrustShellParallelDownloader::Job::ProgressTick()
+{
+  int64 received = Received();
+  if(received == last_received_)
+    return;
+
+  scoped_ptr<base::DictionaryValue> event(new base::DictionaryValue);
+  event->SetInteger("id", id_);
+  event->SetDouble("received", received);
+  event->SetDouble("total", total_);
+  event->SetDouble("speed", (received - last_received_) * 1000.0 / 
+                              kProgressIntervalMs);
+  last_received_ = received;
+  callback_.Run("download_progress", event.Pass());
+
+  /* Checkpoints the progress for resumption. */
+  if(ranged_) {
+    file_runner()->PostTask(
+        FROM_HERE, base::Bind(&File::SaveState, file_, SerializeState()));
+  }
+}
+
+void
+ThrustShellParallelDownloader::Job::CancelSegments()
+{
+  probe_.reset();
+  for(size_t i = 0; i < segments_.size(); ++i)
+    segments_[i]->Cancel();
+}
+
+void
+ThrustShellParallelDownloader::Job::Interrupt(
+    const std::string& type,
+    const std::string& error)
+{
+  CancelSegments();
+  progress_timer_.Stop();
+  if(opened_) {
+    if(ranged_) {
+      file_runner()->PostTask(
+          FROM_HERE, base::Bind(&File::SaveState, file_, SerializeState()));
+    }
+    file_runner()->PostTask(FROM_HERE, base::Bind(&File::Close, file_));
+  }
+
+  scoped_ptr<base::DictionaryValue> event(new base::DictionaryValue);
+  if(!error.empty())
+    event->SetString("error", error);
+  event->SetDouble("received", Received());
+  event->SetDouble("total", total_);
+  event->SetBoolean("resumable", opened_ && ranged_);
+  Finish(type, event.Pass());
+}
+
+void
+ThrustShellParallelDownloader::Job::Finish(
+    const std::string& type,
+    scoped_ptr<base::DictionaryValue> event)
+{
+  finished_ = true;
+  weak_factory_.InvalidateWeakPtrs();
+  event->SetInteger("id", id_);
+  callback_.Run(type, event.Pass());
+  /* Deletes this job asynchronously. */
+  downloader_->OnJobDone(id_);
+}
+
+/******************************************************************************/
+/* PARALLEL DOWNLOADER */
+/******************************************************************************/
+
+ThrustShellParallelDownloader::Options::Options()
+: connections(kDefaultConnections),
+  min_segment_size(kDefaultMinSegmentSize)
+{
+}
+
+ThrustShellParallelDownloader::ThrustShellParallelDownloader(
+    net::URLRequestContext* context)
+: context_(context)
+{
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  file_runner_ = pool->GetSequencedTaskRunnerWithShutdownBehavior(
+      pool->GetSequenceToken(), 
+      base::SequencedWorkerPool::BLOCK_SHUTDOWN);
+}
+
+ThrustShellParallelDownloader::~ThrustShellParallelDownloader()
+{
+  STLDeleteValues(&jobs_);
+}
+
+void
+ThrustShellParallelDownloader::Start(
+    int id,
+    const GURL& url,
+    const base::FilePath& path,
+    const Options& options,
+    const EventCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(jobs_.find(id) != jobs_.end())
+    return;
+
+  Options sanitized = options;
+  sanitized.connections = 
+    std::max(1, std::min(sanitized.connections, kMaxConnections));
+  sanitized.min_segment_size = 
+    std::max<int64>(kReadBufferSize, sanitized.min_segment_size);
+
+  Job* job = new Job(this, id, url, path, sanitized, callback);
+  jobs_[id] = job;
+  job->Start();
+}
+
+void
+ThrustShellParallelDownloader::Cancel(
+    int id)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  std::map<int, Job*>::iterator it = jobs_.find(id);
+  if(it != jobs_.end())
+    it->second->Cancel();
+}
+
+void
+ThrustShellParallelDownloader::OnJobDone(
+    int id)
+{
+  std::map<int, Job*>::iterator it = jobs_.find(id);
+  DCHECK(it != jobs_.end());
+  Job* job = it->second;
+  jobs_.erase(it);
+  /* Jobs finish from their own (or their segments') callbacks. */
+  base::MessageLoop::current()->DeleteSoon(FROM_HERE, job);
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,107 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_PARALLEL_DOWNLOAD_H_
+#define THRUST_SHELL_NET_PARALLEL_DOWNLOAD_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+
+class GURL;
+
+namespace base {
+class DictionaryValue;
+class SequencedTaskRunner;
+}
+
+namespace net {
+class URLRequestContext;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellParallelDownloader
+//
+// Downloads large files over several concurrent HTTP range requests:
+// - A first `Range: bytes=0-0` request retrieves the size and validators
+//   (ETag, Last-Modified) of the resource. Servers not supporting ranges,
+//   not reporting the total size (`bytes 0-0/*`) or sending neither a strong
+//   ETag nor Last-Modified are downloaded over a single plain request, which
+//   is not resumable.
+// - The target file is preallocated (sparse where supported) and split in
+//   up to `connections` segments, each written in place at its offset as
+//   data is received. Writes happen on a background sequence, the next read
+//   of a segment being issued once its previous chunk is written.
+// - Segment progress is checkpointed in a `<path>.tdownload` state file.
+//   Failed segments are retried with a backoff (the count is reset as soon
+//   as data is received); if the download is interrupted (error,
+//   cancellation, restart), starting it again with the same URL and path
+//   resumes the missing ranges (validated with If-Range). The state is
+//   discarded if the target file is missing or was truncated.
+//
+// Events (`download_progress` throttled to 2 per second, `download_complete`,
+// `download_error`, `download_cancelled`) are reported through the callback
+// passed to Start.
+//
+// Lives on the IO thread, owned by the URLRequestContextGetter and destroyed
+// before the context (in-flight downloads are interrupted and resumable).
+class ThrustShellParallelDownloader {
+public:
+  // Called on the IO thread.
+  typedef base::Callback<void(const std::string& type, 
+                              scoped_ptr<base::DictionaryValue> event)>
+    EventCallback;
+
+  struct Options {
+    Options();
+
+    int                    connections;
+    int64                  min_segment_size;
+  };
+
+  explicit ThrustShellParallelDownloader(net::URLRequestContext* context);
+  ~ThrustShellParallelDownloader();
+
+  // ### Start
+  // ```
+  // @id       {int} the download id, reported in all events
+  // @url      {GURL} the http(s) URL to download
+  // @path     {FilePath} the target file
+  // @options  {Options} the download options
+  // @callback {EventCallback} the event callback
+  // ```
+  void Start(int id,
+             const GURL& url,
+             const base::FilePath& path,
+             const Options& options,
+             const EventCallback& callback);
+  // ### Cancel
+  // Interrupts the download `id`, keeping its state for a later resume.
+  void Cancel(int id);
+
+private:
+  class File;
+  class Job;
+  class Segment;
+
+  void OnJobDone(int id);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  net::URLRequestContext*                    context_;
+  scoped_refptr<base::SequencedTaskRunner>   file_runner_;
+  std::map<int, Job*>                        jobs_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellParallelDownloader);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_PARALLEL_DOWNLOAD_H_
@@ -0,0 +1,129 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/preconnector.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_stream_factory.h"
+#include "net/http/http_transaction_factory.h"
+#include "net/ssl/ssl_config_service.h"
+#include "net/url_request/http_user_agent_settings.h"
+#include "net/url_request/url_request_context.h"
+#include "url/gurl.h"
+
+namespace thrust_shell {
+
+namespace {
+
+/* Socket pools do not keep more sockets per group than this anyway. */
+const int kMaxPreconnectCount = 6;
+/* Bounds the speculative load a controller can put on the resolver. */
+const size_t kMaxPendingResolutions = 64;
+
+}
+
+ThrustShellPreconnector::ThrustShellPreconnector(
+    net::URLRequestContext* context)
+: context_(context)
+{
+}
+
+ThrustShellPreconnector::~ThrustShellPreconnector()
+{
+  for(std::map<std::string, Resolution*>::iterator it = pending_.begin();
+      it != pending_.end(); ++it) {
+    context_->host_resolver()->CancelRequest(it->second->handle);
+  }
+  STLDeleteValues(&pending_);
+}
+
+void
+ThrustShellPreconnector::Preconnect(
+    const GURL& url,
+    int count)
+{
+  if(!url.is_valid() || !url.SchemeIsHTTPOrHTTPS())
+    return;
+
+  net::HttpTransactionFactory* factory = context_->http_transaction_factory();
+  if(!factory || !factory->GetSession())
+    return;
+  net::HttpNetworkSession* session = factory->GetSession();
+
+  net::HttpRequestInfo request_info;
+  request_info.url = url;
+  request_info.method = "GET";
+  if(context_->http_user_agent_settings()) {
+    request_info.extra_headers.SetHeader(
+        net::HttpRequestHeaders::kUserAgent,
+        context_->http_user_agent_settings()->GetUserAgent());
+  }
+  request_info.load_flags = 0;
+
+  net::SSLConfig ssl_config;
+  session->ssl_config_service()->GetSSLConfig(&ssl_config);
+
+  count = std::max(1, std::min(count, kMaxPreconnectCount));
+  session->http_stream_factory()->PreconnectStreams(
+      count, request_info, net::DEFAULT_PRIORITY, ssl_config, ssl_config);
+}
+
+size_t
+ThrustShellPreconnector::PrefetchDNS(
+    const std::vector<std::string>& hosts)
+{
+  size_t started = 0;
+  for(size_t i = 0; i < hosts.size(); ++i) {
+    const std::string& host = hosts[i];
+    if(host.empty() || pending_.find(host) != pending_.end())
+      continue;
+    if(pending_.size() >= kMaxPendingResolutions)
+      break;
+
+    /* The port is irrelevant to the host cache. */
+    net::HostResolver::RequestInfo info(net::HostPortPair(host, 80));
+    info.set_is_speculative(true);
+
+    Resolution* resolution = new Resolution;
+    int rv = context_->host_resolver()->Resolve(
+        info,
+        net::IDLE,
+        &resolution->addresses,
+        base::Bind(&ThrustShellPreconnector::OnResolutionComplete,
+                   base::Unretained(this), host),
+        &resolution->handle,
+        net::BoundNetLog());
+    if(rv == net::ERR_IO_PENDING) {
+      pending_[host] = resolution;
+      started++;
+    }
+    else {
+      /* Resolved synchronously (cached or IP literal), nothing started. */
+      delete resolution;
+    }
+  }
+  return started;
+}
+
+void
+ThrustShellPreconnector::OnResolutionComplete(
+    const std::string& host,
+    int result)
+{
+  std::map<std::string, Resolution*>::iterator it = pending_.find(host);
+  DCHECK(it != pending_.end());
+  delete it->second;
+  pending_.erase(it);
+}
+
+} // namespace thrust_shell
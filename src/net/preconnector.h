@@ -0,0 +1,75 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_PRECONNECTOR_H_
+#define THRUST_SHELL_NET_PRECONNECTOR_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "net/base/address_list.h"
+#include "net/dns/host_resolver.h"
+
+class GURL;
+
+namespace net {
+class URLRequestContext;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellPreconnector
+//
+// Warms up the network stack of a session ahead of navigations the
+// controller anticipates (link hover, omnibox...):
+// - PrefetchDNS speculatively resolves hosts so that their addresses are in
+//   the host cache when the first request is issued.
+// - Preconnect opens (and for https handshakes) sockets in the socket pools
+//   of the HttpNetworkSession, which the first requests to the origin pick
+//   up.
+//
+// Lives on the IO thread, owned by the URLRequestContextGetter and destroyed
+// before the context (pending resolutions are cancelled).
+class ThrustShellPreconnector {
+public:
+  explicit ThrustShellPreconnector(net::URLRequestContext* context);
+  ~ThrustShellPreconnector();
+
+  // ### Preconnect
+  // ```
+  // @url   {GURL} the http(s) URL whose origin to connect to
+  // @count {int} the number of sockets to open (clamped to [1, 6])
+  // ```
+  void Preconnect(const GURL& url, int count);
+
+  // ### PrefetchDNS
+  // Returns the number of resolutions actually started (hosts already being
+  // resolved or beyond the pending limit are skipped, hosts resolved
+  // synchronously from the cache are not counted).
+  // ```
+  // @hosts {vector<string>} the hosts to resolve
+  // ```
+  size_t PrefetchDNS(const std::vector<std::string>& hosts);
+
+private:
+  struct Resolution {
+    net::AddressList                     addresses;
+    net::HostResolver::RequestHandle     handle;
+  };
+
+  void OnResolutionComplete(const std::string& host, int result);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  net::URLRequestContext*                  context_;
+  std::map<std::string, Resolution*>       pending_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellPreconnector);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_PRECONNECTOR_H_
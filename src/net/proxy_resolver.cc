@@ -0,0 +1,179 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/proxy_resolver.h"
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/values.h"
+#include "net/base/net_errors.h"
+#include "url/gurl.h"
+
+namespace thrust_shell {
+
+namespace {
+
+/* Bounds the memory used by the cache, the least recently used entry being */
+/* evicted once reached.                                                    */
+const size_t kMaxCacheEntries = 1000;
+
+std::string
+CacheKeyForURL(
+    const GURL& url)
+{
+  return url.scheme() + "://" + url.host() + ":" + url.port();
+}
+
+}
+
+ThrustShellProxyResolver::Stats::Stats()
+: requests(0),
+  cache_hits(0),
+  evaluations(0),
+  failures(0)
+{
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellProxyResolver::Stats::ToValue() const
+{
+  scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  value->SetDouble("requests", requests);
+  value->SetDouble("cache_hits", cache_hits);
+  value->SetDouble("hit_rate", 
+                   requests ? static_cast<double>(cache_hits) / requests : 0);
+  value->SetDouble("evaluations", evaluations);
+  value->SetDouble("failures", failures);
+  value->SetDouble("mean_time", evaluations ? 
+                   total_time.InMillisecondsF() / evaluations : 0);
+  value->SetDouble("max_time", max_time.InMillisecondsF());
+  return value.Pass();
+}
+
+ThrustShellProxyResolver::ThrustShellProxyResolver(
+    net::ProxyResolver* resolver)
+: net::ProxyResolver(resolver->expects_pac_bytes()),
+  resolver_(resolver),
+  cache_(kMaxCacheEntries)
+{
+}
+
+ThrustShellProxyResolver::~ThrustShellProxyResolver()
+{
+}
+
+void
+ThrustShellProxyResolver::set_cache_ttl(
+    base::TimeDelta cache_ttl)
+{
+  cache_ttl_ = cache_ttl;
+  cache_.Clear();
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellProxyResolver::GetStats(
+    bool reset)
+{
+  scoped_ptr<base::DictionaryValue> value = stats_.ToValue();
+  value->SetInteger("cache_ttl", cache_ttl_.InSeconds());
+  value->SetInteger("cache_entries", cache_.size());
+  if(reset)
+    stats_ = Stats();
+  return value.Pass();
+}
+
+int
+ThrustShellProxyResolver::GetProxyForURL(
+    const GURL& url,
+    net::ProxyInfo* results,
+    const net::CompletionCallback& callback,
+    RequestHandle* request,
+    const net::BoundNetLog& net_log)
+{
+  stats_.requests++;
+  std::string key = CacheKeyForURL(url);
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  Cache::iterator it = cache_.Get(key);
+  if(it != cache_.end()) {
+    if(it->second.expiry > now) {
+      stats_.cache_hits++;
+      results->Use(it->second.info);
+      return net::OK;
+    }
+    cache_.Erase(it);
+  }
+
+  /* The wrapped resolver is owned by this object and drops its callbacks */
+  /* when destroyed.                                                      */
+  int rv = resolver_->GetProxyForURL(
+      url, results,
+      base::Bind(&ThrustShellProxyResolver::OnGetProxyForURLComplete,
+                 base::Unretained(this), key, results, now, callback),
+      request, net_log);
+  if(rv != net::ERR_IO_PENDING)
+    OnGetProxyForURLComplete(key, results, now, net::CompletionCallback(), rv);
+  return rv;
+}
+
+void
+ThrustShellProxyResolver::OnGetProxyForURLComplete(
+    const std::string& key,
+    net::ProxyInfo* results,
+    base::TimeTicks start_time,
+    const net::CompletionCallback& callback,
+    int result)
+{
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeDelta time = now - start_time;
+  stats_.evaluations++;
+  stats_.total_time += time;
+  stats_.max_time = std::max(stats_.max_time, time);
+
+  if(result != net::OK) {
+    stats_.failures++;
+  }
+  else if(cache_ttl_ > base::TimeDelta()) {
+    Entry entry;
+    entry.info.Use(*results);
+    entry.expiry = now + cache_ttl_;
+    /* Evicts the least recently used entry if the cache is full. */
+    cache_.Put(key, entry);
+  }
+
+  if(!callback.is_null())
+    callback.Run(result);
+}
+
+void
+ThrustShellProxyResolver::CancelRequest(
+    RequestHandle request)
+{
+  resolver_->CancelRequest(request);
+}
+
+net::LoadState
+ThrustShellProxyResolver::GetLoadState(
+    RequestHandle request) const
+{
+  return resolver_->GetLoadState(request);
+}
+
+void
+ThrustShellProxyResolver::CancelSetPacScript()
+{
+  resolver_->CancelSetPacScript();
+}
+
+int
+ThrustShellProxyResolver::SetPacScript(
+    const scoped_refptr<net::ProxyResolverScriptData>& script_data,
+    const net::CompletionCallback& callback)
+{
+  /* Results of the previous script are stale. */
+  cache_.Clear();
+  return resolver_->SetPacScript(script_data, callback);
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,106 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_PROXY_RESOLVER_H_
+#define THRUST_SHELL_NET_PROXY_RESOLVER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
+#include "net/proxy/proxy_info.h"
+#include "net/proxy/proxy_resolver.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellProxyResolver
+//
+// Memoizing ProxyResolver used by the session ProxyService when the proxy
+// configuration is a PAC script. PAC evaluations are delegated to the
+// wrapped resolver (ProxyResolverV8Tracing, which runs the script on its own
+// thread) and their results are cached per scheme and host for `cache_ttl`.
+// The cache is bounded, the least recently used host being evicted when
+// full, and flushed whenever a new script is set. Evaluation counts and
+// times are recorded and exposed through GetStats.
+//
+// Note that a PAC script may return different proxies for different paths
+// of the same host: this is not honored once a result is cached.
+//
+// Lives on the IO thread, owned by the ProxyService.
+class ThrustShellProxyResolver : public net::ProxyResolver {
+public:
+  struct Stats {
+    Stats();
+
+    scoped_ptr<base::DictionaryValue> ToValue() const;
+
+    uint64                        requests;
+    uint64                        cache_hits;
+    uint64                        evaluations;
+    uint64                        failures;
+    base::TimeDelta               total_time;
+    base::TimeDelta               max_time;
+  };
+
+  // ### ThrustShellProxyResolver
+  // Takes ownership of `resolver`.
+  explicit ThrustShellProxyResolver(net::ProxyResolver* resolver);
+  virtual ~ThrustShellProxyResolver();
+
+  // ### set_cache_ttl
+  // A null TTL disables the cache.
+  void set_cache_ttl(base::TimeDelta cache_ttl);
+  // ### GetStats
+  // ```
+  // @reset {bool} whether to reset the statistics once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetStats(bool reset);
+
+  /****************************************************************************/
+  /* PROXYRESOLVER IMPLEMENTATION                                             */
+  /****************************************************************************/
+  virtual int GetProxyForURL(const GURL& url,
+                             net::ProxyInfo* results,
+                             const net::CompletionCallback& callback,
+                             RequestHandle* request,
+                             const net::BoundNetLog& net_log) OVERRIDE;
+  virtual void CancelRequest(RequestHandle request) OVERRIDE;
+  virtual net::LoadState GetLoadState(RequestHandle request) const OVERRIDE;
+  virtual void CancelSetPacScript() OVERRIDE;
+  virtual int SetPacScript(
+      const scoped_refptr<net::ProxyResolverScriptData>& script_data,
+      const net::CompletionCallback& callback) OVERRIDE;
+
+private:
+  struct Entry {
+    net::ProxyInfo                info;
+    base::TimeTicks               expiry;
+  };
+  typedef base::MRUCache<std::string, Entry> Cache;
+
+  void OnGetProxyForURLComplete(const std::string& key,
+                                net::ProxyInfo* results,
+                                base::TimeTicks start_time,
+                                const net::CompletionCallback& callback,
+                                int result);
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  scoped_ptr<net::ProxyResolver>       resolver_;
+  base::TimeDelta                      cache_ttl_;
+  Cache                                cache_;
+  Stats                                stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellProxyResolver);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_PROXY_RESOLVER_H_
@@ -0,0 +1,267 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/request_scheduler.h"
+
+#include <algorithm>
+
+#include "content/public/browser/resource_controller.h"
+#include "content/public/browser/resource_throttle.h"
+#include "net/base/request_priority.h"
+#include "net/url_request/url_request.h"
+
+using namespace content;
+
+namespace thrust_shell {
+
+namespace {
+
+/* Background non critical requests allowed in flight when no foreground */
+/* request is.                                                            */
+const size_t kMaxBackgroundInFlight = 4;
+/* Background requests are never delayed more than this. */
+const int kMaxDeferralMs = 3000;
+
+bool
+IsCritical(
+    ResourceType::Type resource_type)
+{
+  switch(resource_type) {
+    case ResourceType::MAIN_FRAME:
+    case ResourceType::SUB_FRAME:
+    case ResourceType::STYLESHEET:
+    case ResourceType::SCRIPT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}
+
+/******************************************************************************/
+/* THROTTLE */
+/******************************************************************************/
+
+class ThrustShellRequestScheduler::Throttle : public ResourceThrottle {
+public:
+  Throttle(ThrustShellRequestScheduler* scheduler,
+           net::URLRequest* request,
+           const ClientId& client,
+           bool foreground)
+  : scheduler_(scheduler),
+    request_(request),
+    client_(client),
+    foreground_(foreground),
+    started_(false),
+    deferred_(false)
+  {
+  }
+
+  virtual ~Throttle() {
+    scheduler_->OnThrottleDestroyed(this);
+  }
+
+  virtual void WillStartRequest(bool* defer) OVERRIDE {
+    if(scheduler_->ShouldDefer(this)) {
+      deferred_ = true;
+      deferred_time_ = base::TimeTicks::Now();
+      *defer = true;
+      return;
+    }
+    scheduler_->OnThrottleStarted(this);
+  }
+
+  virtual const char* GetNameForLogging() const OVERRIDE {
+    return "ThrustShellRequestScheduler";
+  }
+
+  void Resume() {
+    deferred_ = false;
+    scheduler_->OnThrottleStarted(this);
+    controller()->Resume();
+  }
+
+  net::URLRequest* request() const { return request_; }
+  const ClientId& client() const { return client_; }
+  bool foreground() const { return foreground_; }
+  bool started() const { return started_; }
+  void set_started() { started_ = true; }
+  bool deferred() const { return deferred_; }
+  base::TimeTicks deferred_time() const { return deferred_time_; }
+
+private:
+  ThrustShellRequestScheduler*   scheduler_;
+  net::URLRequest*               request_;
+  const ClientId                 client_;
+  const bool                     foreground_;
+  bool                           started_;
+  bool                           deferred_;
+  base::TimeTicks                deferred_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(Throttle);
+};
+
+/******************************************************************************/
+/* REQUEST SCHEDULER */
+/******************************************************************************/
+
+ThrustShellRequestScheduler::ThrustShellRequestScheduler()
+: foreground_in_flight_(0),
+  background_in_flight_(0)
+{
+}
+
+ThrustShellRequestScheduler::~ThrustShellRequestScheduler()
+{
+  /* Requests (and their throttles) are destroyed before their context. */
+  DCHECK(deferred_.empty());
+}
+
+void
+ThrustShellRequestScheduler::SetPriorityClass(
+    int child_id,
+    int route_id,
+    PriorityClass priority_class)
+{
+  ClientId client(child_id, route_id);
+  classes_[client] = priority_class;
+  if(priority_class == PRIORITY_CLASS_BACKGROUND)
+    return;
+
+  /* Requests deferred while the client was in background are released. */
+  std::deque<Throttle*> deferred;
+  deferred.swap(deferred_);
+  for(size_t i = 0; i < deferred.size(); ++i) {
+    if(deferred[i]->client() == client)
+      deferred[i]->Resume();
+    else
+      deferred_.push_back(deferred[i]);
+  }
+}
+
+void
+ThrustShellRequestScheduler::RemoveClient(
+    int child_id,
+    int route_id)
+{
+  classes_.erase(ClientId(child_id, route_id));
+}
+
+ThrustShellRequestScheduler::PriorityClass
+ThrustShellRequestScheduler::GetPriorityClass(
+    const ClientId& client) const
+{
+  std::map<ClientId, PriorityClass>::const_iterator it = classes_.find(client);
+  if(it == classes_.end())
+    return PRIORITY_CLASS_NORMAL;
+  return it->second;
+}
+
+ResourceThrottle*
+ThrustShellRequestScheduler::MaybeCreateThrottle(
+    net::URLRequest* request,
+    ResourceType::Type resource_type,
+    int child_id,
+    int route_id)
+{
+  ClientId client(child_id, route_id);
+  switch(GetPriorityClass(client)) {
+    case PRIORITY_CLASS_FOREGROUND: {
+      request->SetPriority(static_cast<net::RequestPriority>(
+          std::min<int>(request->priority() + 1, net::MAXIMUM_PRIORITY)));
+      return new Throttle(this, request, client, true);
+    }
+    case PRIORITY_CLASS_BACKGROUND: {
+      /* Critical resources of background pages are loaded normally so that */
+      /* they are ready to be displayed.                                     */
+      if(IsCritical(resource_type))
+        return NULL;
+      request->SetPriority(net::IDLE);
+      return new Throttle(this, request, client, false);
+    }
+    default:
+      return NULL;
+  }
+}
+
+bool
+ThrustShellRequestScheduler::ShouldDefer(
+    Throttle* throttle)
+{
+  if(throttle->foreground())
+    return false;
+  if(foreground_in_flight_ == 0 &&
+     background_in_flight_ < kMaxBackgroundInFlight) {
+    return false;
+  }
+
+  deferred_.push_back(throttle);
+  if(!deferral_timer_.IsRunning()) {
+    deferral_timer_.Start(FROM_HERE,
+                          base::TimeDelta::FromMilliseconds(kMaxDeferralMs),
+                          this,
+                          &ThrustShellRequestScheduler::Pump);
+  }
+  return true;
+}
+
+void
+ThrustShellRequestScheduler::OnThrottleStarted(
+    Throttle* throttle)
+{
+  throttle->set_started();
+  if(throttle->foreground())
+    foreground_in_flight_++;
+  else
+    background_in_flight_++;
+}
+
+void
+ThrustShellRequestScheduler::OnThrottleDestroyed(
+    Throttle* throttle)
+{
+  if(throttle->deferred()) {
+    std::deque<Throttle*>::iterator it =
+      std::find(deferred_.begin(), deferred_.end(), throttle);
+    if(it != deferred_.end())
+      deferred_.erase(it);
+    return;
+  }
+  if(!throttle->started())
+    return;
+  if(throttle->foreground())
+    foreground_in_flight_--;
+  else
+    background_in_flight_--;
+  Pump();
+}
+
+void
+ThrustShellRequestScheduler::Pump()
+{
+  base::TimeTicks expired =
+    base::TimeTicks::Now() - base::TimeDelta::FromMilliseconds(kMaxDeferralMs);
+
+  /* Deferred throttles are ordered by deferral time. */
+  while(!deferred_.empty()) {
+    Throttle* throttle = deferred_.front();
+    bool allowed = foreground_in_flight_ == 0 &&
+                   background_in_flight_ < kMaxBackgroundInFlight;
+    if(!allowed && throttle->deferred_time() > expired)
+      break;
+    deferred_.pop_front();
+    throttle->Resume();
+  }
+
+  deferral_timer_.Stop();
+  if(!deferred_.empty()) {
+    base::TimeDelta delay = deferred_.front()->deferred_time() - expired;
+    deferral_timer_.Start(FROM_HERE,
+                          std::max(delay, base::TimeDelta()),
+                          this,
+                          &ThrustShellRequestScheduler::Pump);
+  }
+}
+
+} // namespace thrust_shell
@@ -0,0 +1,101 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_REQUEST_SCHEDULER_H_
+#define THRUST_SHELL_NET_REQUEST_SCHEDULER_H_
+
+#include <deque>
+#include <map>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "content/public/common/resource_type.h"
+
+namespace content {
+class ResourceThrottle;
+}
+
+namespace net {
+class URLRequest;
+}
+
+namespace thrust_shell {
+
+// ### ThrustShellRequestScheduler
+//
+// Per session scheduler favoring the requests of foreground content. Each
+// render view (a WebViewGuest or a ThrustWindow main document) has a
+// priority class, set from the UI thread as guests are shown or hidden or
+// explicitly through the API:
+// - foreground requests get their priority raised one level.
+// - background requests that are not critical to render the page (images,
+//   media, XHRs, prefetches...) are lowered to IDLE and delayed while any
+//   foreground request is in flight, with a bounded number in flight
+//   otherwise. They are never delayed more than kMaxDeferral.
+// - normal requests are left untouched.
+//
+// Lives on the IO thread, owned by the URLRequestContextGetter.
+class ThrustShellRequestScheduler {
+public:
+  enum PriorityClass {
+    PRIORITY_CLASS_BACKGROUND = 0,
+    PRIORITY_CLASS_NORMAL,
+    PRIORITY_CLASS_FOREGROUND
+  };
+
+  ThrustShellRequestScheduler();
+  ~ThrustShellRequestScheduler();
+
+  // ### SetPriorityClass
+  // ```
+  // @child_id {int} the render process id
+  // @route_id {int} the render view routing id
+  // @priority_class {PriorityClass} the new class
+  // ```
+  void SetPriorityClass(int child_id,
+                        int route_id,
+                        PriorityClass priority_class);
+  // ### RemoveClient
+  // Forgets the class of a render view that is gone.
+  void RemoveClient(int child_id, int route_id);
+
+  // ### MaybeCreateThrottle
+  // Returns a throttle scheduling |request| or NULL if it is not subject to
+  // scheduling (normal class).
+  content::ResourceThrottle* MaybeCreateThrottle(
+      net::URLRequest* request,
+      content::ResourceType::Type resource_type,
+      int child_id,
+      int route_id);
+
+private:
+  class Throttle;
+  typedef std::pair<int, int> ClientId;
+
+  PriorityClass GetPriorityClass(const ClientId& client) const;
+
+  // Throttle callbacks.
+  bool ShouldDefer(Throttle* throttle);
+  void OnThrottleStarted(Throttle* throttle);
+  void OnThrottleDestroyed(Throttle* throttle);
+
+  // Resumes as many deferred throttles as currently allowed.
+  void Pump();
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  std::map<ClientId, PriorityClass>        classes_;
+  std::deque<Throttle*>                    deferred_;
+  size_t                                   foreground_in_flight_;
+  size_t                                   background_in_flight_;
+  base::OneShotTimer<ThrustShellRequestScheduler> deferral_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellRequestScheduler);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_REQUEST_SCHEDULER_H_
@@ -6,11 +6,13 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop_proxy.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "base/threading/worker_pool.h"
+#include "base/values.h"
 #include "net/base/cache_type.h"
 #include "net/cert/cert_verifier.h"
 #include "net/cookies/cookie_monster.h"
@@ -20,8 +22,13 @@
 #include "net/http/http_cache.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_server_properties_impl.h"
+#include "net/http/transport_security_persister.h"
 #include "net/http/transport_security_state.h"
 #include "net/proxy/dhcp_proxy_script_fetcher_factory.h"
+#include "net/proxy/network_delegate_error_observer.h"
+#include "net/proxy/proxy_resolver_v8.h"
+#include "net/proxy/proxy_resolver_v8_tracing.h"
+#include "net/proxy/proxy_script_fetcher_impl.h"
 #include "net/proxy/proxy_service.h"
 #include "net/ssl/channel_id_service.h"
 #include "net/ssl/default_channel_id_store.h"
@@ -39,7 +46,13 @@
 #include "content/public/browser/cookie_store_factory.h"
 
 #include "src/common/switches.h"
+#include "src/net/app_archive.h"
+#include "src/net/app_protocol_handler.h"
+#include "src/net/host_resolver.h"
+#include "src/net/http_server_properties.h"
 #include "src/net/network_delegate.h"
+#include "src/net/proxy_resolver.h"
+#include "src/browser/browser_main_parts.h"
 #include "src/browser/session/thrust_session.h"
 
 using namespace content;
@@ -48,6 +61,17 @@ namespace thrust_shell {
 
 namespace {
 
+void 
+PostDownloadEvent(
+    const ThrustShellParallelDownloader::EventCallback& callback,
+    const std::string& type,
+    scoped_ptr<base::DictionaryValue> event)
+{
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(callback, type, base::Passed(&event)));
+}
+
 void InstallProtocolHandlers(net::URLRequestJobFactoryImpl* job_factory,
                              ProtocolHandlerMap* protocol_handlers) {
   for (ProtocolHandlerMap::iterator it =
@@ -74,7 +98,11 @@ ThrustShellURLRequestContextGetter::ThrustShellURLRequestContextGetter(
       ignore_certificate_errors_(ignore_certificate_errors),
       base_path_(base_path),
       net_log_(net_log),
-      request_interceptors_(request_interceptors.Pass())
+      app_archive_(ThrustShellMainParts::Get()->app_archive()),
+      request_scheduler_(new ThrustShellRequestScheduler),
+      request_interceptors_(request_interceptors.Pass()),
+      proxy_cache_ttl_(parent->proxy_cache_ttl()),
+      proxy_resolver_(NULL)
 {
   // Must first be created on the UI thread.
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
@@ -94,6 +122,10 @@ ThrustShellURLRequestContextGetter::GetURLRequestContext()
     url_request_context_.reset(new net::URLRequestContext());
     url_request_context_->set_net_log(net_log_);
     network_delegate_.reset(new ThrustShellNetworkDelegate);
+    network_delegate_->set_request_scheduler(request_scheduler_.get());
+    network_delegate_->SetURLRules(url_rules_);
+    network_delegate_->SetHeaderRules(
+        ThrustShellHeaderRules::Compile(header_rule_specs_));
     url_request_context_->set_network_delegate(network_delegate_.get());
     storage_.reset(
         new net::URLRequestContextStorage(url_request_context_.get()));
@@ -120,24 +152,63 @@ ThrustShellURLRequestContextGetter::GetURLRequestContext()
         new net::StaticHttpUserAgentSettings("en-us,en", std::string()));
 
     scoped_ptr<net::HostResolver> host_resolver(
-        net::HostResolver::CreateDefaultResolver(
-            url_request_context_->net_log()));
+        new ThrustShellHostResolver(parent_->host_resolver_options(),
+                                    url_request_context_->net_log()));
 
     storage_->set_cert_verifier(net::CertVerifier::CreateDefault());
     storage_->set_transport_security_state(new net::TransportSecurityState);
 
 
-    storage_->set_proxy_service(
-        net::ProxyService::CreateWithoutProxyResolver(
-          (net::ProxyConfigService*)parent_->proxy_config_service_,
-          url_request_context_->net_log()));
+    /* PAC scripts are evaluated by V8 on the resolver's own thread, their */
+    /* results memoized per host (see ThrustShellProxyResolver).           */
+    net::ProxyResolverV8::EnsureIsolateCreated();
+    proxy_resolver_ = new ThrustShellProxyResolver(
+        new net::ProxyResolverV8Tracing(
+            host_resolver.get(),
+            new net::NetworkDelegateErrorObserver(
+                network_delegate_.get(),
+                base::MessageLoopProxy::current().get()),
+            url_request_context_->net_log()));
+    proxy_resolver_->set_cache_ttl(proxy_cache_ttl_);
+    net::ProxyService* proxy_service = new net::ProxyService(
+        (net::ProxyConfigService*)parent_->proxy_config_service_,
+        proxy_resolver_,
+        url_request_context_->net_log());
+    net::DhcpProxyScriptFetcherFactory dhcp_factory;
+    proxy_service->SetProxyScriptFetchers(
+        new net::ProxyScriptFetcherImpl(url_request_context_.get()),
+        dhcp_factory.Create(url_request_context_.get()));
+    storage_->set_proxy_service(proxy_service);
 
     storage_->set_ssl_config_service(new net::SSLConfigServiceDefaults);
     storage_->set_http_auth_handler_factory(
         net::HttpAuthHandlerFactory::CreateDefault(host_resolver.get()));
-    storage_->set_http_server_properties(
-        scoped_ptr<net::HttpServerProperties>(
-            new net::HttpServerPropertiesImpl()));
+
+    /* Alternate protocol and SPDY hints as well as HSTS state are kept  */
+    /* across restarts for persistent sessions, written in the background */
+    /* with debounced writes.                                             */
+    if(parent_->IsOffTheRecord()) {
+      storage_->set_http_server_properties(
+          scoped_ptr<net::HttpServerProperties>(
+              new net::HttpServerPropertiesImpl()));
+    }
+    else {
+      base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+      scoped_refptr<base::SequencedTaskRunner> background_runner =
+        pool->GetSequencedTaskRunnerWithShutdownBehavior(
+            pool->GetSequenceToken(), 
+            base::SequencedWorkerPool::BLOCK_SHUTDOWN);
+      storage_->set_http_server_properties(
+          scoped_ptr<net::HttpServerProperties>(
+              new ThrustShellHttpServerProperties(base_path_,
+                                                  background_runner)));
+      transport_security_persister_.reset(
+          new net::TransportSecurityPersister(
+              url_request_context_->transport_security_state(),
+              base_path_,
+              background_runner.get(),
+              false));
+    }
 
 
     net::HttpCache::BackendFactory* main_backend = NULL;
@@ -202,6 +273,11 @@ ThrustShellURLRequestContextGetter::GetURLRequestContext()
                 GetTaskRunnerWithShutdownBehavior(
                     base::SequencedWorkerPool::SKIP_ON_SHUTDOWN)));
     DCHECK(set_protocol);
+    if(app_archive_.get()) {
+      set_protocol = job_factory->SetProtocolHandler(
+          kAppScheme, new ThrustShellAppProtocolHandler(app_archive_));
+      DCHECK(set_protocol);
+    }
 
     // Set up interceptors in the reverse order.
     scoped_ptr<net::URLRequestJobFactory> top_job_factory =
@@ -216,6 +292,11 @@ ThrustShellURLRequestContextGetter::GetURLRequestContext()
     request_interceptors_.weak_clear();
 
     storage_->set_job_factory(top_job_factory.release());
+
+    preconnector_.reset(
+        new ThrustShellPreconnector(url_request_context_.get()));
+    downloader_.reset(
+        new ThrustShellParallelDownloader(url_request_context_.get()));
   }
 
   return url_request_context_.get();
@@ -233,4 +314,150 @@ ThrustShellURLRequestContextGetter::host_resolver()
   return url_request_context_->host_resolver();
 }
 
+void
+ThrustShellURLRequestContextGetter::SetURLRules(
+    const scoped_refptr<ThrustShellURLRuleSet>& rules)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  /* Kept until the network delegate is created if it is not yet. */
+  url_rules_ = rules;
+  if(network_delegate_)
+    network_delegate_->SetURLRules(url_rules_);
+}
+
+void
+ThrustShellURLRequestContextGetter::SetHeaderRules(
+    const std::vector<ThrustShellHeaderRules::Spec>& specs)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  /* Kept until the network delegate is created if it is not yet. */
+  header_rule_specs_ = specs;
+  if(network_delegate_) {
+    network_delegate_->SetHeaderRules(
+        ThrustShellHeaderRules::Compile(header_rule_specs_));
+  }
+}
+
+std::vector<ThrustShellHeaderRules::Counters>
+ThrustShellURLRequestContextGetter::GetHeaderRulesCounters()
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(!network_delegate_) {
+    return std::vector<ThrustShellHeaderRules::Counters>(
+        header_rule_specs_.size());
+  }
+  return network_delegate_->GetHeaderRulesCounters();
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellURLRequestContextGetter::GetNetStats(
+    const std::string& host,
+    bool reset)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(!network_delegate_)
+    return ThrustShellNetStats().Summary(host);
+  scoped_ptr<base::DictionaryValue> summary =
+    network_delegate_->net_stats()->Summary(host);
+  if(reset)
+    network_delegate_->net_stats()->Reset();
+  return summary.Pass();
+}
+
+void
+ThrustShellURLRequestContextGetter::SetRequestPriorityClass(
+    int child_id,
+    int route_id,
+    ThrustShellRequestScheduler::PriorityClass priority_class)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  request_scheduler_->SetPriorityClass(child_id, route_id, priority_class);
+}
+
+void
+ThrustShellURLRequestContextGetter::RemoveRequestPriorityClass(
+    int child_id,
+    int route_id)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  request_scheduler_->RemoveClient(child_id, route_id);
+}
+
+void
+ThrustShellURLRequestContextGetter::Preconnect(
+    const GURL& url,
+    int count)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  /* Creates the context if no request was issued yet. */
+  GetURLRequestContext();
+  preconnector_->Preconnect(url, count);
+}
+
+size_t
+ThrustShellURLRequestContextGetter::PrefetchDNS(
+    const std::vector<std::string>& hosts)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  GetURLRequestContext();
+  return preconnector_->PrefetchDNS(hosts);
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellURLRequestContextGetter::GetDNSStats(
+    bool reset)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(!url_request_context_) {
+    return ThrustShellHostResolver::Stats().ToValue();
+  }
+  /* The host resolver is always a ThrustShellHostResolver. */
+  return static_cast<ThrustShellHostResolver*>(
+      url_request_context_->host_resolver())->GetStats(reset);
+}
+
+void
+ThrustShellURLRequestContextGetter::SetProxyCacheTTL(
+    base::TimeDelta cache_ttl)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  proxy_cache_ttl_ = cache_ttl;
+  if(proxy_resolver_)
+    proxy_resolver_->set_cache_ttl(proxy_cache_ttl_);
+}
+
+void
+ThrustShellURLRequestContextGetter::StartDownload(
+    int id,
+    const GURL& url,
+    const base::FilePath& path,
+    const ThrustShellParallelDownloader::Options& options,
+    const ThrustShellParallelDownloader::EventCallback& callback)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  GetURLRequestContext();
+  downloader_->Start(id, url, path, options,
+                     base::Bind(&PostDownloadEvent, callback));
+}
+
+void
+ThrustShellURLRequestContextGetter::CancelDownload(
+    int id)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(downloader_)
+    downloader_->Cancel(id);
+}
+
+scoped_ptr<base::DictionaryValue>
+ThrustShellURLRequestContextGetter::GetProxyStats(
+    bool reset)
+{
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if(!proxy_resolver_) {
+    return ThrustShellProxyResolver::Stats().ToValue();
+  }
+  return proxy_resolver_->GetStats(reset);
+}
+
 } // namespace thrust_shell
@@ -9,26 +9,37 @@
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
 #include "content/public/browser/content_browser_client.h"
 #include "net/url_request/url_request_context_getter.h"
 #include "net/url_request/url_request_job_factory.h"
 
+#include "src/net/header_rules.h"
+#include "src/net/parallel_download.h"
+#include "src/net/preconnector.h"
+#include "src/net/request_scheduler.h"
+#include "src/net/url_rule_set.h"
+
 namespace base {
+class DictionaryValue;
 class MessageLoop;
 }
 
 namespace net {
 class HostResolver;
 class MappedHostResolver;
-class NetworkDelegate;
 class NetLog;
 class ProxyConfigService;
+class TransportSecurityPersister;
 class URLRequestContextStorage;
 }
 
 namespace thrust_shell {
 
 class ThrustSession;
+class ThrustShellAppArchive;
+class ThrustShellNetworkDelegate;
+class ThrustShellProxyResolver;
 
 class ThrustShellURLRequestContextGetter : public net::URLRequestContextGetter {
  public:
@@ -47,6 +58,95 @@ class ThrustShellURLRequestContextGetter : public net::URLRequestContextGetter {
 
   net::HostResolver* host_resolver();
 
+  // ### SetURLRules
+  // Installs the URL rules on the network delegate. Runs on the IO thread.
+  // ```
+  // @rules {ThrustShellURLRuleSet} the compiled rules (NULL to clear)
+  // ```
+  void SetURLRules(const scoped_refptr<ThrustShellURLRuleSet>& rules);
+
+  // ### SetHeaderRules
+  // Compiles and installs the header rewrite rules on the network delegate.
+  // Runs on the IO thread.
+  // ```
+  // @specs {vector<Spec>} the header rules
+  // ```
+  void SetHeaderRules(const std::vector<ThrustShellHeaderRules::Spec>& specs);
+  // ### GetHeaderRulesCounters
+  // Runs on the IO thread.
+  std::vector<ThrustShellHeaderRules::Counters> GetHeaderRulesCounters();
+
+  // ### GetNetStats
+  // Returns the load timing summary of this context. Runs on the IO thread.
+  // ```
+  // @host  {string} optional host filter
+  // @reset {bool} whether to reset the statistics once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetNetStats(const std::string& host,
+                                                bool reset);
+
+  // ### SetRequestPriorityClass
+  // Sets the scheduling class of the requests of a render view. Runs on the
+  // IO thread.
+  // ```
+  // @child_id       {int} the render process id
+  // @route_id       {int} the render view routing id
+  // @priority_class {PriorityClass} the new class
+  // ```
+  void SetRequestPriorityClass(
+      int child_id,
+      int route_id,
+      ThrustShellRequestScheduler::PriorityClass priority_class);
+  // ### RemoveRequestPriorityClass
+  // Runs on the IO thread.
+  void RemoveRequestPriorityClass(int child_id, int route_id);
+
+  // ### Preconnect
+  // Opens `count` sockets to the origin of `url`. Runs on the IO thread.
+  void Preconnect(const GURL& url, int count);
+  // ### PrefetchDNS
+  // Speculatively resolves `hosts`, returns the number of resolutions
+  // started. Runs on the IO thread.
+  size_t PrefetchDNS(const std::vector<std::string>& hosts);
+
+  // ### GetDNSStats
+  // Returns the host resolver statistics of this context. Runs on the IO
+  // thread.
+  // ```
+  // @reset {bool} whether to reset the statistics once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetDNSStats(bool reset);
+
+  // ### SetProxyCacheTTL
+  // Sets the time PAC results are cached per host. Runs on the IO thread.
+  void SetProxyCacheTTL(base::TimeDelta cache_ttl);
+  // ### GetProxyStats
+  // Returns the PAC evaluation statistics of this context. Runs on the IO
+  // thread.
+  // ```
+  // @reset {bool} whether to reset the statistics once returned
+  // ```
+  scoped_ptr<base::DictionaryValue> GetProxyStats(bool reset);
+
+  // ### StartDownload
+  // Starts (or resumes) a parallel ranged download. Runs on the IO thread.
+  // ```
+  // @id       {int} the download id
+  // @url      {GURL} the URL to download
+  // @path     {FilePath} the target file
+  // @options  {Options} the download options
+  // @callback {EventCallback} called on the UI thread with the events
+  // ```
+  void StartDownload(
+      int id,
+      const GURL& url,
+      const base::FilePath& path,
+      const ThrustShellParallelDownloader::Options& options,
+      const ThrustShellParallelDownloader::EventCallback& callback);
+  // ### CancelDownload
+  // Runs on the IO thread.
+  void CancelDownload(int id);
+
  protected:
   virtual ~ThrustShellURLRequestContextGetter();
 
@@ -55,12 +155,23 @@ class ThrustShellURLRequestContextGetter : public net::URLRequestContextGetter {
   bool                                       ignore_certificate_errors_;
   base::FilePath                             base_path_;
   net::NetLog*                               net_log_;
+  scoped_refptr<ThrustShellAppArchive>       app_archive_;
 
-  scoped_ptr<net::NetworkDelegate>           network_delegate_;
+  scoped_ptr<ThrustShellNetworkDelegate>     network_delegate_;
+  scoped_ptr<ThrustShellRequestScheduler>    request_scheduler_;
   scoped_ptr<net::URLRequestContextStorage>  storage_;
   scoped_ptr<net::URLRequestContext>         url_request_context_;
+  /* Declared after the context so that it is destroyed first. */
+  scoped_ptr<ThrustShellPreconnector>        preconnector_;
+  scoped_ptr<ThrustShellParallelDownloader>  downloader_;
+  scoped_ptr<net::TransportSecurityPersister> transport_security_persister_;
   content::ProtocolHandlerMap                protocol_handlers_;
   content::URLRequestInterceptorScopedVector request_interceptors_;
+  scoped_refptr<ThrustShellURLRuleSet>       url_rules_;
+  std::vector<ThrustShellHeaderRules::Spec>  header_rule_specs_;
+  base::TimeDelta                            proxy_cache_ttl_;
+  /* Owned by the proxy service. */
+  ThrustShellProxyResolver*                  proxy_resolver_;
 
   friend class ThrustSession;
 
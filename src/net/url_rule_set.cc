@@ -0,0 +1,778 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#include "src/net/url_rule_set.h"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <string.h>
+
+#include "base/containers/hash_tables.h"
+#include "base/logging.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+
+namespace thrust_shell {
+
+namespace {
+
+/* Tokens shorter than this are too common to be worth indexing. */
+const size_t kMinTokenLength = 2;
+
+/* Tokens present in most URLs. Rules are only indexed by them as a last */
+/* resort as they would be checked for nearly every request.             */
+const char* kCommonTokens[] = {
+  "http", "https", "www", "com", "net", "org", "html", "js"
+};
+
+enum Party {
+  PARTY_ANY = 0,
+  PARTY_FIRST,
+  PARTY_THIRD
+};
+
+bool
+IsTokenChar(
+    char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '%';
+}
+
+/* The adblock `^` placeholder: anything but a letter, a digit or one of */
+/* `_-.%`. The end of the URL is handled by the callers.                  */
+bool
+IsSeparator(
+    char c)
+{
+  return !IsTokenChar(c) && c != '_' && c != '-' && c != '.';
+}
+
+uint32
+HashToken(
+    const char* token,
+    size_t len)
+{
+  /* FNV-1a, case insensitive. */
+  uint32 hash = 2166136261u;
+  for(size_t i = 0; i < len; ++i) {
+    hash ^= static_cast<unsigned char>(base::ToLowerASCII(token[i]));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool
+IsCommonToken(
+    const char* token,
+    size_t len)
+{
+  for(size_t i = 0; i < arraysize(kCommonTokens); ++i) {
+    if(strlen(kCommonTokens[i]) == len &&
+       base::strncasecmp(kCommonTokens[i], token, len) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int
+TypeFromName(
+    const std::string& name)
+{
+  if(name == "document")
+    return ThrustShellURLRuleSet::TYPE_DOCUMENT;
+  if(name == "subdocument")
+    return ThrustShellURLRuleSet::TYPE_SUBDOCUMENT;
+  if(name == "stylesheet")
+    return ThrustShellURLRuleSet::TYPE_STYLESHEET;
+  if(name == "script")
+    return ThrustShellURLRuleSet::TYPE_SCRIPT;
+  if(name == "image")
+    return ThrustShellURLRuleSet::TYPE_IMAGE;
+  if(name == "font")
+    return ThrustShellURLRuleSet::TYPE_FONT;
+  if(name == "object")
+    return ThrustShellURLRuleSet::TYPE_OBJECT;
+  if(name == "media")
+    return ThrustShellURLRuleSet::TYPE_MEDIA;
+  if(name == "xmlhttprequest")
+    return ThrustShellURLRuleSet::TYPE_XMLHTTPREQUEST;
+  if(name == "ping")
+    return ThrustShellURLRuleSet::TYPE_PING;
+  if(name == "other")
+    return ThrustShellURLRuleSet::TYPE_OTHER;
+  return 0;
+}
+
+/* Returns true if |host| is |domain| or one of its subdomains. */
+bool
+IsHostOrSubdomain(
+    const std::string& host,
+    const std::string& domain)
+{
+  if(host.size() < domain.size())
+    return false;
+  if(host.compare(host.size() - domain.size(), domain.size(), domain) != 0)
+    return false;
+  return host.size() == domain.size() ||
+         host[host.size() - domain.size() - 1] == '.';
+}
+
+/* Matches the wildcard free |segment| at |pos| in |url|. On success |end| */
+/* is set to the position right after the match.                          */
+bool
+MatchSegmentAt(
+    const std::string& url,
+    size_t pos,
+    const char* segment,
+    size_t len,
+    size_t* end)
+{
+  for(size_t i = 0; i < len; ++i) {
+    if(segment[i] == '^') {
+      if(pos == url.size()) {
+        /* `^` matches the end of the URL, only as the last placeholder. */
+        if(i == len - 1)
+          break;
+        return false;
+      }
+      if(!IsSeparator(url[pos]))
+        return false;
+      ++pos;
+      continue;
+    }
+    if(pos >= url.size() || url[pos] != segment[i])
+      return false;
+    ++pos;
+  }
+  *end = pos;
+  return true;
+}
+
+/* Finds the leftmost match of |segment| at or after |from| in |url|. */
+bool
+FindSegment(
+    const std::string& url,
+    size_t from,
+    const char* segment,
+    size_t len,
+    size_t* end)
+{
+  for(size_t pos = from; pos <= url.size(); ++pos) {
+    if(len > 0 && segment[0] != '^') {
+      pos = url.find(segment[0], pos);
+      if(pos == std::string::npos)
+        return false;
+    }
+    if(MatchSegmentAt(url, pos, segment, len, end))
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+/******************************************************************************/
+/* RULE */
+/******************************************************************************/
+
+struct ThrustShellURLRuleSet::Rule {
+  Rule()
+  : host_anchor(false),
+    start_anchor(false),
+    end_anchor(false),
+    match_case(false),
+    types(TYPE_ALL & ~TYPE_DOCUMENT),
+    party(PARTY_ANY),
+    action(ACTION_BLOCK) {}
+
+  /* The pattern without its anchors, lowercased unless |match_case|. */
+  std::string                 pattern;
+  bool                        host_anchor;
+  bool                        start_anchor;
+  bool                        end_anchor;
+  bool                        match_case;
+  int                         types;
+  int                         party;
+  std::vector<std::string>    domains;
+  std::vector<std::string>    excluded_domains;
+  Action                      action;
+  GURL                        redirect_url;
+};
+
+namespace {
+
+/* Parses a single non comment rule. Returns false if it is not supported. */
+bool
+ParseRule(
+    const std::string& text,
+    ThrustShellURLRuleSet::Rule* rule,
+    bool* exception)
+{
+  std::string line = text;
+
+  /* Cosmetic rules. */
+  if(line.find("##") != std::string::npos ||
+     line.find("#@#") != std::string::npos) {
+    return false;
+  }
+
+  *exception = false;
+  if(StartsWithASCII(line, "@@", true)) {
+    *exception = true;
+    line = line.substr(2);
+  }
+
+  std::string options;
+  size_t dollar = line.rfind('$');
+  if(dollar != std::string::npos) {
+    options = line.substr(dollar + 1);
+    line = line.substr(0, dollar);
+  }
+
+  /* Regular expressions. */
+  if(line.size() >= 2 && line[0] == '/' && line[line.size() - 1] == '/')
+    return false;
+
+  int types = 0;
+  int excluded_types = 0;
+  std::vector<std::string> opts;
+  base::SplitString(options, ',', &opts);
+  for(size_t i = 0; i < opts.size(); ++i) {
+    if(opts[i].empty())
+      continue;
+    bool negated = opts[i][0] == '~';
+    std::string name = negated ? opts[i].substr(1) : opts[i];
+
+    int type = TypeFromName(name);
+    if(type != 0) {
+      if(negated)
+        excluded_types |= type;
+      else
+        types |= type;
+    }
+    else if(name == "third-party") {
+      rule->party = negated ? PARTY_FIRST : PARTY_THIRD;
+    }
+    else if(name == "match-case" && !negated) {
+      rule->match_case = true;
+    }
+    else if(StartsWithASCII(name, "domain=", true) && !negated) {
+      std::vector<std::string> domains;
+      base::SplitString(name.substr(7), '|', &domains);
+      for(size_t j = 0; j < domains.size(); ++j) {
+        std::string domain = StringToLowerASCII(domains[j]);
+        if(domain.empty())
+          continue;
+        if(domain[0] == '~')
+          rule->excluded_domains.push_back(domain.substr(1));
+        else
+          rule->domains.push_back(domain);
+      }
+    }
+    else if(name == "cancel" && !negated) {
+      rule->action = ThrustShellURLRuleSet::ACTION_CANCEL;
+    }
+    else if(StartsWithASCII(name, "redirect=", true) && !negated) {
+      rule->redirect_url = GURL(name.substr(9));
+      if(!rule->redirect_url.is_valid())
+        return false;
+      rule->action = ThrustShellURLRuleSet::ACTION_REDIRECT;
+    }
+    else {
+      return false;
+    }
+  }
+  if(types != 0)
+    rule->types = types;
+  rule->types &= ~excluded_types;
+  if(rule->types == 0)
+    return false;
+
+  if(StartsWithASCII(line, "||", true)) {
+    rule->host_anchor = true;
+    line = line.substr(2);
+  }
+  else if(!line.empty() && line[0] == '|') {
+    rule->start_anchor = true;
+    line = line.substr(1);
+  }
+  if(!line.empty() && line[line.size() - 1] == '|') {
+    rule->end_anchor = true;
+    line.resize(line.size() - 1);
+  }
+
+  /* Collapse wildcards, leading and trailing ones cancel the anchors. */
+  std::string pattern;
+  pattern.reserve(line.size());
+  for(size_t i = 0; i < line.size(); ++i) {
+    if(line[i] == '*' && !pattern.empty() && pattern[pattern.size() - 1] == '*')
+      continue;
+    pattern.push_back(line[i]);
+  }
+  if(!pattern.empty() && pattern[0] == '*') {
+    rule->host_anchor = false;
+    rule->start_anchor = false;
+    pattern.erase(0, 1);
+  }
+  if(!pattern.empty() && pattern[pattern.size() - 1] == '*') {
+    rule->end_anchor = false;
+    pattern.resize(pattern.size() - 1);
+  }
+
+  /* A rule without pattern nor options would match every request. */
+  if(pattern.empty() && options.empty())
+    return false;
+
+  rule->pattern = rule->match_case ? pattern : StringToLowerASCII(pattern);
+  return true;
+}
+
+} // namespace
+
+/******************************************************************************/
+/* REQUEST */
+/******************************************************************************/
+
+namespace {
+
+/* Per request state shared by both indexes, computed once. */
+struct Request {
+  Request(const GURL& url,
+          const GURL& first_party,
+          ThrustShellURLRuleSet::ResourceType type)
+  : url(url),
+    first_party(first_party),
+    type(type),
+    lower(StringToLowerASCII(url.spec())),
+    host_begin(0),
+    host_end(0),
+    third_party(-1)
+  {
+    const url::Component& host = url.parsed_for_possibly_invalid_spec().host;
+    if(host.is_nonempty()) {
+      host_begin = host.begin;
+      host_end = host.end();
+    }
+  }
+
+  bool IsThirdParty() {
+    if(third_party == -1) {
+      third_party = first_party.is_valid() &&
+          !net::registry_controlled_domains::SameDomainOrHost(
+              url, first_party,
+              net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
+    }
+    return third_party == 1;
+  }
+
+  const GURL&                           url;
+  const GURL&                           first_party;
+  ThrustShellURLRuleSet::ResourceType   type;
+  std::string                           lower;
+  size_t                                host_begin;
+  size_t                                host_end;
+  int                                   third_party;
+};
+
+/* Matches the pattern of |rule| against |url| starting at |start|. */
+bool
+MatchPatternFrom(
+    const ThrustShellURLRuleSet::Rule& rule,
+    const std::string& url,
+    size_t start,
+    bool anchored)
+{
+  const std::string& p = rule.pattern;
+  size_t pos = start;
+  size_t segment_begin = 0;
+  bool first = true;
+
+  while(true) {
+    size_t star = p.find('*', segment_begin);
+    bool last = (star == std::string::npos);
+    const char* segment = p.data() + segment_begin;
+    size_t len = (last ? p.size() : star) - segment_begin;
+    size_t end = pos;
+
+    if(first && anchored) {
+      if(!MatchSegmentAt(url, pos, segment, len, &end))
+        return false;
+      if(last && rule.end_anchor && end != url.size())
+        return false;
+    }
+    else if(last && rule.end_anchor) {
+      /* The last segment must end exactly at the end of the URL. */
+      size_t from = url.size() >= len ? std::max(pos, url.size() - len) : pos;
+      for(size_t q = from; q <= url.size(); ++q) {
+        if(MatchSegmentAt(url, q, segment, len, &end) && end == url.size())
+          return true;
+      }
+      return false;
+    }
+    else {
+      if(!FindSegment(url, pos, segment, len, &end))
+        return false;
+    }
+
+    if(last)
+      return true;
+    pos = end;
+    segment_begin = star + 1;
+    first = false;
+  }
+}
+
+bool
+RuleMatches(
+    const ThrustShellURLRuleSet::Rule& rule,
+    Request* request)
+{
+  if(!(rule.types & request->type))
+    return false;
+
+  if(rule.party != PARTY_ANY &&
+     request->IsThirdParty() != (rule.party == PARTY_THIRD)) {
+    return false;
+  }
+
+  if(!rule.domains.empty() || !rule.excluded_domains.empty()) {
+    std::string host = request->first_party.host();
+    for(size_t i = 0; i < rule.excluded_domains.size(); ++i) {
+      if(IsHostOrSubdomain(host, rule.excluded_domains[i]))
+        return false;
+    }
+    bool included = rule.domains.empty();
+    for(size_t i = 0; !included && i < rule.domains.size(); ++i) {
+      included = IsHostOrSubdomain(host, rule.domains[i]);
+    }
+    if(!included)
+      return false;
+  }
+
+  const std::string& url = rule.match_case ?
+    request->url.spec() : request->lower;
+
+  if(rule.host_anchor) {
+    /* The pattern must start at the beginning of a host label. */
+    if(request->host_begin == request->host_end)
+      return false;
+    for(size_t i = request->host_begin; i < request->host_end; ++i) {
+      if((i == request->host_begin || url[i - 1] == '.') &&
+         MatchPatternFrom(rule, url, i, true)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return MatchPatternFrom(rule, url, 0, rule.start_anchor);
+}
+
+/******************************************************************************/
+/* AHO-CORASICK */
+/******************************************************************************/
+
+/* Finds all the literals present in a text in a single pass. */
+class AhoCorasick {
+public:
+  AhoCorasick() {
+    nodes_.push_back(Node());
+  }
+
+  void Add(const std::string& literal, uint32 value) {
+    int state = 0;
+    for(size_t i = 0; i < literal.size(); ++i) {
+      std::map<char, int>::iterator it = nodes_[state].next.find(literal[i]);
+      if(it == nodes_[state].next.end()) {
+        nodes_.push_back(Node());
+        nodes_[state].next[literal[i]] = nodes_.size() - 1;
+        state = nodes_.size() - 1;
+      }
+      else {
+        state = it->second;
+      }
+    }
+    nodes_[state].values.push_back(value);
+  }
+
+  /* Computes the failure and output links. Must be called once all the */
+  /* literals have been added.                                           */
+  void Build() {
+    std::queue<int> queue;
+    for(std::map<char, int>::iterator it = nodes_[0].next.begin();
+        it != nodes_[0].next.end(); ++it) {
+      queue.push(it->second);
+    }
+    while(!queue.empty()) {
+      int u = queue.front();
+      queue.pop();
+      for(std::map<char, int>::iterator it = nodes_[u].next.begin();
+          it != nodes_[u].next.end(); ++it) {
+        int v = it->second;
+        int f = nodes_[u].fail;
+        while(f != 0 && nodes_[f].next.find(it->first) == nodes_[f].next.end())
+          f = nodes_[f].fail;
+        std::map<char, int>::iterator fit = nodes_[f].next.find(it->first);
+        nodes_[v].fail =
+          (fit != nodes_[f].next.end() && fit->second != v) ? fit->second : 0;
+        int fail = nodes_[v].fail;
+        nodes_[v].output = nodes_[fail].values.empty() ?
+          nodes_[fail].output : fail;
+        queue.push(v);
+      }
+    }
+  }
+
+  /* Appends to |values| the values of all the literals found in |text|. */
+  void Find(const std::string& text, std::vector<uint32>* values) const {
+    if(nodes_.size() == 1)
+      return;
+    int state = 0;
+    for(size_t i = 0; i < text.size(); ++i) {
+      std::map<char, int>::const_iterator it;
+      while(true) {
+        it = nodes_[state].next.find(text[i]);
+        if(it != nodes_[state].next.end() || state == 0)
+          break;
+        state = nodes_[state].fail;
+      }
+      state = (it != nodes_[state].next.end()) ? it->second : 0;
+      int out = nodes_[state].values.empty() ? nodes_[state].output : state;
+      while(out != 0) {
+        values->insert(values->end(),
+                       nodes_[out].values.begin(), nodes_[out].values.end());
+        out = nodes_[out].output;
+      }
+    }
+  }
+
+private:
+  struct Node {
+    Node() : fail(0), output(0) {}
+
+    std::map<char, int>       next;
+    int                       fail;
+    /* Next node on the failure chain with values (0 if none). */
+    int                       output;
+    std::vector<uint32>       values;
+  };
+
+  std::vector<Node>           nodes_;
+};
+
+} // namespace
+
+/******************************************************************************/
+/* INDEX */
+/******************************************************************************/
+
+class ThrustShellURLRuleSet::Index {
+public:
+  Index() {}
+
+  void Add(const Rule& rule) {
+    uint32 id = rules_.size();
+    rules_.push_back(rule);
+
+    uint32 token;
+    if(PickToken(rule, &token)) {
+      tokens_[token].push_back(id);
+      return;
+    }
+    std::string literal = StringToLowerASCII(LongestLiteral(rule.pattern));
+    if(!literal.empty())
+      literals_.Add(literal, id);
+    else
+      unindexed_.push_back(id);
+  }
+
+  void Build() {
+    literals_.Build();
+  }
+
+  /* Returns the first rule (in insertion order) matching |request|. */
+  const Rule* Match(Request* request) const {
+    if(rules_.empty())
+      return NULL;
+
+    std::vector<uint32> candidates(unindexed_);
+    std::vector<uint32> seen;
+    const std::string& url = request->lower;
+    for(size_t i = 0; i < url.size();) {
+      if(!IsTokenChar(url[i])) {
+        ++i;
+        continue;
+      }
+      size_t begin = i;
+      while(i < url.size() && IsTokenChar(url[i]))
+        ++i;
+      if(i - begin < kMinTokenLength)
+        continue;
+      uint32 token = HashToken(url.data() + begin, i - begin);
+      Tokens::const_iterator it = tokens_.find(token);
+      if(it == tokens_.end() ||
+         std::find(seen.begin(), seen.end(), token) != seen.end()) {
+        continue;
+      }
+      seen.push_back(token);
+      candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+    literals_.Find(url, &candidates);
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+    for(size_t i = 0; i < candidates.size(); ++i) {
+      if(RuleMatches(rules_[candidates[i]], request))
+        return &rules_[candidates[i]];
+    }
+    return NULL;
+  }
+
+private:
+  typedef base::hash_map<uint32, std::vector<uint32> > Tokens;
+
+  /* Picks the least used token of the pattern that is guaranteed to be a */
+  /* full token of any matching URL: bounded by separators or anchors.    */
+  bool PickToken(const Rule& rule, uint32* token) {
+    const std::string& p = rule.pattern;
+    size_t best_score = 0;
+    size_t best_len = 0;
+    bool found = false;
+
+    for(size_t i = 0; i < p.size();) {
+      if(!IsTokenChar(p[i])) {
+        ++i;
+        continue;
+      }
+      size_t begin = i;
+      while(i < p.size() && IsTokenChar(p[i]))
+        ++i;
+      size_t len = i - begin;
+      bool left = begin > 0 ? p[begin - 1] != '*' :
+        (rule.host_anchor || rule.start_anchor);
+      bool right = i < p.size() ? p[i] != '*' : rule.end_anchor;
+      if(!left || !right || len < kMinTokenLength)
+        continue;
+
+      uint32 hash = HashToken(p.data() + begin, len);
+      Tokens::const_iterator it = tokens_.find(hash);
+      size_t score = (it == tokens_.end() ? 0 : it->second.size());
+      if(IsCommonToken(p.data() + begin, len))
+        score += rules_.size();
+      if(!found || score < best_score ||
+         (score == best_score && len > best_len)) {
+        found = true;
+        best_score = score;
+        best_len = len;
+        *token = hash;
+      }
+    }
+    return found;
+  }
+
+  static std::string LongestLiteral(const std::string& pattern) {
+    size_t best_begin = 0;
+    size_t best_len = 0;
+    size_t begin = 0;
+    for(size_t i = 0; i <= pattern.size(); ++i) {
+      if(i == pattern.size() || pattern[i] == '*' || pattern[i] == '^') {
+        if(i - begin > best_len) {
+          best_begin = begin;
+          best_len = i - begin;
+        }
+        begin = i + 1;
+      }
+    }
+    return pattern.substr(best_begin, best_len);
+  }
+
+  std::vector<Rule>           rules_;
+  Tokens                      tokens_;
+  AhoCorasick                 literals_;
+  std::vector<uint32>         unindexed_;
+
+  DISALLOW_COPY_AND_ASSIGN(Index);
+};
+
+/******************************************************************************/
+/* URL RULE SET */
+/******************************************************************************/
+
+ThrustShellURLRuleSet::ThrustShellURLRuleSet()
+: filters_(new Index),
+  exceptions_(new Index),
+  rule_count_(0),
+  ignored_count_(0)
+{
+}
+
+ThrustShellURLRuleSet::~ThrustShellURLRuleSet()
+{
+}
+
+// static
+scoped_refptr<ThrustShellURLRuleSet>
+ThrustShellURLRuleSet::Compile(
+    const std::vector<std::string>& rules)
+{
+  scoped_refptr<ThrustShellURLRuleSet> rule_set(new ThrustShellURLRuleSet);
+
+  for(size_t i = 0; i < rules.size(); ++i) {
+    std::string text;
+    base::TrimWhitespaceASCII(rules[i], base::TRIM_ALL, &text);
+    /* Empty lines, comments and list headers. */
+    if(text.empty() || text[0] == '!' || text[0] == '[')
+      continue;
+
+    Rule rule;
+    bool exception = false;
+    if(!ParseRule(text, &rule, &exception)) {
+      rule_set->ignored_count_++;
+      continue;
+    }
+    if(exception)
+      rule_set->exceptions_->Add(rule);
+    else
+      rule_set->filters_->Add(rule);
+    rule_set->rule_count_++;
+  }
+
+  rule_set->filters_->Build();
+  rule_set->exceptions_->Build();
+
+  LOG(INFO) << "ThrustShellURLRuleSet compiled " << rule_set->rule_count_
+            << " rules (" << rule_set->ignored_count_ << " ignored)";
+  return rule_set;
+}
+
+ThrustShellURLRuleSet::Action
+ThrustShellURLRuleSet::Match(
+    const GURL& url,
+    const GURL& first_party,
+    ResourceType type,
+    GURL* redirect_url) const
+{
+  if(rule_count_ == 0 || !url.is_valid() ||
+     !(url.SchemeIsHTTPOrHTTPS() || url.SchemeIsWSOrWSS())) {
+    return ACTION_NONE;
+  }
+
+  Request request(url, first_party, type);
+  const Rule* rule = filters_->Match(&request);
+  if(!rule || exceptions_->Match(&request))
+    return ACTION_NONE;
+
+  if(rule->action == ACTION_REDIRECT) {
+    /* Never redirect a request to itself. */
+    if(rule->redirect_url == url)
+      return ACTION_NONE;
+    *redirect_url = rule->redirect_url;
+  }
+  return rule->action;
+}
+
+} // namespace thrust_shell
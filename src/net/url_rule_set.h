@@ -0,0 +1,111 @@
+// Copyright (c) 2014 Stanislas Polu. All rights reserved.
+// See the LICENSE file.
+
+#ifndef THRUST_SHELL_NET_URL_RULE_SET_H_
+#define THRUST_SHELL_NET_URL_RULE_SET_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "url/gurl.h"
+
+namespace thrust_shell {
+
+// ### ThrustShellURLRuleSet
+//
+// A compiled, immutable set of URL rules evaluated by the network delegate
+// on the IO thread for every request. Rules use the adblock filter syntax:
+// - `||example.com^` matches on the host (and its subdomains)
+// - `|http://` and `foo|` anchor at the start and end of the URL
+// - `*` matches any sequence and `^` matches a separator or the URL end
+// - `@@` marks an exception rule, which wins over any matching rule
+// - `$` introduces comma separated options: resource types (`script`,
+//   `image`, `stylesheet`, `object`, `xmlhttprequest`, `subdocument`,
+//   `document`, `font`, `media`, `ping`, `other`, negated with `~`),
+//   `third-party`, `~third-party`, `match-case`, `domain=a.com|~b.a.com`,
+//   and the actions `cancel` and `redirect=<url>` (blocking by default)
+//
+// Comments, cosmetic rules, regular expressions and rules with unknown
+// options are ignored. Rules are indexed by their rarest token, so that only a
+// handful of them are checked per request. Rules from which no token can be
+// extracted are found through an Aho-Corasick automaton built over their
+// longest literal.
+class ThrustShellURLRuleSet
+    : public base::RefCountedThreadSafe<ThrustShellURLRuleSet> {
+public:
+  enum Action {
+    ACTION_NONE = 0,
+    ACTION_BLOCK,
+    ACTION_REDIRECT,
+    ACTION_CANCEL
+  };
+
+  enum ResourceType {
+    TYPE_DOCUMENT       = 1 << 0,
+    TYPE_SUBDOCUMENT    = 1 << 1,
+    TYPE_STYLESHEET     = 1 << 2,
+    TYPE_SCRIPT         = 1 << 3,
+    TYPE_IMAGE          = 1 << 4,
+    TYPE_FONT           = 1 << 5,
+    TYPE_OBJECT         = 1 << 6,
+    TYPE_MEDIA          = 1 << 7,
+    TYPE_XMLHTTPREQUEST = 1 << 8,
+    TYPE_PING           = 1 << 9,
+    TYPE_OTHER          = 1 << 10,
+    TYPE_ALL            = (1 << 11) - 1
+  };
+
+  // ### Compile
+  // Parses and indexes |rules|. Compiling 100k rules takes a noticeable amount
+  // of time so this should be called from the blocking pool.
+  // ```
+  // @rules {vector<string>} the rules, one per entry
+  // ```
+  static scoped_refptr<ThrustShellURLRuleSet> Compile(
+      const std::vector<std::string>& rules);
+
+  // ### Match
+  // Returns the action to take for a request. Thread safe.
+  // ```
+  // @url          {GURL} the request URL
+  // @first_party  {GURL} the first party URL (the document URL)
+  // @type         {ResourceType} the request resource type
+  // @redirect_url {GURL*} set to the target URL for ACTION_REDIRECT
+  // ```
+  Action Match(const GURL& url,
+               const GURL& first_party,
+               ResourceType type,
+               GURL* redirect_url) const;
+
+  // The number of rules compiled and ignored.
+  size_t rule_count() const { return rule_count_; }
+  size_t ignored_count() const { return ignored_count_; }
+
+  // A parsed rule, defined in the implementation file.
+  struct Rule;
+
+private:
+  class Index;
+
+  ThrustShellURLRuleSet();
+  ~ThrustShellURLRuleSet();
+
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  scoped_ptr<Index>                  filters_;
+  scoped_ptr<Index>                  exceptions_;
+  size_t                             rule_count_;
+  size_t                             ignored_count_;
+
+  friend class base::RefCountedThreadSafe<ThrustShellURLRuleSet>;
+
+  DISALLOW_COPY_AND_ASSIGN(ThrustShellURLRuleSet);
+};
+
+} // namespace thrust_shell
+
+#endif // THRUST_SHELL_NET_URL_RULE_SET_H_
@@ -19,6 +19,8 @@ var getNextId = function() {
 var ERROR_MSG_CONTENTWINDOW_NOT_AVAILABLE = '<webview>: ' +
   'contentWindow is not available at this time. It will become available ' +
   'when the page has finished loading.';
+var ERROR_MSG_GUEST_CREATION_REFUSED = '<webview>: ' +
+  'the guest could not be created, too many guests are being created.';
 
 var WEB_VIEW_ATTRIBUTE_AUTOSIZE = 'autosize';
 var WEB_VIEW_ATTRIBUTE_MAXHEIGHT = 'maxheight';
@@ -49,7 +51,13 @@ var WEB_VIEW_EVENTS = {
   'crashed': ['process_id', 'reason'],
   'destroyed': [],
   'dialog': ['origin_url', 'accept_lang', 'message_type', 'message_text', 'default_prompt_text'],
-  'title-set': ['title', 'explicit_set']
+  'title-set': ['title', 'explicit_set'],
+  'size-changed': ['old_width', 'old_height', 'new_width', 'new_height'],
+  'network-usage': ['bytes_received', 'bytes_sent', 'requests', 'cache_hits'],
+  'capture': ['request_id', 'path', 'format', 'width', 'height', 'size', 
+              'time', 'error'],
+  'timing': ['received', 'constructed', 'shown', 'committed', 'first_paint',
+             'prewarmed']
 };
 
 /* TODO(spolu): FixMe Chrome 39 */
@@ -109,8 +117,11 @@ var webview = function(spec, my) {
   var api_getProcessId;                /* api_getProcessId(); */
   var api_getZoom;                     /* api_getZoom(); */
   var api_setZoom;                     /* api_setZoom(zoom_factor); */
+  var api_setPriority;                 /* api_setPriority(priority_class); */
   var api_find;                        /* api_find(request_id, search_text, options); */
   var api_stopFinding;                 /* api_stopFinding(action); */
+  var api_capture;                     /* api_capture(request_id, options); */
+  var api_releaseCapture;              /* api_releaseCapture(path); */
   var api_insertCSS;                   /* api_insertCSS(css); */
   var api_executeScript;               /* api_executeScript(script); */
   var api_openDevTools;                /* api_openDevTools(); */
@@ -268,20 +279,29 @@ var webview = function(spec, my) {
 
   // ### create_guest
   //
-  // Triggers the creation of the guest
+  // Triggers the creation of the guest. The guest is created asynchronously
+  // and the callback is called with its instance id as soon as one is
+  // available (generally synchronously), or with 0 if the browser refused
+  // to reserve one (the next navigation attempts the creation again).
   create_guest = function() {
     var params = {};
 
-    var instance_id = WebViewNatives.CreateGuest(params);
-
-    /* We register the event handler for events coming from the WebViewGuest. */
-    WebViewNatives.SetEventHandler(instance_id, event_handler);
+    WebViewNatives.CreateGuest(params, function(instance_id) {
+      if(!instance_id) {
+        window.console.error(ERROR_MSG_GUEST_CREATION_REFUSED);
+        my.before_first_navigation = true;
+        return;
+      }
+      /* We register the event handler for events coming from the */
+      /* WebViewGuest.                                            */
+      WebViewNatives.SetEventHandler(instance_id, event_handler);
 
-    if(!my.attached) {
-      WebViewNatives.DestroyGuest(instance_id);
-      return;
-    }
-    attach_window(instance_id, false);
+      if(!my.attached) {
+        WebViewNatives.DestroyGuest(instance_id);
+        return;
+      }
+      attach_window(instance_id, false);
+    });
   };
 
   // ### attr_src_parse
@@ -427,6 +447,19 @@ var webview = function(spec, my) {
     WebViewNatives.SetZoom(my.guest_instance_id, zoom_factor);
   };
 
+  // ### api_setPriority
+  //
+  // Sets the scheduling class of the network requests of this webview
+  // ```
+  // @priority_class {string} auto, foreground, normal or background
+  // ```
+  api_setPriority = function(priority_class) {
+    if(!my.guest_instance_id) {
+      return;
+    }
+    WebViewNatives.SetPriority(my.guest_instance_id, priority_class);
+  };
+
   // ### api_find
   //
   // Starts or continue a find request
@@ -469,6 +502,45 @@ var webview = function(spec, my) {
     WebViewNatives.StopFinding(my.guest_instance_id, action);
   };
 
+  // ### api_capture
+  //
+  // Captures the webview content, the result is emitted as a `capture` event
+  // ```
+  // @request_id {number} request id
+  // @options    {object} format, quality, size
+  // ```
+  api_capture = function(request_id, options) {
+    if(!my.guest_instance_id) {
+      return;
+    }
+    var opt = {};
+    opt.format = (options || {}).format || 'png';
+    if(typeof (options || {}).quality === 'number') {
+      opt.quality = options.quality;
+    }
+    if((options || {}).size) {
+      opt.size = { 
+        width: options.size.width, 
+        height: options.size.height 
+      };
+    }
+
+    WebViewNatives.Capture(my.guest_instance_id, request_id, opt);
+  };
+
+  // ### api_releaseCapture
+  //
+  // Deletes the file of a captured frame once consumed
+  // ```
+  // @path {string} the frame path from the `capture` event
+  // ```
+  api_releaseCapture = function(path) {
+    if(!my.guest_instance_id || typeof path !== 'string') {
+      return;
+    }
+    WebViewNatives.ReleaseCapture(my.guest_instance_id, path);
+  };
+
   // ### api_insertCSS
   //
   // Insert CSS in the webview
@@ -816,8 +888,11 @@ var webview = function(spec, my) {
   that.api_getProcessId = api_getProcessId;
   that.api_getZoom = api_getZoom;
   that.api_setZoom = api_setZoom;
+  that.api_setPriority = api_setPriority;
   that.api_find = api_find;
   that.api_stopFinding = api_stopFinding;
+  that.api_capture = api_capture;
+  that.api_releaseCapture = api_releaseCapture;
   that.api_insertCSS = api_insertCSS;
   that.api_executeScript = api_executeScript;
   that.api_openDevTools = api_openDevTools;
@@ -927,8 +1002,11 @@ function registerWebViewElement() {
     'getProcessId',
     'getZoom',
     'setZoom',
+    'setPriority',
     'find',
     'stopFinding',
+    'capture',
+    'releaseCapture',
     'insertCSS',
     'executeScript',
     'openDevTools',
@@ -15,12 +15,54 @@
 
 #include "src/renderer/extensions/script_context.h"
 #include "src/common/messages.h"
+#include "src/common/web_view_event.h"
 #include "src/renderer/render_frame_observer.h"
 
 using namespace content;
 
 namespace extensions {
 
+namespace {
+
+void
+SetString(
+    v8::Isolate* isolate,
+    v8::Handle<v8::Object> object,
+    const char* key,
+    const std::string& value)
+{
+  object->Set(v8::String::NewFromUtf8(isolate, key),
+              v8::String::NewFromUtf8(isolate, value.c_str(),
+                                      v8::String::kNormalString,
+                                      value.size()));
+}
+
+void
+SetString16(
+    v8::Isolate* isolate,
+    v8::Handle<v8::Object> object,
+    const char* key,
+    const base::string16& value)
+{
+  object->Set(v8::String::NewFromUtf8(isolate, key),
+              v8::String::NewFromTwoByte(
+                  isolate, reinterpret_cast<const uint16_t*>(value.data()),
+                  v8::String::kNormalString, value.size()));
+}
+
+void
+SetInteger(
+    v8::Isolate* isolate,
+    v8::Handle<v8::Object> object,
+    const char* key,
+    int value)
+{
+  object->Set(v8::String::NewFromUtf8(isolate, key),
+              v8::Integer::New(isolate, value));
+}
+
+}
+
 WebViewBindings::WebViewBindings(
     ScriptContext* context)
   : ObjectBackedNativeHandler(context) 
@@ -52,12 +94,21 @@ WebViewBindings::WebViewBindings(
   RouteFunction("SetZoom",
       base::Bind(&WebViewBindings::SetZoom,
                  base::Unretained(this)));
+  RouteFunction("SetPriority",
+      base::Bind(&WebViewBindings::SetPriority,
+                 base::Unretained(this)));
   RouteFunction("Find",
       base::Bind(&WebViewBindings::Find,
                  base::Unretained(this)));
   RouteFunction("StopFinding",
       base::Bind(&WebViewBindings::StopFinding,
                  base::Unretained(this)));
+  RouteFunction("Capture",
+      base::Bind(&WebViewBindings::Capture,
+                 base::Unretained(this)));
+  RouteFunction("ReleaseCapture",
+      base::Bind(&WebViewBindings::ReleaseCapture,
+                 base::Unretained(this)));
   RouteFunction("InsertCSS",
       base::Bind(&WebViewBindings::InsertCSS,
                  base::Unretained(this)));
@@ -94,34 +145,136 @@ WebViewBindings::~WebViewBindings()
 
 bool 
 WebViewBindings::AttemptEmitEvent(
-    int guest_instance_id,
-    const std::string type,
-    const base::DictionaryValue& event)
+    const thrust_shell::WebViewEvent& event,
+    const base::ListValue& params)
 {
-  if(guest_handlers_.find(guest_instance_id) != guest_handlers_.end()) {
-    v8::HandleScope handle_scope(context()->isolate());
+  if(guest_handlers_.find(event.guest_instance_id) == guest_handlers_.end()) {
+    return false;
+  }
+
+  v8::Isolate* isolate = context()->isolate();
+  v8::HandleScope handle_scope(isolate);
+  v8::Context::Scope context_scope(context()->v8_context());
+
+  v8::Handle<v8::Value> event_arg;
+  switch(event.kind) {
+    case thrust_shell::WebViewEvent::KIND_CONSOLE: {
+      v8::Local<v8::Object> object = v8::Object::New(isolate);
+      SetInteger(isolate, object, "level", event.level);
+      SetString16(isolate, object, "message", event.message);
+      SetInteger(isolate, object, "line", event.line);
+      SetString16(isolate, object, "source_id", event.source_id);
+      event_arg = object;
+      break;
+    }
+    case thrust_shell::WebViewEvent::KIND_REDIRECT: {
+      v8::Local<v8::Object> object = v8::Object::New(isolate);
+      SetString(isolate, object, "current_url", event.current_url.spec());
+      SetString(isolate, object, "new_url", event.new_url.spec());
+      object->Set(v8::String::NewFromUtf8(isolate, "is_top_level"),
+                  v8::Boolean::New(isolate, event.is_top_level));
+      event_arg = object;
+      break;
+    }
+    case thrust_shell::WebViewEvent::KIND_SIZE_CHANGED: {
+      v8::Local<v8::Object> object = v8::Object::New(isolate);
+      SetInteger(isolate, object, "old_width", event.old_size.width());
+      SetInteger(isolate, object, "old_height", event.old_size.height());
+      SetInteger(isolate, object, "new_width", event.new_size.width());
+      SetInteger(isolate, object, "new_height", event.new_size.height());
+      event_arg = object;
+      break;
+    }
+    case thrust_shell::WebViewEvent::KIND_GENERIC: {
+      const base::DictionaryValue* dictionary = NULL;
+      if(!params.GetDictionary(event.params_index, &dictionary)) {
+        return false;
+      }
+      scoped_ptr<V8ValueConverter> converter(V8ValueConverter::create());
+      event_arg = converter->ToV8Value(dictionary, context()->v8_context());
+      break;
+    }
+  }
 
-    v8::Local<v8::String> type_arg = 
-      v8::String::NewFromUtf8(context()->isolate(), type.c_str());
-    scoped_ptr<V8ValueConverter> converter(V8ValueConverter::create());
-    v8::Handle<v8::Value> event_arg = converter->ToV8Value(&event, context()->v8_context());
+  v8::Local<v8::String> type_arg = 
+    v8::String::NewFromUtf8(isolate, event.type.c_str());
+  v8::Local<v8::Function> handler = 
+          v8::Local<v8::Function>::New(isolate,
+                                       guest_handlers_[event.guest_instance_id]);
 
-    v8::Local<v8::Function> handler = 
+  v8::Local<v8::Value> argv[2] = { type_arg,
+                                   event_arg };
+  context()->CallFunction(handler, 2, argv);
+  return true;
+}
+
+void
+WebViewBindings::CreatePendingGuests()
+{
+  while(!pending_guests_.empty()) {
+    int guest_instance_id = render_frame_observer_->TakeWebViewInstanceID();
+    if(!guest_instance_id) {
+      return;
+    }
+    PendingGuest pending = pending_guests_.front();
+    pending_guests_.pop_front();
+
+    v8::HandleScope handle_scope(context()->isolate());
+    v8::Local<v8::Function> callback = 
             v8::Local<v8::Function>::New(context()->isolate(),
-                                         guest_handlers_[guest_instance_id]);
+                                         pending.callback);
+    CreateGuestWithInstanceID(guest_instance_id, *pending.params, callback);
+  }
+}
 
-    v8::Local<v8::Value> argv[2] = { type_arg,
-                                     event_arg };
-    context()->CallFunction(handler, 2, argv);
+void
+WebViewBindings::FailPendingGuests()
+{
+  v8::HandleScope handle_scope(context()->isolate());
+  /* Callbacks are moved out first as they may request new creations. */
+  std::deque<PendingGuest> pending_guests;
+  pending_guests.swap(pending_guests_);
+  while(!pending_guests.empty()) {
+    PendingGuest pending = pending_guests.front();
+    pending_guests.pop_front();
+    LOG(WARNING) << "WEB_VIEW_BINDINGS: CreateGuest failed";
+
+    v8::Local<v8::Function> callback = 
+            v8::Local<v8::Function>::New(context()->isolate(),
+                                         pending.callback);
+    v8::Local<v8::Value> argv[1] = { 
+      v8::Integer::New(context()->isolate(), 0) 
+    };
+    context()->CallFunction(callback, 1, argv);
   }
-  return false;
+}
+
+void
+WebViewBindings::CreateGuestWithInstanceID(
+    int guest_instance_id,
+    const base::DictionaryValue& params,
+    v8::Handle<v8::Function> callback)
+{
+  LOG(INFO) << "WEB_VIEW_BINDINGS: CreateGuest " << guest_instance_id;
+
+  /* The guest gets created asynchronously, the BrowserPlugin attachment is */
+  /* delayed by the browser until the guest is ready.                       */
+  render_frame_observer_->Send(
+      new ThrustFrameHostMsg_CreateWebViewGuest(
+        render_frame_observer_->routing_id(), 
+        guest_instance_id, params));
+
+  v8::Local<v8::Value> argv[1] = { 
+    v8::Integer::New(context()->isolate(), guest_instance_id) 
+  };
+  context()->CallFunction(callback, 1, argv);
 }
 
 void 
 WebViewBindings::CreateGuest(
     const v8::FunctionCallbackInfo<v8::Value>& args) 
 {
-  if(args.Length() != 1 || !args[0]->IsObject()) {
+  if(args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsFunction()) {
     NOTREACHED();
     return;
   }
@@ -142,15 +295,23 @@ WebViewBindings::CreateGuest(
   scoped_ptr<base::DictionaryValue> params(
       static_cast<base::DictionaryValue*>(value.release()));
 
-  LOG(INFO) << "WEB_VIEW_BINDINGS: CreateGuest";
-
-  int id = 0;
-  render_frame_observer_->Send(
-      new ThrustFrameHostMsg_CreateWebViewGuest(
-        render_frame_observer_->routing_id(), 
-        *params.get(), &id));
+  v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(args[1]);
+
+  /* Instance IDs are allocated locally from the ranges reserved by the */
+  /* browser. Creations wait (in order) for the next range if none is   */
+  /* available.                                                         */
+  int guest_instance_id = pending_guests_.empty() ?
+    render_frame_observer_->TakeWebViewInstanceID() : 0;
+  if(!guest_instance_id) {
+    LOG(INFO) << "WEB_VIEW_BINDINGS: CreateGuest pending";
+    PendingGuest pending;
+    pending.params.reset(params.release());
+    pending.callback.Reset(context()->isolate(), callback);
+    pending_guests_.push_back(pending);
+    return;
+  }
 
-  args.GetReturnValue().Set(v8::Integer::New(context()->isolate(), id));
+  CreateGuestWithInstanceID(guest_instance_id, *params, callback);
 }
 
 void 
@@ -320,6 +481,26 @@ WebViewBindings::SetZoom(
         guest_instance_id, zoom_factor));
 }
 
+void 
+WebViewBindings::SetPriority(
+    const v8::FunctionCallbackInfo<v8::Value>& args) 
+{
+  if(args.Length() != 2 || !args[0]->IsNumber() || !args[1]->IsString()) {
+    NOTREACHED();
+    return;
+  }
+
+  int guest_instance_id = args[0]->NumberValue();
+  std::string priority_class(*v8::String::Utf8Value(args[1]));
+
+  LOG(INFO) << "WEB_VIEW_BINDINGS: SetPriority " << guest_instance_id << " " << priority_class;
+  
+  render_frame_observer_->Send(
+      new ThrustFrameHostMsg_WebViewGuestSetPriority(
+        render_frame_observer_->routing_id(), 
+        guest_instance_id, priority_class));
+}
+
 void 
 WebViewBindings::Find(
     const v8::FunctionCallbackInfo<v8::Value>& args) 
@@ -378,6 +559,63 @@ WebViewBindings::StopFinding(
         guest_instance_id, action));
 }
 
+void 
+WebViewBindings::Capture(
+    const v8::FunctionCallbackInfo<v8::Value>& args) 
+{
+  if(args.Length() != 3 || !args[0]->IsNumber() || 
+     !args[1]->IsNumber() || !args[2]->IsObject()) {
+    NOTREACHED();
+    return;
+  }
+
+  int guest_instance_id = args[0]->NumberValue();
+  int request_id = args[1]->NumberValue();
+  v8::Local<v8::Object> object = args[2]->ToObject();
+
+  scoped_ptr<V8ValueConverter> converter(V8ValueConverter::create());
+  scoped_ptr<base::Value> value(
+      converter->FromV8Value(object, context()->v8_context()));
+
+  if(!value) {
+    return;
+  }
+  if(!value->IsType(base::Value::TYPE_DICTIONARY)) {
+    return;
+  }
+
+  scoped_ptr<base::DictionaryValue> options(
+      static_cast<base::DictionaryValue*>(value.release()));
+
+  LOG(INFO) << "WEB_VIEW_BINDINGS: Capture " << guest_instance_id << " " 
+            << request_id;
+
+  render_frame_observer_->Send(
+      new ThrustFrameHostMsg_WebViewGuestCapture(
+        render_frame_observer_->routing_id(), 
+        guest_instance_id, request_id, *options.get()));
+}
+
+void 
+WebViewBindings::ReleaseCapture(
+    const v8::FunctionCallbackInfo<v8::Value>& args) 
+{
+  if(args.Length() != 2 || !args[0]->IsNumber() || !args[1]->IsString()) {
+    NOTREACHED();
+    return;
+  }
+
+  int guest_instance_id = args[0]->NumberValue();
+  std::string path(*v8::String::Utf8Value(args[1]));
+
+  LOG(INFO) << "WEB_VIEW_BINDINGS: ReleaseCapture " << guest_instance_id;
+  
+  render_frame_observer_->Send(
+      new ThrustFrameHostMsg_WebViewGuestReleaseCapture(
+        render_frame_observer_->routing_id(), 
+        guest_instance_id, path));
+}
+
 void 
 WebViewBindings::InsertCSS(
     const v8::FunctionCallbackInfo<v8::Value>& args) 
@@ -4,12 +4,17 @@
 #ifndef THRUST_SHELL_RENDERER_EXTENSIONS_WEB_VIEW_BINDINGS_H_
 #define THRUST_SHELL_RENDERER_EXTENSIONS_WEB_VIEW_BINDINGS_H_
 
+#include <deque>
+#include <map>
+
+#include "base/memory/linked_ptr.h"
 #include "base/values.h"
 
 #include "src/renderer/extensions/object_backed_native_handler.h"
 
 namespace thrust_shell {
 class ThrustShellRenderFrameObserver;
+struct WebViewEvent;
 }
 
 namespace extensions {
@@ -24,13 +29,42 @@ class WebViewBindings : public ObjectBackedNativeHandler {
 
   // ### AttemptEmitEvent
   //
-  // Attempts to emit an event for the given guest_instance_id. The event gets
-  // emitted only if this WebViewBindings has an handler for it
-  bool AttemptEmitEvent(int guest_instance_id,
-                        const std::string type,
-                        const base::DictionaryValue& event);
+  // Attempts to emit an event for its guest_instance_id. The event gets
+  // emitted only if this WebViewBindings has an handler for it. Generic
+  // events are retrieved from the batch |params|, typed ones are converted
+  // to V8 directly.
+  bool AttemptEmitEvent(const thrust_shell::WebViewEvent& event,
+                        const base::ListValue& params);
+
+  // ### CreatePendingGuests
+  //
+  // Creates the guests that were waiting for an instance ID, as long as IDs
+  // are available
+  void CreatePendingGuests();
+
+  // ### FailPendingGuests
+  //
+  // Calls back the guests that were waiting for an instance ID with 0, once
+  // the browser refused to reserve more IDs
+  void FailPendingGuests();
 
  private:
+  typedef v8::Persistent<v8::Function, 
+                         v8::CopyablePersistentTraits<v8::Function> > 
+    CreateCallback;
+
+  struct PendingGuest {
+    linked_ptr<base::DictionaryValue> params;
+    CreateCallback                    callback;
+  };
+
+  // ### CreateGuestWithInstanceID
+  //
+  // Sends the (asynchronous) guest creation and calls back with the guest
+  // instance ID
+  void CreateGuestWithInstanceID(int guest_instance_id,
+                                 const base::DictionaryValue& params,
+                                 v8::Handle<v8::Function> callback);
 
   // ### [RouteFunction]
   //
@@ -46,8 +80,11 @@ class WebViewBindings : public ObjectBackedNativeHandler {
   void Reload(const v8::FunctionCallbackInfo<v8::Value>& args);
   void Stop(const v8::FunctionCallbackInfo<v8::Value>& args);
   void SetZoom(const v8::FunctionCallbackInfo<v8::Value>& args);
+  void SetPriority(const v8::FunctionCallbackInfo<v8::Value>& args);
   void Find(const v8::FunctionCallbackInfo<v8::Value>& args);
   void StopFinding(const v8::FunctionCallbackInfo<v8::Value>& args);
+  void Capture(const v8::FunctionCallbackInfo<v8::Value>& args);
+  void ReleaseCapture(const v8::FunctionCallbackInfo<v8::Value>& args);
   void InsertCSS(const v8::FunctionCallbackInfo<v8::Value>& args);
   void ExecuteScript(const v8::FunctionCallbackInfo<v8::Value>& args);
   void OpenDevTools(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -58,6 +95,7 @@ class WebViewBindings : public ObjectBackedNativeHandler {
 
   std::map<int, v8::Persistent<v8::Function, 
            v8::CopyablePersistentTraits<v8::Function>> >   guest_handlers_;
+  std::deque<PendingGuest>                                  pending_guests_;
   thrust_shell::ThrustShellRenderFrameObserver*             render_frame_observer_;
 };
 
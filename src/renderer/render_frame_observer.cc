@@ -19,6 +19,13 @@ using namespace content;
 
 namespace thrust_shell {
 
+namespace {
+
+/* More guest instance IDs are requested when running below this count. */
+const size_t kWebViewInstanceIDsLowWater = 4;
+
+}
+
 /******************************************************************************/
 /* STATIC API */
 /******************************************************************************/
@@ -43,7 +50,8 @@ ThrustShellRenderFrameObserver::FromRenderFrame(
 /******************************************************************************/
 ThrustShellRenderFrameObserver::ThrustShellRenderFrameObserver(
     RenderFrame* render_frame)
-    : RenderFrameObserver(render_frame) 
+    : RenderFrameObserver(render_frame),
+      web_view_ids_requested_(false)
 {
   LOG(INFO) << "RENDER FRAME CREATED " << render_frame;
   s_instances.push_back(this);
@@ -69,8 +77,10 @@ ThrustShellRenderFrameObserver::OnMessageReceived(
 {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(ThrustShellRenderFrameObserver, message)
-    IPC_MESSAGE_HANDLER(ThrustFrameMsg_WebViewEmit, 
-                        WebViewEmit)
+    IPC_MESSAGE_HANDLER(ThrustFrameMsg_WebViewEmitBatch, 
+                        WebViewEmitBatch)
+    IPC_MESSAGE_HANDLER(ThrustFrameMsg_WebViewInstanceIDsReserved, 
+                        WebViewInstanceIDsReserved)
     IPC_MESSAGE_HANDLER(ThrustFrameMsg_RemoteDispatch, 
                         RemoteDispatch)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -103,13 +113,50 @@ ThrustShellRenderFrameObserver::RemoveWebViewBindings(
 }
 
 void 
-ThrustShellRenderFrameObserver::WebViewEmit(
-    int guest_instance_id,
-    const std::string type,
-    const base::DictionaryValue& event)
+ThrustShellRenderFrameObserver::WebViewEmitBatch(
+    const std::vector<WebViewEvent>& events,
+    const base::ListValue& params)
+{
+  for(size_t e = 0; e < events.size(); ++e) {
+    for(size_t i = 0; i < web_view_bindings_.size(); ++i) {
+      web_view_bindings_[i]->AttemptEmitEvent(events[e], params);
+    }
+  }
+}
+
+int
+ThrustShellRenderFrameObserver::TakeWebViewInstanceID()
 {
+  int guest_instance_id = 0;
+  if(!web_view_instance_ids_.empty()) {
+    guest_instance_id = web_view_instance_ids_.front();
+    web_view_instance_ids_.pop_front();
+  }
+  if(web_view_instance_ids_.size() < kWebViewInstanceIDsLowWater &&
+     !web_view_ids_requested_) {
+    web_view_ids_requested_ = true;
+    Send(new ThrustFrameHostMsg_WebViewReserveInstanceIDs(routing_id()));
+  }
+  return guest_instance_id;
+}
+
+void
+ThrustShellRenderFrameObserver::WebViewInstanceIDsReserved(
+    int first_instance_id,
+    int count)
+{
+  for(int i = 0; i < count; ++i) {
+    web_view_instance_ids_.push_back(first_instance_id + i);
+  }
+  web_view_ids_requested_ = false;
+
+  /* Bindings may be waiting for IDs to create their guests, which fail if */
+  /* the browser refused to reserve more IDs.                             */
   for(size_t i = 0; i < web_view_bindings_.size(); ++i) {
-    web_view_bindings_[i]->AttemptEmitEvent(guest_instance_id, type, event);
+    if(count > 0)
+      web_view_bindings_[i]->CreatePendingGuests();
+    else
+      web_view_bindings_[i]->FailPendingGuests();
   }
 }
 
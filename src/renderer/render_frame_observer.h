@@ -4,6 +4,7 @@
 #ifndef THRUST_SHELL_RENDERER_RENDER_FRAME_OBSERVER_H_
 #define THRUST_SHELL_RENDERER_RENDER_FRAME_OBSERVER_H_
 
+#include <deque>
 #include <vector>
 
 #include "base/values.h"
@@ -25,6 +26,8 @@ class RemoteBindings;
 
 namespace thrust_shell {
 
+struct WebViewEvent;
+
 class ThrustShellRenderFrameObserver : public content::RenderFrameObserver {
  public:
   explicit ThrustShellRenderFrameObserver(content::RenderFrame* render_frame);
@@ -44,9 +47,23 @@ class ThrustShellRenderFrameObserver : public content::RenderFrameObserver {
   void AddWebViewBindings(extensions::WebViewBindings* bindings);
   void RemoveWebViewBindings(extensions::WebViewBindings* bindings);
 
-  void WebViewEmit(int guest_instance_id,
-                   const std::string type,
-                   const base::DictionaryValue& event);
+  void WebViewEmitBatch(const std::vector<WebViewEvent>& events,
+                        const base::ListValue& params);
+
+  // ### TakeWebViewInstanceID
+  //
+  // Returns a guest instance ID from the ranges reserved by the browser for
+  // this frame or 0 if none is available yet (the WebViewBindings are
+  // notified once new IDs are received). New IDs are requested ahead of
+  // time when running low.
+  int TakeWebViewInstanceID();
+
+  // ### WebViewInstanceIDsReserved
+  //
+  // Adds the |count| IDs starting at |first_instance_id| to the available
+  // ones. An empty range means the request was refused.
+  void WebViewInstanceIDsReserved(int first_instance_id,
+                                  int count);
 
   /****************************************************************************/
   /* REMOTE MESSAGE HANDLING */
@@ -63,6 +80,9 @@ class ThrustShellRenderFrameObserver : public content::RenderFrameObserver {
   std::vector<extensions::WebViewBindings*>           web_view_bindings_;
   std::vector<extensions::RemoteBindings*>            remote_bindings_;
 
+  std::deque<int>                                     web_view_instance_ids_;
+  bool                                                web_view_ids_requested_;
+
   DISALLOW_COPY_AND_ASSIGN(ThrustShellRenderFrameObserver);
 };
 
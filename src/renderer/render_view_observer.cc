@@ -22,7 +22,8 @@ namespace thrust_shell {
 
 ThrustShellRenderViewObserver::ThrustShellRenderViewObserver(
     RenderView* render_view)
-    : RenderViewObserver(render_view) 
+    : RenderViewObserver(render_view),
+      regions_sent_(false)
 {
 }
 
@@ -54,6 +55,11 @@ ThrustShellRenderViewObserver::DraggableRegionsChanged(
     region.draggable = webregions[i].draggable;
     regions.push_back(region);
   }
+  if(regions_sent_ && regions == last_regions_) {
+    return;
+  }
+  last_regions_ = regions;
+  regions_sent_ = true;
   Send(new ThrustViewHostMsg_UpdateDraggableRegions(routing_id(), regions));
 }
 
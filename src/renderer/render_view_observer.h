@@ -5,8 +5,12 @@
 #ifndef THRUST_SHELL_RENDERER_RENDER_VIEW_OBSERVER_H_
 #define THRUST_SHELL_RENDERER_RENDER_VIEW_OBSERVER_H_
 
+#include <vector>
+
 #include "content/public/renderer/render_view_observer.h"
 
+#include "src/common/draggable_region.h"
+
 namespace blink {
 class WebFrame;
 }
@@ -29,6 +33,14 @@ class ThrustShellRenderViewObserver : public content::RenderViewObserver {
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
   virtual void DraggableRegionsChanged(blink::WebFrame* frame) OVERRIDE;
 
+  /****************************************************************************/
+  /* MEMBERS                                                                  */
+  /****************************************************************************/
+  /* The regions last sent to the browser, layouts that don't change them  */
+  /* (scrolling, animations outside of the regions) are not sent again.    */
+  std::vector<DraggableRegion>           last_regions_;
+  bool                                   regions_sent_;
+
   DISALLOW_COPY_AND_ASSIGN(ThrustShellRenderViewObserver);
 };
 
@@ -32,6 +32,8 @@
       'src/common/switches.h',
       'src/common/draggable_region.h',
       'src/common/draggable_region.cc',
+      'src/common/web_view_event.h',
+      'src/common/web_view_event.cc',
 
       'src/browser/resources/linux/application_info_linux.cc',
       'src/browser/browser_client.cc',
@@ -39,6 +41,12 @@
       'src/browser/browser_main_parts.cc',
       'src/browser/browser_main_parts.h',
       'src/browser/browser_main_parts_mac.mm',
+      'src/browser/util/create_timeline.h',
+      'src/browser/util/create_timeline.cc',
+      'src/browser/util/frame_capture.h',
+      'src/browser/util/frame_capture.cc',
+      'src/browser/util/icon_cache.h',
+      'src/browser/util/icon_cache.cc',
       'src/browser/util/platform_util.h',
       'src/browser/util/platform_util_aura.cc',
       'src/browser/util/platform_util_linux.cc',
@@ -55,6 +63,10 @@
       'src/browser/session/thrust_session_visitedlink_store.cc',
       'src/browser/session/thrust_session_proxy_config_service.h',
       'src/browser/session/thrust_session_proxy_config_service.cc',
+      'src/browser/session/thrust_session_web_contents_pool.h',
+      'src/browser/session/thrust_session_web_contents_pool.cc',
+      'src/browser/thrust_registry.h',
+      'src/browser/thrust_registry.cc',
       'src/browser/thrust_window.h',
       'src/browser/thrust_window.cc',
       'src/browser/thrust_window_views.cc',
@@ -85,6 +97,8 @@
       'src/browser/ui/accelerator_util.cc',
       'src/browser/ui/accelerator_util_mac.mm',
       'src/browser/ui/accelerator_util_views.cc',
+      'src/browser/ui/headless_host_aura.h',
+      'src/browser/ui/headless_host_aura.cc',
       'src/browser/ui/views/frameless_view.h',
       'src/browser/ui/views/frameless_view.cc',
       'src/browser/ui/views/win_frame_view.h',
@@ -153,12 +167,38 @@
       'src/geolocation/access_token_store.cc',
       'src/geolocation/access_token_store.h',
 
+      'src/net/app_archive.cc',
+      'src/net/app_archive.h',
+      'src/net/app_protocol_handler.cc',
+      'src/net/app_protocol_handler.h',
+      'src/net/header_rules.cc',
+      'src/net/header_rules.h',
+      'src/net/host_resolver.cc',
+      'src/net/host_resolver.h',
+      'src/net/http_server_properties.cc',
+      'src/net/http_server_properties.h',
       'src/net/net_log.cc',
       'src/net/net_log.h',
+      'src/net/net_log_ring_buffer.cc',
+      'src/net/net_log_ring_buffer.h',
+      'src/net/net_stats.cc',
+      'src/net/net_stats.h',
+      'src/net/network_usage.cc',
+      'src/net/network_usage.h',
       'src/net/network_delegate.cc',
       'src/net/network_delegate.h',
+      'src/net/parallel_download.cc',
+      'src/net/parallel_download.h',
+      'src/net/preconnector.cc',
+      'src/net/preconnector.h',
+      'src/net/proxy_resolver.cc',
+      'src/net/proxy_resolver.h',
+      'src/net/request_scheduler.cc',
+      'src/net/request_scheduler.h',
       'src/net/url_request_context_getter.cc',
       'src/net/url_request_context_getter.h',
+      'src/net/url_rule_set.cc',
+      'src/net/url_rule_set.h',
 
       'src/common/visitedlink/visitedlink_common.cc',
       'src/common/visitedlink/visitedlink_common.h',
@@ -415,6 +455,24 @@
         }],  # OS=="linux"
       ],
     },  # target <(product_name)_lib
+    {
+      # Visited link database microbenchmarks. Not part of the default build,
+      # run with `./scripts/build.py -t thrust_shell_visitedlink_perftest`.
+      'target_name': '<(project_name)_visitedlink_perftest',
+      'type': 'executable',
+      'dependencies': [
+        '<(project_name)_lib',
+      ],
+      'defines': [
+        'PERF_TEST',
+      ],
+      'sources': [
+        'src/browser/visitedlink/visitedlink_perftest.cc',
+      ],
+      'include_dirs': [
+        '.',
+      ],
+    },  # target <(project_name)_visitedlink_perftest
     {
       'target_name': '<(project_name)_js',
       'type': 'none',